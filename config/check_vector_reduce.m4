@@ -0,0 +1,50 @@
+#CHECK_VECTOR_REDUCE([action-if-found], [action-if-not-found])
+# --------------------------------------------------------
+# check if the compiler can build the vectorized local reduction
+# kernels: OpenMP SIMD loop directives (-fopenmp-simd) and, on x86,
+# target_clones for runtime ISA dispatch.  Sets VECTOR_REDUCE_CFLAGS
+# and vector_reduce_clones.
+AC_DEFUN([CHECK_VECTOR_REDUCE], [
+    AC_LANG_PUSH([C])
+    vector_reduce_save_CFLAGS="$CFLAGS"
+
+    AC_MSG_CHECKING([if $CC supports -fopenmp-simd])
+    VECTOR_REDUCE_CFLAGS="-fopenmp-simd"
+    CFLAGS="$vector_reduce_save_CFLAGS $VECTOR_REDUCE_CFLAGS -Werror"
+    AC_COMPILE_IFELSE([
+       AC_LANG_SOURCE([[
+void f(double *a, const double *b, int n);
+void f(double *a, const double *b, int n) {
+    int i;
+    _Pragma("omp simd")
+    for (i = 0; i < n; ++i) a[i] += b[i];
+}
+]])],
+       [vector_reduce_happy="yes"],
+       [vector_reduce_happy="no"
+        VECTOR_REDUCE_CFLAGS=""])
+    AC_MSG_RESULT([$vector_reduce_happy])
+
+    AC_MSG_CHECKING([if $CC supports target_clones])
+    CFLAGS="$vector_reduce_save_CFLAGS -Werror"
+    AC_LINK_IFELSE([
+       AC_LANG_SOURCE([[
+#if !defined(__x86_64__)
+#error "target_clones only used on x86_64"
+#endif
+__attribute__((target_clones("avx512f","avx2","sse4.2","default")))
+static int f(int *a, int n) {
+    int i, s = 0;
+    for (i = 0; i < n; ++i) s += a[i];
+    return s;
+}
+int main(void) { int a[4] = { 1, 2, 3, 4 }; return f(a, 4) != 10; }
+]])],
+       [vector_reduce_clones="yes"],
+       [vector_reduce_clones="no"])
+    AC_MSG_RESULT([$vector_reduce_clones])
+
+    CFLAGS="$vector_reduce_save_CFLAGS"
+    AC_LANG_POP([C])
+    AS_IF([test "$vector_reduce_happy" = "yes"], [$1], [$2])
+])
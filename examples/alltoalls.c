@@ -0,0 +1,160 @@
+#include <shmem.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define NUM_ITERS 100
+#define NUM_WARMUP 10
+#define NELEMS 256
+#define MAX_STRIDE 4
+
+static double
+wtime(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1.0e6 + tv.tv_usec;
+}
+
+static void
+alltoalls(void *dest, const void *source, ptrdiff_t dst, ptrdiff_t sst,
+          size_t elem_size, size_t nelems)
+{
+    switch (elem_size) {
+        case 1:
+            shmem_alltoallsmem(SHMEM_TEAM_WORLD, dest, source, dst, sst, nelems);
+            break;
+        case 4:
+            shmem_int32_alltoalls(SHMEM_TEAM_WORLD, dest, source, dst, sst, nelems);
+            break;
+        case 8:
+            shmem_int64_alltoalls(SHMEM_TEAM_WORLD, dest, source, dst, sst, nelems);
+            break;
+    }
+}
+
+/*
+** The same exchange with one put per element, as the library used to do it
+*/
+static void
+alltoalls_per_element(char *dest, const char *source, ptrdiff_t dst,
+                      ptrdiff_t sst, size_t elem_size, size_t nelems, int me,
+                      int npes)
+{
+    int i, pe;
+    size_t j;
+
+    for (i = 1; i <= npes; i++) {
+        pe = (me + i) % npes;
+        for (j = 0; j < nelems; j++)
+            shmem_putmem(dest + (me * nelems + j) * dst * elem_size,
+                         source + (pe * nelems + j) * sst * elem_size,
+                         elem_size, pe);
+    }
+
+    shmem_barrier_all();
+}
+
+static int
+check(const char *dest, ptrdiff_t dst, size_t elem_size, size_t nelems,
+      int me, int npes)
+{
+    int pe, errors = 0;
+    size_t j, k;
+
+    for (pe = 0; pe < npes; pe++)
+        for (j = 0; j < nelems; j++)
+            for (k = 0; k < elem_size; k++)
+                if (dest[(pe * nelems + j) * dst * elem_size + k] !=
+                    (char) (pe + me + j + k))
+                    errors++;
+
+    /* Peers start writing dest again once everybody has checked it */
+    shmem_barrier_all();
+
+    return errors;
+}
+
+int
+main(int argc, char* argv[], char *envp[])
+{
+    static const size_t elem_sizes[] = { 1, 4, 8 };
+    size_t nelems = NELEMS, e, j, k, buf_size;
+    int me, npes, pe, i, errors = 0;
+    ptrdiff_t dst, sst;
+    double start = 0, t_packed, t_elem;
+    char *source, *dest;
+
+    if (argc > 1)
+        nelems = atol(argv[1]);
+
+    shmem_init();
+    me = shmem_my_pe();
+    npes = shmem_n_pes();
+
+    buf_size = npes * nelems * MAX_STRIDE * 8;
+    source = shmem_malloc(buf_size);
+    dest = shmem_malloc(buf_size);
+    if (source == NULL || dest == NULL) {
+        printf("%d: Unable to allocate %zu byte buffers\n", me, buf_size);
+        shmem_global_exit(1);
+    }
+
+    if (me == 0) {
+        printf("Strided alltoall on %d PEs, %zu elements per PE, average of "
+               "%d iterations\n", npes, nelems, NUM_ITERS);
+        printf("%5s %4s %4s %14s %14s %8s\n", "size", "dst", "sst",
+               "packed (us)", "per-elem (us)", "speedup");
+    }
+
+    for (e = 0; e < sizeof(elem_sizes) / sizeof(elem_sizes[0]); e++) {
+        size_t elem_size = elem_sizes[e];
+
+        for (dst = 1; dst <= MAX_STRIDE; dst *= 2) {
+            for (sst = 1; sst <= MAX_STRIDE; sst *= 2) {
+                /* Element j for PE pe holds pe + me + j + byte offset */
+                for (pe = 0; pe < npes; pe++)
+                    for (j = 0; j < nelems; j++)
+                        for (k = 0; k < elem_size; k++)
+                            source[(pe * nelems + j) * sst * elem_size + k] =
+                                (char) (pe + me + j + k);
+
+                for (i = 0; i < NUM_WARMUP + NUM_ITERS; i++) {
+                    if (i == NUM_WARMUP) {
+                        shmem_barrier_all();
+                        start = wtime();
+                    }
+                    alltoalls(dest, source, dst, sst, elem_size, nelems);
+                }
+                t_packed = (wtime() - start) / NUM_ITERS;
+                errors += check(dest, dst, elem_size, nelems, me, npes);
+
+                for (i = 0; i < NUM_WARMUP + NUM_ITERS; i++) {
+                    if (i == NUM_WARMUP) {
+                        shmem_barrier_all();
+                        start = wtime();
+                    }
+                    alltoalls_per_element(dest, source, dst, sst, elem_size,
+                                          nelems, me, npes);
+                }
+                t_elem = (wtime() - start) / NUM_ITERS;
+                errors += check(dest, dst, elem_size, nelems, me, npes);
+
+                if (me == 0)
+                    printf("%5zu %4td %4td %14.2f %14.2f %7.2fx\n", elem_size,
+                           dst, sst, t_packed, t_elem, t_elem / t_packed);
+            }
+        }
+    }
+
+    if (errors)
+        printf("%d: %d bytes received incorrectly\n", me, errors);
+
+    shmem_free(dest);
+    shmem_free(source);
+    shmem_finalize();
+
+    return errors != 0;
+}
@@ -0,0 +1,71 @@
+#include <shmem.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_ELEMS 8
+#define NUM_ITERS 100
+
+int
+main(int argc, char* argv[], char *envp[])
+{
+    int me, npes, i, iter, errors = 0;
+    long *source, *target;
+    size_t nelems, total, offset;
+
+    shmem_init();
+    me = shmem_my_pe();
+    npes = shmem_n_pes();
+
+    if (npes < 4 && me == 0)
+        printf("Warning: run with at least 4 PEs to exercise the default "
+               "collect algorithm\n");
+
+    source = shmem_malloc(MAX_ELEMS * sizeof(long));
+    target = shmem_malloc(MAX_ELEMS * npes * sizeof(long));
+
+    /*
+    ** PE i contributes i % MAX_ELEMS + 1 elements, so the offsets differ on
+    ** every PE.
+    */
+    nelems = me % MAX_ELEMS + 1;
+
+    for (total = 0, i = 0; i < npes; i++)
+        total += i % MAX_ELEMS + 1;
+
+    shmem_barrier_all();
+
+    for (iter = 0; iter < NUM_ITERS; iter++) {
+        for (i = 0; i < (int) nelems; i++)
+            source[i] = (long) iter * npes + me;
+
+        shmem_long_collect(SHMEM_TEAM_WORLD, target, source, nelems);
+
+        for (offset = 0, i = 0; i < npes; i++) {
+            size_t j, n = i % MAX_ELEMS + 1;
+
+            for (j = 0; j < n; j++) {
+                if (target[offset + j] != (long) iter * npes + i) {
+                    printf("%d: iter %d, target[%zu] = %ld, expected %ld\n",
+                           me, iter, offset + j, target[offset + j],
+                           (long) iter * npes + i);
+                    ++errors;
+                }
+            }
+            offset += n;
+        }
+
+        /* target is overwritten by the next collect */
+        shmem_barrier_all();
+    }
+
+    if (me == 0 && errors == 0)
+        printf("Collected %zu elements from %d PEs %d times\n", total, npes,
+               NUM_ITERS);
+
+    shmem_free(target);
+    shmem_free(source);
+
+    shmem_finalize();
+
+    return errors != 0;
+}
@@ -0,0 +1,116 @@
+#include <shmem.h>
+#include <shmemx.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define TABLE_SIZE 1024
+#define NUM_OPS 100000
+
+static long table[TABLE_SIZE];
+
+static double
+wtime(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1.0e6 + tv.tv_usec;
+}
+
+/*
+** Add one to random entries of the tables of random PEs, as a histogram or
+** graph update kernel would, and return the time in microseconds
+*/
+static double
+update(shmem_ctx_t ctx, long nops, int me, int npes)
+{
+    unsigned int seed = me + 1;
+    double start;
+    long i;
+
+    shmem_barrier_all();
+    start = wtime();
+
+    for (i = 0; i < nops; i++) {
+        int pe = rand_r(&seed) % npes;
+        int idx = rand_r(&seed) % TABLE_SIZE;
+
+        shmem_ctx_long_atomic_add(ctx, &table[idx], 1, pe);
+    }
+
+    shmem_ctx_quiet(ctx);
+    shmem_barrier_all();
+
+    return wtime() - start;
+}
+
+static int
+check(long expected, int me)
+{
+    static long sum, total;
+    int i;
+
+    for (sum = 0, i = 0; i < TABLE_SIZE; i++) {
+        sum += table[i];
+        table[i] = 0;
+    }
+
+    shmem_long_sum_reduce(SHMEM_TEAM_WORLD, &total, &sum, 1);
+
+    if (total != expected && me == 0)
+        printf("Error: %ld updates arrived, expected %ld\n", total, expected);
+
+    return total != expected;
+}
+
+int
+main(int argc, char* argv[], char *envp[])
+{
+    int me, npes, errors = 0;
+    long nops = NUM_OPS;
+    double t_direct, t_agg;
+    shmem_ctx_t ctx;
+
+    if (argc > 1)
+        nops = atol(argv[1]);
+
+    shmem_init();
+    me = shmem_my_pe();
+    npes = shmem_n_pes();
+
+    if (me == 0 && getenv("SHMEM_AGGREGATE_SIZE") == NULL)
+        printf("Warning: set SHMEM_AGGREGATE_SIZE (e.g. to 1M) to enable "
+               "aggregation\n");
+
+    if (shmem_ctx_create(SHMEM_CTX_PRIVATE, &ctx)) {
+        printf("%d: Unable to create a context\n", me);
+        shmem_global_exit(1);
+    }
+    update(ctx, nops / 10, me, npes);
+    check(nops / 10 * npes, me);
+    t_direct = update(ctx, nops, me, npes);
+    errors += check(nops * npes, me);
+    shmem_ctx_destroy(ctx);
+
+    if (shmem_ctx_create(SHMEM_CTX_PRIVATE | SHMEMX_CTX_AGGREGATE, &ctx)) {
+        printf("%d: Unable to create an aggregating context\n", me);
+        shmem_global_exit(1);
+    }
+    update(ctx, nops / 10, me, npes);
+    check(nops / 10 * npes, me);
+    t_agg = update(ctx, nops, me, npes);
+    errors += check(nops * npes, me);
+    shmem_ctx_destroy(ctx);
+
+    if (me == 0) {
+        printf("Random 8-byte atomic adds on %d PEs, %ld per PE\n", npes, nops);
+        printf("  direct:      %12.0f updates/s per PE\n", nops / t_direct * 1.0e6);
+        printf("  aggregated:  %12.0f updates/s per PE (%.2fx)\n",
+               nops / t_agg * 1.0e6, t_direct / t_agg);
+    }
+
+    shmem_finalize();
+
+    return errors != 0;
+}
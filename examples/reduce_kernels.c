@@ -0,0 +1,142 @@
+#include <shmem.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define NUM_ITERS 20
+#define NUM_WARMUP 2
+#define COUNT (1 << 20)
+
+static double
+wtime(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1.0e6 + tv.tv_usec;
+}
+
+/*
+** One timing function per type and operation, each returning the average
+** time of a reduction of count elements in microseconds
+*/
+#define DEFINE_BENCH(TYPENAME, TYPE, OP)                                \
+static double                                                           \
+bench_##TYPENAME##_##OP(void *dest, void *source, size_t count)         \
+{                                                                       \
+    double start = 0;                                                   \
+    size_t j;                                                           \
+    int i;                                                              \
+                                                                        \
+    for (j = 0; j < count; j++)                                         \
+        ((TYPE *) source)[j] = 1;                                       \
+                                                                        \
+    for (i = 0; i < NUM_WARMUP + NUM_ITERS; i++) {                      \
+        if (i == NUM_WARMUP) {                                          \
+            shmem_barrier_all();                                        \
+            start = wtime();                                            \
+        }                                                               \
+        shmem_##TYPENAME##_##OP##_reduce(SHMEM_TEAM_WORLD, (TYPE *) dest, \
+                                         (TYPE *) source, count);       \
+    }                                                                   \
+                                                                        \
+    return (wtime() - start) / NUM_ITERS;                               \
+}
+
+#define DEFINE_BENCH_INT(TYPENAME, TYPE)                                \
+    DEFINE_BENCH(TYPENAME, TYPE, sum)                                   \
+    DEFINE_BENCH(TYPENAME, TYPE, prod)                                  \
+    DEFINE_BENCH(TYPENAME, TYPE, min)                                   \
+    DEFINE_BENCH(TYPENAME, TYPE, max)                                   \
+    DEFINE_BENCH(TYPENAME, TYPE, and)                                   \
+    DEFINE_BENCH(TYPENAME, TYPE, or)                                    \
+    DEFINE_BENCH(TYPENAME, TYPE, xor)
+
+#define DEFINE_BENCH_REAL(TYPENAME, TYPE)                               \
+    DEFINE_BENCH(TYPENAME, TYPE, sum)                                   \
+    DEFINE_BENCH(TYPENAME, TYPE, prod)                                  \
+    DEFINE_BENCH(TYPENAME, TYPE, min)                                   \
+    DEFINE_BENCH(TYPENAME, TYPE, max)
+
+DEFINE_BENCH_INT(short, short)
+DEFINE_BENCH_INT(int, int)
+DEFINE_BENCH_INT(long, long)
+DEFINE_BENCH_INT(longlong, long long)
+DEFINE_BENCH_REAL(float, float)
+DEFINE_BENCH_REAL(double, double)
+
+struct kernel {
+    const char *type;
+    const char *op;
+    size_t size;
+    double (*bench)(void *dest, void *source, size_t count);
+};
+
+#define KERNEL(TYPENAME, TYPE, OP) \
+    { #TYPENAME, #OP, sizeof(TYPE), bench_##TYPENAME##_##OP }
+
+#define KERNELS_INT(TYPENAME, TYPE)                                     \
+    KERNEL(TYPENAME, TYPE, sum), KERNEL(TYPENAME, TYPE, prod),          \
+    KERNEL(TYPENAME, TYPE, min), KERNEL(TYPENAME, TYPE, max),           \
+    KERNEL(TYPENAME, TYPE, and), KERNEL(TYPENAME, TYPE, or),            \
+    KERNEL(TYPENAME, TYPE, xor)
+
+#define KERNELS_REAL(TYPENAME, TYPE)                                    \
+    KERNEL(TYPENAME, TYPE, sum), KERNEL(TYPENAME, TYPE, prod),          \
+    KERNEL(TYPENAME, TYPE, min), KERNEL(TYPENAME, TYPE, max)
+
+static const struct kernel kernels[] = {
+    KERNELS_INT(short, short),
+    KERNELS_INT(int, int),
+    KERNELS_INT(long, long),
+    KERNELS_INT(longlong, long long),
+    KERNELS_REAL(float, float),
+    KERNELS_REAL(double, double)
+};
+
+int
+main(int argc, char* argv[], char *envp[])
+{
+    size_t count = COUNT, k;
+    int me, npes;
+    double t;
+    void *source, *dest;
+
+    if (argc > 1)
+        count = atol(argv[1]);
+
+    shmem_init();
+    me = shmem_my_pe();
+    npes = shmem_n_pes();
+
+    source = shmem_malloc(count * sizeof(long long));
+    dest = shmem_malloc(count * sizeof(long long));
+    if (source == NULL || dest == NULL) {
+        printf("%d: Unable to allocate %zu element buffers\n", me, count);
+        shmem_global_exit(1);
+    }
+
+    if (me == 0) {
+        printf("Reductions of %zu elements on %d PEs, average of %d "
+               "iterations\n", count, npes, NUM_ITERS);
+        printf("%-10s %-5s %12s %10s\n", "type", "op", "time (us)", "GB/s");
+    }
+
+    /*
+    ** Each PE combines a contribution from every other PE into its result,
+    ** so (npes - 1) * count elements pass through the local kernels
+    */
+    for (k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        t = kernels[k].bench(dest, source, count);
+
+        if (me == 0)
+            printf("%-10s %-5s %12.2f %10.2f\n", kernels[k].type, kernels[k].op,
+                   t, (npes - 1) * count * kernels[k].size / t / 1.0e3);
+    }
+
+    shmem_free(dest);
+    shmem_free(source);
+    shmem_finalize();
+
+    return 0;
+}
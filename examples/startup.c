@@ -0,0 +1,84 @@
+#include <shmem.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define NUM_NEIGHBORS 2
+
+static long flag;
+
+static double
+wtime(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1.0e6 + tv.tv_usec;
+}
+
+/*
+** Return the slowest PE's time, which is what a job waits for
+*/
+static double
+slowest(double t)
+{
+    static double local, result;
+
+    local = t;
+    shmem_double_max_reduce(SHMEM_TEAM_WORLD, &result, &local, 1);
+
+    return result;
+}
+
+int
+main(int argc, char* argv[], char *envp[])
+{
+    int me, npes, i;
+    double start, t_init, t_near, t_all;
+
+    start = wtime();
+    shmem_init();
+    t_init = wtime() - start;
+
+    me = shmem_my_pe();
+    npes = shmem_n_pes();
+
+    /*
+    ** First contact with the ring neighbors, as a halo exchange would make.
+    ** In lazy mode this is where their addresses are resolved.
+    */
+    shmem_barrier_all();
+    start = wtime();
+    for (i = 1; i <= NUM_NEIGHBORS && i < npes; i++) {
+        shmem_long_p(&flag, 1, (me + i) % npes);
+        shmem_long_p(&flag, 1, (me - i + npes) % npes);
+    }
+    shmem_quiet();
+    t_near = wtime() - start;
+
+    /*
+    ** First contact with every other PE
+    */
+    shmem_barrier_all();
+    start = wtime();
+    for (i = 1; i < npes; i++)
+        shmem_long_p(&flag, 1, (me + i) % npes);
+    shmem_quiet();
+    t_all = wtime() - start;
+
+    t_init = slowest(t_init);
+    t_near = slowest(t_near);
+    t_all = slowest(t_all);
+
+    if (me == 0) {
+        printf("Startup on %d PEs, %s address vector\n", npes,
+               getenv("SHMEM_OFI_AV_LAZY") != NULL ? "lazy" : "eager");
+        printf("  shmem_init:             %10.2f us\n", t_init);
+        printf("  first put to neighbors: %10.2f us\n", t_near);
+        printf("  first put to all PEs:   %10.2f us\n", t_all);
+    }
+
+    shmem_finalize();
+
+    return 0;
+}
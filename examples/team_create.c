@@ -0,0 +1,78 @@
+#include <shmem.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define NUM_ITERS 1000
+#define NUM_WARMUP 10
+
+static double
+wtime(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1.0e6 + tv.tv_usec;
+}
+
+int
+main(int argc, char* argv[], char *envp[])
+{
+    int me, npes, i, xrange;
+    double start = 0, t_strided, t_2d;
+    shmem_team_t team, xteam, yteam;
+
+    shmem_init();
+    me = shmem_my_pe();
+    npes = shmem_n_pes();
+
+    /*
+    ** Rows of a near-square PE grid, as a solver that builds row and
+    ** column teams for each phase would use
+    */
+    for (xrange = 1; xrange * xrange < npes; xrange++)
+        ;
+
+    /*
+    ** Split the even PEs out of the world team and destroy the team again
+    */
+    for (i = 0; i < NUM_WARMUP + NUM_ITERS; i++) {
+        if (i == NUM_WARMUP) {
+            shmem_barrier_all();
+            start = wtime();
+        }
+
+        shmem_team_split_strided(SHMEM_TEAM_WORLD, 0, 2, (npes + 1) / 2, NULL,
+                                 0, &team);
+        if (team != SHMEM_TEAM_INVALID)
+            shmem_team_destroy(team);
+    }
+    t_strided = (wtime() - start) / NUM_ITERS;
+
+    /*
+    ** Split the world team into row and column teams
+    */
+    for (i = 0; i < NUM_WARMUP + NUM_ITERS; i++) {
+        if (i == NUM_WARMUP) {
+            shmem_barrier_all();
+            start = wtime();
+        }
+
+        shmem_team_split_2d(SHMEM_TEAM_WORLD, xrange, NULL, 0, &xteam, NULL,
+                            0, &yteam);
+        shmem_team_destroy(xteam);
+        shmem_team_destroy(yteam);
+    }
+    t_2d = (wtime() - start) / NUM_ITERS;
+
+    if (me == 0) {
+        printf("Team create/destroy on %d PEs, average of %d iterations\n",
+               npes, NUM_ITERS);
+        printf("  split_strided:          %10.2f us\n", t_strided);
+        printf("  split_2d (x range %3d): %10.2f us\n", xrange, t_2d);
+    }
+
+    shmem_finalize();
+
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include <shmem.h>
+#include <shmemx.h>
+#include <stdio.h>
+
+#define NUM_COLORS 3
+#define NUM_ITERS 100
+
+int
+main(int argc, char* argv[], char *envp[])
+{
+    int me, npes, pe, iter, errors = 0;
+    int color, size, rank, first;
+    shmem_team_t team;
+
+    shmem_init();
+    me = shmem_my_pe();
+    npes = shmem_n_pes();
+
+    /*
+    ** Split the world team by a color that changes every iteration, with
+    ** keys that reverse the world order, and destroy the teams again.  There
+    ** is no barrier between the splits.
+    */
+    for (iter = 0; iter < NUM_ITERS; iter++) {
+        color = (me + iter) % NUM_COLORS;
+
+        shmemx_team_split_color(SHMEM_TEAM_WORLD, color, npes - me, NULL, 0,
+                                &team);
+
+        /* Expected size, rank, and first member of this PE's team */
+        for (size = 0, rank = 0, first = -1, pe = npes - 1; pe >= 0; pe--) {
+            if ((pe + iter) % NUM_COLORS != color) continue;
+            if (first < 0) first = pe;
+            if (pe > me) rank++;
+            size++;
+        }
+
+        if (team == SHMEM_TEAM_INVALID) {
+            printf("%d: iter %d, no team for color %d\n", me, iter, color);
+            ++errors;
+            continue;
+        }
+
+        if (shmem_team_n_pes(team) != size || shmem_team_my_pe(team) != rank ||
+            shmem_team_translate_pe(team, 0, SHMEM_TEAM_WORLD) != first) {
+            printf("%d: iter %d, color %d: size %d rank %d first %d, expected "
+                   "%d %d %d\n", me, iter, color, shmem_team_n_pes(team),
+                   shmem_team_my_pe(team),
+                   shmem_team_translate_pe(team, 0, SHMEM_TEAM_WORLD), size,
+                   rank, first);
+            ++errors;
+        }
+
+        shmem_team_destroy(team);
+    }
+
+    if (me == 0 && errors == 0)
+        printf("Split %d PEs by %d colors %d times\n", npes, NUM_COLORS,
+               NUM_ITERS);
+
+    shmem_finalize();
+
+    return errors != 0;
+}
@@ -22,6 +22,10 @@ typedef struct {
     uint64_t target;
 } shmemx_pcntr_t;
 
+/* Non-blocking collective request */
+typedef struct shmemx_impl_req_t { int dummy; } * shmemx_req_h;
+#define SHMEMX_REQ_NULL ((shmemx_req_h) 0)
+
 #define SHMEMX_EXTERNAL_HEAP_ZE 0
 #define SHMEMX_EXTERNAL_HEAP_CUDA 1
 
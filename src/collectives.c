@@ -27,6 +27,8 @@ coll_type_t shmem_internal_bcast_type = AUTO;
 coll_type_t shmem_internal_reduce_type = AUTO;
 coll_type_t shmem_internal_collect_type = AUTO;
 coll_type_t shmem_internal_fcollect_type = AUTO;
+coll_type_t shmem_internal_alltoall_type = AUTO;
+coll_type_t shmem_internal_scan_type = AUTO;
 long *shmem_internal_barrier_all_psync;
 long *shmem_internal_sync_all_psync;
 
@@ -35,13 +37,72 @@ char *coll_type_str[] = { "AUTO",
                           "TREE",
                           "DISSEM",
                           "RING",
-                          "RECDBL" };
+                          "RECDBL",
+                          "HIER",
+                          "PAIRWISE",
+                          "BRUCK",
+                          "THROTTLE",
+                          "PIPELINE",
+                          "SCATTER",
+                          "RABENSEIFNER" };
 
 static int *full_tree_children;
 static int full_tree_num_children;
 static int full_tree_parent;
 static long tree_radix = -1;
 
+/* Node-aware synchronization.  node_map holds, for every PE, the lowest PE
+ * that shares memory with it, which serves as a node identifier.  The
+ * per-active-set layout is computed on first use and cached; entries are
+ * never removed, so lookups can be performed without holding the lock. */
+struct hier_sync_info_t {
+    int PE_start;
+    int PE_stride;
+    int PE_size;
+    int leader;            /* Node leader for this PE, within the active set */
+    int num_local;         /* Active set members on this node, incl. leader */
+    int *local_pes;        /* Active set members on this node, excl. leader */
+    int num_leaders;       /* Number of nodes spanned by the active set */
+    int leader_idx;        /* Index of this PE in leaders, or -1 */
+    int *leaders;
+    struct hier_sync_info_t *next;
+};
+
+/* Last int slot in the barrier pSync, used for the intra-node phase.  The
+ * inter-node dissemination phase uses at most the preceding 31 slots. */
+#define HIER_SYNC_LOCAL_SLOT (sizeof(int) * 8 - 1)
+
+/* Second to last int slot in the barrier pSync, used by the pairwise
+ * alltoall to count received blocks and by the scratch based alltoalls to
+ * count clear-to-send signals.  It is not touched by any of the barrier
+ * algorithms for active sets of up to 2^30 PEs. */
+#define ALLTOALL_COUNTER_SLOT (sizeof(int) * 8 - 2)
+
+/* Symmetric scratch space for the Bruck alltoall and packed alltoalls: a
+ * header with one ready slot per Bruck step and a data arrival counter,
+ * followed by the receive buffer.  The buffer is shared by all active sets,
+ * so a PE may only be written to once it has entered the collective the
+ * data belongs to; see shmem_internal_alltoall_scratch_cts. */
+#define ALLTOALL_SCRATCH_STEPS (sizeof(int) * 8)
+#define ALLTOALL_SCRATCH_HDR   (sizeof(long) * (ALLTOALL_SCRATCH_STEPS + 1))
+
+static void *alltoall_scratch = NULL;
+static size_t alltoall_scratch_size = 0;
+
+static int *node_map = NULL;
+static struct hier_sync_info_t *hier_sync_cache = NULL;
+#ifdef ENABLE_THREADS
+static shmem_internal_mutex_t hier_sync_lock;
+#endif
+
+/* Outstanding non-blocking collectives, in the order they were started */
+static shmem_internal_coll_req_t *coll_reqs_head = NULL;
+static shmem_internal_coll_req_t *coll_reqs_tail = NULL;
+static int coll_reqs_progressing = 0;
+#ifdef ENABLE_THREADS
+static shmem_internal_mutex_t coll_reqs_lock;
+#endif
+
 
 static int
 shmem_internal_build_kary_tree(int radix, int PE_start, int stride,
@@ -52,19 +113,20 @@ shmem_internal_build_kary_tree(int radix, int PE_start, int stride,
 
     /* my_id is the index in a theoretical 0...N-1 array of
        participating tasks. where the 0th entry is the root */
-    int my_id = (((shmem_internal_my_pe - PE_start) / stride) + PE_size - PE_root) % PE_size;
+    int my_id = (shmem_internal_as_rank(PE_start, stride, shmem_internal_my_pe) +
+                 PE_size - PE_root) % PE_size;
 
     /* We shift PE_root to index 0, resulting in a PE active set layout of (for
        example radix 2): 0 [ 1 2 ] [ 3 4 ] [ 5 6 ] ...  The first group [ 1 2 ]
        are chilren of 0, second group [ 3 4 ] are chilren of 1, and so on */
-    *parent = PE_start + (((my_id - 1) / radix + PE_root) % PE_size) * stride;
+    *parent = shmem_internal_as_pe(PE_start, stride, ((my_id - 1) / radix + PE_root) % PE_size);
 
     *num_children = 0;
     for (i = 1 ; i <= radix ; ++i) {
         int tmp = radix * my_id + i;
         if (tmp < PE_size) {
             const int child_idx = (PE_root + tmp) % PE_size;
-            children[(*num_children)++] = PE_start + child_idx * stride;
+            children[(*num_children)++] = shmem_internal_as_pe(PE_start, stride, child_idx);
         }
     }
 
@@ -92,18 +154,202 @@ shmem_internal_build_kary_tree(int radix, int PE_start, int stride,
 }
 
 
+/* Gather the node identifier of every PE.  This is a one-time, job-wide
+ * exchange performed during initialization when the hierarchical barrier is
+ * selected. */
+static int
+shmem_internal_hier_sync_init(void)
+{
+    int pe, i, my_node = shmem_internal_my_pe;
+    int *node_map_sym;
+    long *pSync;
+
+    SHMEM_MUTEX_INIT(hier_sync_lock);
+
+    if (shmem_internal_get_shr_rank(shmem_internal_my_pe) >= 0) {
+        for (pe = 0; pe < shmem_internal_num_pes; pe++) {
+            if (shmem_internal_get_shr_rank(pe) >= 0) {
+                my_node = pe;
+                break;
+            }
+        }
+    }
+
+    node_map = malloc(sizeof(int) * shmem_internal_num_pes);
+    if (NULL == node_map) return -1;
+
+    if (shmem_internal_num_pes == 1) {
+        node_map[0] = my_node;
+        return 0;
+    }
+
+    node_map_sym = shmem_internal_shmalloc(sizeof(int) * shmem_internal_num_pes);
+    if (NULL == node_map_sym) return -1;
+
+    pSync = shmem_internal_shmalloc(sizeof(long) * SHMEM_COLLECT_SYNC_SIZE);
+    if (NULL == pSync) return -1;
+
+    for (i = 0; i < SHMEM_COLLECT_SYNC_SIZE; i++)
+        pSync[i] = SHMEM_SYNC_VALUE;
+
+    /* Ensure all pSyncs are initialized before they can be targeted */
+    shmem_runtime_barrier();
+
+    shmem_internal_fcollect_linear(SHMEM_CTX_DEFAULT, node_map_sym, &my_node, sizeof(int), 0, 1,
+                                   shmem_internal_num_pes, pSync);
+    memcpy(node_map, node_map_sym, sizeof(int) * shmem_internal_num_pes);
+
+    shmem_internal_quiet(SHMEM_CTX_DEFAULT);
+    shmem_runtime_barrier();
+
+    shmem_internal_free(pSync);
+    shmem_internal_free(node_map_sym);
+
+    return 0;
+}
+
+
+static struct hier_sync_info_t *
+shmem_internal_hier_sync_lookup(int PE_start, int PE_stride, int PE_size)
+{
+    struct hier_sync_info_t *info;
+
+    /* Layouts of teams with arbitrary membership live with the team's
+     * translation table, since table indices are reused */
+    if (SHMEM_INTERNAL_STRIDE_IS_MAPPED(PE_stride))
+        return __atomic_load_n((struct hier_sync_info_t **)
+                               &SHMEM_INTERNAL_STRIDE_MAP(PE_stride)->hier_sync,
+                               __ATOMIC_ACQUIRE);
+
+    for (info = __atomic_load_n(&hier_sync_cache, __ATOMIC_ACQUIRE);
+         info != NULL; info = info->next) {
+        if (info->PE_start == PE_start && info->PE_stride == PE_stride &&
+            info->PE_size == PE_size)
+            return info;
+    }
+
+    return NULL;
+}
+
+
+static struct hier_sync_info_t *
+shmem_internal_hier_sync_info(int PE_start, int PE_stride, int PE_size)
+{
+    struct hier_sync_info_t *info;
+    char *seen;
+    int i, pe, nlocal, nleaders;
+    const int my_node = node_map[shmem_internal_my_pe];
+
+    info = shmem_internal_hier_sync_lookup(PE_start, PE_stride, PE_size);
+    if (info != NULL) return info;
+
+    SHMEM_MUTEX_LOCK(hier_sync_lock);
+
+    /* Another thread may have added this active set while we waited */
+    info = shmem_internal_hier_sync_lookup(PE_start, PE_stride, PE_size);
+    if (info != NULL) {
+        SHMEM_MUTEX_UNLOCK(hier_sync_lock);
+        return info;
+    }
+
+    info = malloc(sizeof(struct hier_sync_info_t));
+    seen = calloc(shmem_internal_num_pes, sizeof(char));
+    if (NULL == info || NULL == seen)
+        RAISE_ERROR_STR("Out of memory allocating hierarchical sync info");
+
+    info->PE_start = PE_start;
+    info->PE_stride = PE_stride;
+    info->PE_size = PE_size;
+    info->leader = -1;
+    info->leader_idx = -1;
+    info->num_local = 0;
+    info->num_leaders = 0;
+
+    /* The first active set member seen on each node is its leader */
+    for (i = 0; i < PE_size; i++) {
+        pe = shmem_internal_as_pe(PE_start, PE_stride, i);
+        const int node = node_map[pe];
+
+        if (node == my_node) {
+            if (info->leader < 0) info->leader = pe;
+            info->num_local++;
+        }
+        if (!seen[node]) {
+            seen[node] = 1;
+            if (pe == shmem_internal_my_pe) info->leader_idx = info->num_leaders;
+            info->num_leaders++;
+        }
+    }
+
+    info->local_pes = malloc(sizeof(int) * info->num_local);
+    info->leaders = malloc(sizeof(int) * info->num_leaders);
+    if (NULL == info->local_pes || NULL == info->leaders)
+        RAISE_ERROR_STR("Out of memory allocating hierarchical sync info");
+
+    memset(seen, 0, shmem_internal_num_pes);
+
+    for (i = 0, nlocal = 0, nleaders = 0; i < PE_size; i++) {
+        pe = shmem_internal_as_pe(PE_start, PE_stride, i);
+        const int node = node_map[pe];
+
+        if (node == my_node && pe != info->leader)
+            info->local_pes[nlocal++] = pe;
+        if (!seen[node]) {
+            seen[node] = 1;
+            info->leaders[nleaders++] = pe;
+        }
+    }
+
+    free(seen);
+
+    if (SHMEM_INTERNAL_STRIDE_IS_MAPPED(PE_stride)) {
+        info->next = NULL;
+        __atomic_store_n((struct hier_sync_info_t **)
+                         &SHMEM_INTERNAL_STRIDE_MAP(PE_stride)->hier_sync,
+                         info, __ATOMIC_RELEASE);
+    } else {
+        info->next = hier_sync_cache;
+        __atomic_store_n(&hier_sync_cache, info, __ATOMIC_RELEASE);
+    }
+
+    SHMEM_MUTEX_UNLOCK(hier_sync_lock);
+
+    return info;
+}
+
+
+void
+shmem_internal_hier_sync_free(void *hier_sync)
+{
+    struct hier_sync_info_t *info = (struct hier_sync_info_t *) hier_sync;
+
+    if (NULL == info) return;
+
+    free(info->local_pes);
+    free(info->leaders);
+    free(info);
+}
+
+
 /* Circulator iterator for PE active sets */
 static inline int
 shmem_internal_circular_iter_next(int curr, int PE_start, int PE_stride, int PE_size)
 {
-    const int last = PE_start + (PE_stride * (PE_size - 1));
-    int next;
+    int rank;
+
+    if (!SHMEM_INTERNAL_STRIDE_IS_MAPPED(PE_stride)) {
+        const int last = PE_start + (PE_stride * (PE_size - 1));
+        int next;
+
+        next = curr + PE_stride;
+        if (next > last)
+            next = PE_start;
 
-    next = curr + PE_stride;
-    if (next > last)
-        next = PE_start;
+        return next;
+    }
 
-    return next;
+    rank = shmem_internal_as_rank(PE_start, PE_stride, curr);
+    return shmem_internal_as_pe(PE_start, PE_stride, (rank + 1) % PE_size);
 }
 
 
@@ -117,6 +363,8 @@ shmem_internal_collectives_init(void)
 
     tree_radix = shmem_internal_params.COLL_RADIX;
 
+    SHMEM_MUTEX_INIT(coll_reqs_lock);
+
     /* initialize barrier_all psync array */
     shmem_internal_barrier_all_psync =
         shmem_internal_shmalloc(sizeof(long) * SHMEM_BARRIER_SYNC_SIZE);
@@ -175,6 +423,8 @@ shmem_internal_collectives_init(void)
             shmem_internal_barrier_type = TREE;
         } else if (0 == strcmp(type, "dissem")) {
             shmem_internal_barrier_type = DISSEM;
+        } else if (0 == strcmp(type, "hier")) {
+            shmem_internal_barrier_type = HIER;
         } else {
             RAISE_WARN_MSG("Ignoring bad barrier algorithm '%s'\n", type);
         }
@@ -187,6 +437,10 @@ shmem_internal_collectives_init(void)
             shmem_internal_bcast_type = LINEAR;
         } else if (0 == strcmp(type, "tree")) {
             shmem_internal_bcast_type = TREE;
+        } else if (0 == strcmp(type, "pipeline")) {
+            shmem_internal_bcast_type = PIPELINE;
+        } else if (0 == strcmp(type, "scatter")) {
+            shmem_internal_bcast_type = SCATTER;
         } else {
             RAISE_WARN_MSG("Ignoring bad broadcast algorithm '%s'\n", type);
         }
@@ -203,6 +457,8 @@ shmem_internal_collectives_init(void)
             shmem_internal_reduce_type = TREE;
         } else if (0 == strcmp(type, "recdbl")) {
             shmem_internal_reduce_type = RECDBL;
+        } else if (0 == strcmp(type, "rabenseifner")) {
+            shmem_internal_reduce_type = RABENSEIFNER;
         } else {
             RAISE_WARN_MSG("Ignoring bad reduction algorithm '%s'\n", type);
         }
@@ -213,6 +469,10 @@ shmem_internal_collectives_init(void)
             shmem_internal_collect_type = AUTO;
         } else if (0 == strcmp(type, "linear")) {
             shmem_internal_collect_type = LINEAR;
+        } else if (0 == strcmp(type, "ring")) {
+            shmem_internal_collect_type = RING;
+        } else if (0 == strcmp(type, "recdbl")) {
+            shmem_internal_collect_type = RECDBL;
         } else {
             RAISE_WARN_MSG("Ignoring bad collect algorithm '%s'\n", type);
         }
@@ -229,10 +489,52 @@ shmem_internal_collectives_init(void)
             shmem_internal_fcollect_type = RING;
         } else if (0 == strcmp(type, "recdbl")) {
             shmem_internal_fcollect_type = RECDBL;
+        } else if (0 == strcmp(type, "bruck")) {
+            shmem_internal_fcollect_type = BRUCK;
         } else {
             RAISE_WARN_MSG("Ignoring bad fcollect algorithm '%s'\n", type);
         }
     }
+    if (shmem_internal_params.ALLTOALL_ALGORITHM_provided) {
+        type = shmem_internal_params.ALLTOALL_ALGORITHM;
+        if (0 == strcmp(type, "auto")) {
+            shmem_internal_alltoall_type = AUTO;
+        } else if (0 == strcmp(type, "linear")) {
+            shmem_internal_alltoall_type = LINEAR;
+        } else if (0 == strcmp(type, "pairwise")) {
+            shmem_internal_alltoall_type = PAIRWISE;
+        } else if (0 == strcmp(type, "bruck")) {
+            shmem_internal_alltoall_type = BRUCK;
+        } else if (0 == strcmp(type, "throttle")) {
+            shmem_internal_alltoall_type = THROTTLE;
+        } else {
+            RAISE_WARN_MSG("Ignoring bad alltoall algorithm '%s'\n", type);
+        }
+    }
+    if (shmem_internal_params.SCAN_ALGORITHM_provided) {
+        type = shmem_internal_params.SCAN_ALGORITHM;
+        if (0 == strcmp(type, "auto")) {
+            shmem_internal_scan_type = AUTO;
+        } else if (0 == strcmp(type, "ring")) {
+            shmem_internal_scan_type = RING;
+        } else if (0 == strcmp(type, "recdbl")) {
+            shmem_internal_scan_type = RECDBL;
+        } else {
+            RAISE_WARN_MSG("Ignoring bad scan algorithm '%s'\n", type);
+        }
+    }
+
+    if (shmem_internal_barrier_type == HIER) {
+        if (0 != shmem_internal_hier_sync_init()) return -1;
+    }
+
+    if (shmem_internal_params.ALLTOALL_SCRATCH > 0) {
+        alltoall_scratch_size = shmem_internal_params.ALLTOALL_SCRATCH;
+        alltoall_scratch = shmem_internal_shmalloc(ALLTOALL_SCRATCH_HDR +
+                                                   alltoall_scratch_size);
+        if (NULL == alltoall_scratch) return -1;
+        memset(alltoall_scratch, 0, ALLTOALL_SCRATCH_HDR);
+    }
 
     return 0;
 }
@@ -244,7 +546,7 @@ shmem_internal_collectives_init(void)
  *
  *****************************************/
 void
-shmem_internal_sync_linear(int PE_start, int PE_stride, int PE_size, long *pSync)
+shmem_internal_sync_linear(shmem_ctx_t ctx, int PE_start, int PE_stride, int PE_size, long *pSync)
 {
     long zero = 0, one = 1;
 
@@ -258,27 +560,26 @@ shmem_internal_sync_linear(int PE_start, int PE_stride, int PE_size, long *pSync
         SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, PE_size - 1);
 
         /* Clear pSync */
-        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &zero, sizeof(zero),
+        shmem_internal_put_scalar(ctx, pSync, &zero, sizeof(zero),
                                  shmem_internal_my_pe);
         SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
 
         /* Send acks down psync tree */
-        for (pe = PE_start + PE_stride, i = 1 ;
-             i < PE_size ;
-             i++, pe += PE_stride) {
-            shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(one), pe);
+        for (i = 1 ; i < PE_size ; i++) {
+            pe = shmem_internal_as_pe(PE_start, PE_stride, i);
+            shmem_internal_put_scalar(ctx, pSync, &one, sizeof(one), pe);
         }
 
     } else {
         /* send message to root */
-        shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(one), PE_start,
+        shmem_internal_atomic(ctx, pSync, &one, sizeof(one), PE_start,
                               SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
 
         /* wait for ack down psync tree */
         SHMEM_WAIT(pSync, 0);
 
         /* Clear pSync */
-        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &zero, sizeof(zero),
+        shmem_internal_put_scalar(ctx, pSync, &zero, sizeof(zero),
                                  shmem_internal_my_pe);
         SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
     }
@@ -287,7 +588,7 @@ shmem_internal_sync_linear(int PE_start, int PE_stride, int PE_size, long *pSync
 
 
 void
-shmem_internal_sync_tree(int PE_start, int PE_stride, int PE_size, long *pSync)
+shmem_internal_sync_tree(shmem_ctx_t ctx, int PE_start, int PE_stride, int PE_size, long *pSync)
 {
     long zero = 0, one = 1;
     int parent, num_children, *children;
@@ -317,13 +618,13 @@ shmem_internal_sync_tree(int PE_start, int PE_stride, int PE_size, long *pSync)
             /* The root of the tree */
 
             /* Clear pSync */
-            shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &zero, sizeof(zero),
+            shmem_internal_put_scalar(ctx, pSync, &zero, sizeof(zero),
                                      shmem_internal_my_pe);
             SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
 
             /* Send acks down to children */
             for (i = 0 ; i < num_children ; ++i) {
-                shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(one),
+                shmem_internal_atomic(ctx, pSync, &one, sizeof(one),
                                       children[i], SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
             }
 
@@ -331,20 +632,20 @@ shmem_internal_sync_tree(int PE_start, int PE_stride, int PE_size, long *pSync)
             /* Middle of the tree */
 
             /* send ack to parent */
-            shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(one),
+            shmem_internal_atomic(ctx, pSync, &one, sizeof(one),
                                   parent, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
 
             /* wait for ack from parent */
             SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, num_children  + 1);
 
             /* Clear pSync */
-            shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &zero, sizeof(zero),
+            shmem_internal_put_scalar(ctx, pSync, &zero, sizeof(zero),
                                      shmem_internal_my_pe);
             SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
 
             /* Send acks down to children */
             for (i = 0 ; i < num_children ; ++i) {
-                shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(one),
+                shmem_internal_atomic(ctx, pSync, &one, sizeof(one),
                                       children[i], SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
             }
         }
@@ -353,14 +654,14 @@ shmem_internal_sync_tree(int PE_start, int PE_stride, int PE_size, long *pSync)
         /* Leaf node */
 
         /* send message up psync tree */
-        shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(one), parent,
+        shmem_internal_atomic(ctx, pSync, &one, sizeof(one), parent,
                               SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
 
         /* wait for ack down psync tree */
         SHMEM_WAIT(pSync, 0);
 
         /* Clear pSync */
-        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &zero, sizeof(zero),
+        shmem_internal_put_scalar(ctx, pSync, &zero, sizeof(zero),
                                  shmem_internal_my_pe);
         SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
     }
@@ -368,11 +669,11 @@ shmem_internal_sync_tree(int PE_start, int PE_stride, int PE_size, long *pSync)
 
 
 void
-shmem_internal_sync_dissem(int PE_start, int PE_stride, int PE_size, long *pSync)
+shmem_internal_sync_dissem(shmem_ctx_t ctx, int PE_start, int PE_stride, int PE_size, long *pSync)
 {
     int one = 1, neg_one = -1;
     int distance, to, i;
-    int coll_rank = (shmem_internal_my_pe - PE_start) / PE_stride;
+    int coll_rank = shmem_internal_as_rank(PE_start, PE_stride, shmem_internal_my_pe);
     int *pSync_ints = (int*) pSync;
 
     /* need log2(num_procs) int slots.  max_num_procs is
@@ -386,9 +687,9 @@ shmem_internal_sync_dissem(int PE_start, int PE_stride, int PE_size, long *pSync
 
     for (i = 0, distance = 1 ; distance < PE_size ; ++i, distance <<= 1) {
         to = ((coll_rank + distance) % PE_size);
-        to = PE_start + (to * PE_stride);
+        to = shmem_internal_as_pe(PE_start, PE_stride, to);
 
-        shmem_internal_atomic(SHMEM_CTX_DEFAULT, &pSync_ints[i], &one, sizeof(int),
+        shmem_internal_atomic(ctx, &pSync_ints[i], &one, sizeof(int),
                               to, SHM_INTERNAL_SUM, SHM_INTERNAL_INT);
 
         SHMEM_WAIT_UNTIL(&pSync_ints[i], SHMEM_CMP_NE, 0);
@@ -398,12 +699,81 @@ shmem_internal_sync_dissem(int PE_start, int PE_stride, int PE_size, long *pSync
         shmem_internal_assert(pSync_ints[i] < 3);
 
         /* this slot is no longer used, so subtract off results now */
-        shmem_internal_atomic(SHMEM_CTX_DEFAULT, &pSync_ints[i], &neg_one, sizeof(int),
+        shmem_internal_atomic(ctx, &pSync_ints[i], &neg_one, sizeof(int),
                               shmem_internal_my_pe, SHM_INTERNAL_SUM, SHM_INTERNAL_INT);
     }
 
     /* Ensure local pSync decrements are done before a subsequent barrier */
-    shmem_internal_quiet(SHMEM_CTX_DEFAULT);
+    shmem_internal_quiet(ctx);
+}
+
+
+/* Two-level barrier.  Active set members on the same node check in with
+ * their node leader, the leaders synchronize among themselves using the
+ * dissemination algorithm, and each leader then releases its node.  Only the
+ * leader phase generates inter-node traffic. */
+void
+shmem_internal_sync_hier(shmem_ctx_t ctx, int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    int one = 1, neg_one = -1, zero = 0;
+    int distance, to, i;
+    int *pSync_ints = (int*) pSync;
+    int *local_slot = &pSync_ints[HIER_SYNC_LOCAL_SLOT];
+    struct hier_sync_info_t *info;
+
+    /* need sizeof(int) * 8 int slots, see shmem_internal_sync_dissem */
+    shmem_internal_assert(SHMEM_BARRIER_SYNC_SIZE >= (sizeof(int) * 8) / (sizeof(long) / sizeof(int)));
+
+    info = shmem_internal_hier_sync_info(PE_start, PE_stride, PE_size);
+
+    if (info->leader_idx < 0) {
+        /* check in with the node leader */
+        shmem_internal_atomic(ctx, local_slot, &one, sizeof(int),
+                              info->leader, SHM_INTERNAL_SUM, SHM_INTERNAL_INT);
+
+        /* wait for release from the node leader */
+        SHMEM_WAIT(local_slot, 0);
+
+        /* Clear pSync */
+        shmem_internal_put_scalar(ctx, local_slot, &zero, sizeof(zero),
+                                  shmem_internal_my_pe);
+        SHMEM_WAIT_UNTIL(local_slot, SHMEM_CMP_EQ, 0);
+        return;
+    }
+
+    if (info->num_local > 1) {
+        /* wait for all node-local members to check in */
+        SHMEM_WAIT_UNTIL(local_slot, SHMEM_CMP_EQ, info->num_local - 1);
+
+        /* Clear pSync */
+        shmem_internal_put_scalar(ctx, local_slot, &zero, sizeof(zero),
+                                  shmem_internal_my_pe);
+        SHMEM_WAIT_UNTIL(local_slot, SHMEM_CMP_EQ, 0);
+    }
+
+    if (info->num_leaders > 1) {
+        for (i = 0, distance = 1 ; distance < info->num_leaders ; ++i, distance <<= 1) {
+            to = info->leaders[(info->leader_idx + distance) % info->num_leaders];
+
+            shmem_internal_atomic(ctx, &pSync_ints[i], &one, sizeof(int),
+                                  to, SHM_INTERNAL_SUM, SHM_INTERNAL_INT);
+
+            SHMEM_WAIT_UNTIL(&pSync_ints[i], SHMEM_CMP_NE, 0);
+            shmem_internal_assert(pSync_ints[i] < 3);
+
+            shmem_internal_atomic(ctx, &pSync_ints[i], &neg_one, sizeof(int),
+                                  shmem_internal_my_pe, SHM_INTERNAL_SUM, SHM_INTERNAL_INT);
+        }
+
+        /* Ensure local pSync decrements are done before a subsequent barrier */
+        shmem_internal_quiet(ctx);
+    }
+
+    /* release node-local members */
+    for (i = 0 ; i < info->num_local - 1 ; i++) {
+        shmem_internal_put_scalar(ctx, local_slot, &one, sizeof(one),
+                                  info->local_pes[i]);
+    }
 }
 
 
@@ -413,12 +783,12 @@ shmem_internal_sync_dissem(int PE_start, int PE_stride, int PE_size, long *pSync
  *
  *****************************************/
 void
-shmem_internal_bcast_linear(void *target, const void *source, size_t len,
+shmem_internal_bcast_linear(shmem_ctx_t ctx, void *target, const void *source, size_t len,
                             int PE_root, int PE_start, int PE_stride, int PE_size,
                             long *pSync, int complete)
 {
     long zero = 0, one = 1;
-    int real_root = PE_start + PE_root * PE_stride;
+    int real_root = shmem_internal_as_pe(PE_start, PE_stride, PE_root);
     long completion = 0;
 
     /* need 1 slot */
@@ -430,18 +800,20 @@ shmem_internal_bcast_linear(void *target, const void *source, size_t len,
         int i, pe;
 
         /* send data to all peers */
-        for (pe = PE_start,i=0; i < PE_size; pe += PE_stride, i++) {
+        for (i = 0; i < PE_size; i++) {
+            pe = shmem_internal_as_pe(PE_start, PE_stride, i);
             if (pe == shmem_internal_my_pe) continue;
-            shmem_internal_put_nb(SHMEM_CTX_DEFAULT, target, source, len, pe, &completion);
+            shmem_internal_put_nb(ctx, target, source, len, pe, &completion);
         }
-        shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
+        shmem_internal_put_wait(ctx, &completion);
 
-        shmem_internal_fence(SHMEM_CTX_DEFAULT);
+        shmem_internal_fence(ctx);
 
         /* send completion ack to all peers */
-        for (pe = PE_start,i=0; i < PE_size; pe += PE_stride, i++) {
+        for (i = 0; i < PE_size; i++) {
+            pe = shmem_internal_as_pe(PE_start, PE_stride, i);
             if (pe == shmem_internal_my_pe) continue;
-            shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(long), pe);
+            shmem_internal_put_scalar(ctx, pSync, &one, sizeof(long), pe);
         }
 
         if (1 == complete) {
@@ -449,7 +821,7 @@ shmem_internal_bcast_linear(void *target, const void *source, size_t len,
             SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, PE_size - 1);
 
             /* Clear pSync */
-            shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &zero, sizeof(zero),
+            shmem_internal_put_scalar(ctx, pSync, &zero, sizeof(zero),
                                      shmem_internal_my_pe);
             SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
         }
@@ -459,13 +831,13 @@ shmem_internal_bcast_linear(void *target, const void *source, size_t len,
         SHMEM_WAIT(pSync, 0);
 
         /* Clear pSync */
-        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &zero, sizeof(zero),
+        shmem_internal_put_scalar(ctx, pSync, &zero, sizeof(zero),
                                  shmem_internal_my_pe);
         SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
 
         if (1 == complete) {
             /* send ack back to root */
-            shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(one),
+            shmem_internal_atomic(ctx, pSync, &one, sizeof(one),
                                   real_root, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
         }
     }
@@ -473,7 +845,7 @@ shmem_internal_bcast_linear(void *target, const void *source, size_t len,
 
 
 void
-shmem_internal_bcast_tree(void *target, const void *source, size_t len,
+shmem_internal_bcast_tree(shmem_ctx_t ctx, void *target, const void *source, size_t len,
                           int PE_root, int PE_start, int PE_stride, int PE_size,
                           long *pSync, int complete)
 {
@@ -487,7 +859,7 @@ shmem_internal_bcast_tree(void *target, const void *source, size_t len,
 
     if (PE_size == 1 || len == 0) return;
 
-    if (PE_size == shmem_internal_num_pes && 0 == PE_root) {
+    if (PE_size == shmem_internal_num_pes && 0 == PE_start && 0 == PE_root) {
         /* we're the full tree, use the binomial tree */
         parent = full_tree_parent;
         num_children = full_tree_num_children;
@@ -509,23 +881,23 @@ shmem_internal_bcast_tree(void *target, const void *source, size_t len,
 
             /* if complete, send ack */
             if (1 == complete) {
-                shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(one),
+                shmem_internal_atomic(ctx, pSync, &one, sizeof(one),
                                       parent, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
             }
         }
 
         /* send data to all leaves */
         for (i = 0 ; i < num_children ; ++i) {
-            shmem_internal_put_nb(SHMEM_CTX_DEFAULT, target, send_buf, len, children[i],
+            shmem_internal_put_nb(ctx, target, send_buf, len, children[i],
                                   &completion);
         }
-        shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
+        shmem_internal_put_wait(ctx, &completion);
 
-        shmem_internal_fence(SHMEM_CTX_DEFAULT);
+        shmem_internal_fence(ctx);
 
         /* send completion ack to all peers */
         for (i = 0 ; i < num_children ; ++i) {
-            shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(long),
+            shmem_internal_put_scalar(ctx, pSync, &one, sizeof(long),
                                      children[i]);
         }
 
@@ -538,7 +910,7 @@ shmem_internal_bcast_tree(void *target, const void *source, size_t len,
         }
 
         /* Clear pSync */
-        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &zero, sizeof(zero),
+        shmem_internal_put_scalar(ctx, pSync, &zero, sizeof(zero),
                                  shmem_internal_my_pe);
         SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
 
@@ -548,25 +920,201 @@ shmem_internal_bcast_tree(void *target, const void *source, size_t len,
 
         /* if complete, send ack */
         if (1 == complete) {
-            shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(one),
+            shmem_internal_atomic(ctx, pSync, &one, sizeof(one),
                                   parent, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
         }
 
         /* Clear pSync */
-        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &zero, sizeof(zero),
+        shmem_internal_put_scalar(ctx, pSync, &zero, sizeof(zero),
                                  shmem_internal_my_pe);
         SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
     }
 }
 
 
+void
+shmem_internal_bcast_pipeline(shmem_ctx_t ctx, void *target, const void *source, size_t len,
+                              int PE_root, int PE_start, int PE_stride, int PE_size,
+                              long *pSync, int complete)
+{
+    long zero = 0, one = 1;
+    long completion = 0;
+    int parent, num_children, *children;
+    const uint8_t *send_buf = source;
+    size_t seg_size = shmem_internal_params.BCAST_SEGMENT_SIZE;
+    long i, num_segs;
+
+    /* need 1 slot */
+    shmem_internal_assert(SHMEM_BCAST_SYNC_SIZE >= 1);
+
+    if (PE_size == 1 || len == 0) return;
+
+    if (seg_size == 0) seg_size = len;
+    num_segs = (long) ((len + seg_size - 1) / seg_size);
+
+    if (PE_size == shmem_internal_num_pes && 0 == PE_start && 0 == PE_root) {
+        /* we're the full tree, use the binomial tree */
+        parent = full_tree_parent;
+        num_children = full_tree_num_children;
+        children = full_tree_children;
+    } else {
+        children = alloca(sizeof(int) * tree_radix);
+        shmem_internal_build_kary_tree(tree_radix, PE_start, PE_stride, PE_size,
+                                       PE_root, &parent, &num_children, children);
+    }
+
+    if (parent != shmem_internal_my_pe) send_buf = target;
+
+    /* The parent adds one to pSync for each segment it delivers.  Acks from
+     * children can only arrive after the last segment has been forwarded,
+     * so the counter is not disturbed while segments are in flight. */
+    if (0 != num_children) {
+        for (i = 0; i < num_segs; i++) {
+            size_t offset = (size_t) i * seg_size;
+            size_t seg_len = (len - offset < seg_size) ? len - offset : seg_size;
+            int j;
+
+            if (parent != shmem_internal_my_pe)
+                SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_GE, i + 1);
+
+            for (j = 0 ; j < num_children ; ++j) {
+                shmem_internal_put_nb(ctx, (uint8_t *) target + offset,
+                                      send_buf + offset, seg_len, children[j],
+                                      &completion);
+            }
+            shmem_internal_put_wait(ctx, &completion);
+
+            shmem_internal_fence(ctx);
+
+            for (j = 0 ; j < num_children ; ++j) {
+                shmem_internal_atomic(ctx, pSync, &one, sizeof(one),
+                                      children[j], SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+            }
+        }
+    } else {
+        /* wait for all segments to arrive */
+        SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_GE, num_segs);
+    }
+
+    if (1 == complete) {
+        /* send ack once all segments are here */
+        if (parent != shmem_internal_my_pe) {
+            shmem_internal_atomic(ctx, pSync, &one, sizeof(one),
+                                  parent, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+        }
+
+        /* wait for acks from children */
+        SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, num_children +
+                         ((parent == shmem_internal_my_pe) ? 0 : num_segs));
+    }
+
+    /* Clear pSync */
+    shmem_internal_put_scalar(ctx, pSync, &zero, sizeof(zero),
+                             shmem_internal_my_pe);
+    SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
+}
+
+
+void
+shmem_internal_bcast_scatter(shmem_ctx_t ctx, void *target, const void *source, size_t len,
+                             int PE_root, int PE_start, int PE_stride, int PE_size,
+                             long *pSync, int complete)
+{
+    long zero = 0, one = 1, scatter_inc = PE_size;
+    long completion = 0;
+    int my_id = shmem_internal_as_rank(PE_start, PE_stride, shmem_internal_my_pe);
+    int my_rel = (my_id - PE_root + PE_size) % PE_size;
+    int real_root = shmem_internal_as_pe(PE_start, PE_stride, PE_root);
+    int right = shmem_internal_as_pe(PE_start, PE_stride, (my_id + 1) % PE_size);
+    size_t blk_size = (len + PE_size - 1) / PE_size;
+    const uint8_t *send_buf = (my_rel == 0) ? source : target;
+    int i;
+
+    /* need 1 slot */
+    shmem_internal_assert(SHMEM_BCAST_SYNC_SIZE >= 1);
+
+    if (PE_size == 1 || len == 0) return;
+
+    /* Scatter: block j (relative to the root) goes to relative PE j.  The
+     * root's target buffer is never written, so it keeps block 0 and sends
+     * it around the ring with the rest.  The scatter adds PE_size to pSync
+     * and each ring step adds one, so a count of PE_size + s means the
+     * scattered block and the first s ring blocks have arrived. */
+    if (my_rel == 0) {
+        for (i = 1; i < PE_size; i++) {
+            int pe = shmem_internal_as_pe(PE_start, PE_stride, (PE_root + i) % PE_size);
+            size_t offset = i * blk_size;
+
+            if (offset < len) {
+                size_t blk_len = (len - offset < blk_size) ? len - offset : blk_size;
+                shmem_internal_put_nb(ctx, (uint8_t *) target + offset,
+                                      send_buf + offset, blk_len, pe, &completion);
+            }
+        }
+        shmem_internal_put_wait(ctx, &completion);
+
+        shmem_internal_fence(ctx);
+
+        for (i = 1; i < PE_size; i++) {
+            int pe = shmem_internal_as_pe(PE_start, PE_stride, (PE_root + i) % PE_size);
+            shmem_internal_atomic(ctx, pSync, &scatter_inc,
+                                  sizeof(scatter_inc), pe, SHM_INTERNAL_SUM,
+                                  SHM_INTERNAL_LONG);
+        }
+    }
+
+    /* Ring allgather: at step s, forward block (my_rel - s) to the right.
+     * The root already has every block, so the last PE skips sending. */
+    if (my_rel != PE_size - 1) {
+        for (i = 0; i < PE_size - 1; i++) {
+            int blk = (my_rel - i + PE_size) % PE_size;
+            size_t offset = blk * blk_size;
+
+            if (my_rel != 0)
+                SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_GE, PE_size + i);
+
+            if (offset < len) {
+                size_t blk_len = (len - offset < blk_size) ? len - offset : blk_size;
+                shmem_internal_put_nb(ctx, (uint8_t *) target + offset,
+                                      send_buf + offset, blk_len, right, &completion);
+                shmem_internal_put_wait(ctx, &completion);
+            }
+
+            shmem_internal_fence(ctx);
+
+            shmem_internal_atomic(ctx, pSync, &one, sizeof(one),
+                                  right, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+        }
+    }
+
+    if (my_rel != 0) {
+        /* wait for the last ring block */
+        SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_GE, 2 * PE_size - 1);
+
+        if (1 == complete) {
+            shmem_internal_atomic(ctx, pSync, &one, sizeof(one),
+                                  real_root, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+        }
+    } else if (1 == complete) {
+        /* wait for acks from everyone */
+        SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, PE_size - 1);
+    }
+
+    /* Clear pSync */
+    shmem_internal_put_scalar(ctx, pSync, &zero, sizeof(zero),
+                             shmem_internal_my_pe);
+    SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
+}
+
+
 /*****************************************
  *
  * REDUCTION
  *
  *****************************************/
 void
-shmem_internal_op_to_all_linear(void *target, const void *source, size_t count, size_t type_size,
+shmem_internal_op_to_all_linear(shmem_ctx_t ctx,
+                                void *target, const void *source, size_t count, size_t type_size,
                                 int PE_start, int PE_stride, int PE_size,
                                 void *pWrk, long *pSync,
                                 shm_internal_op_t op, shm_internal_datatype_t datatype)
@@ -585,23 +1133,22 @@ shmem_internal_op_to_all_linear(void *target, const void *source, size_t count,
         /* update our target buffer with our contribution.  The put
            will flush any atomic cache value that may currently
            exist. */
-        shmem_internal_put_nb(SHMEM_CTX_DEFAULT, target, source, count * type_size,
+        shmem_internal_put_nb(ctx, target, source, count * type_size,
                               shmem_internal_my_pe, &completion);
-        shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
-        shmem_internal_quiet(SHMEM_CTX_DEFAULT);
+        shmem_internal_put_wait(ctx, &completion);
+        shmem_internal_quiet(ctx);
 
         /* let everyone know that it's safe to send to us */
-        for (pe = PE_start + PE_stride, i = 1 ;
-             i < PE_size ;
-             i++, pe += PE_stride) {
-            shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(one), pe);
+        for (i = 1 ; i < PE_size ; i++) {
+            pe = shmem_internal_as_pe(PE_start, PE_stride, i);
+            shmem_internal_put_scalar(ctx, pSync, &one, sizeof(one), pe);
         }
 
         /* Wait for others to acknowledge sending data */
         SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, PE_size - 1);
 
         /* reset pSync */
-        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &zero, sizeof(zero), shmem_internal_my_pe);
+        shmem_internal_put_scalar(ctx, pSync, &zero, sizeof(zero), shmem_internal_my_pe);
         SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
 
     } else {
@@ -609,21 +1156,21 @@ shmem_internal_op_to_all_linear(void *target, const void *source, size_t count,
         SHMEM_WAIT(pSync, 0);
 
         /* reset pSync */
-        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &zero, sizeof(zero), shmem_internal_my_pe);
+        shmem_internal_put_scalar(ctx, pSync, &zero, sizeof(zero), shmem_internal_my_pe);
         SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
 
         /* send data, ack, and wait for completion */
-        shmem_internal_atomicv(SHMEM_CTX_DEFAULT, target, source, count * type_size,
+        shmem_internal_atomicv(ctx, target, source, count * type_size,
                                PE_start, op, datatype, &completion);
-        shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
-        shmem_internal_fence(SHMEM_CTX_DEFAULT);
+        shmem_internal_put_wait(ctx, &completion);
+        shmem_internal_fence(ctx);
 
-        shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(one),
+        shmem_internal_atomic(ctx, pSync, &one, sizeof(one),
                               PE_start, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
     }
 
     /* broadcast out */
-    shmem_internal_bcast(target, target, count * type_size, 0,
+    shmem_internal_bcast(ctx, target, target, count * type_size, 0,
                          PE_start, PE_stride, PE_size, pSync + 2, 0);
 }
 
@@ -632,15 +1179,16 @@ shmem_internal_op_to_all_linear(void *target, const void *source, size_t count,
     (count_)/(npes_) + ((id_) < (count_) % (_npes))
 
 void
-shmem_internal_op_to_all_ring(void *target, const void *source, size_t count, size_t type_size,
+shmem_internal_op_to_all_ring(shmem_ctx_t ctx,
+                              void *target, const void *source, size_t count, size_t type_size,
                               int PE_start, int PE_stride, int PE_size,
                               void *pWrk, long *pSync,
                               shm_internal_op_t op, shm_internal_datatype_t datatype)
 {
-    int group_rank = (shmem_internal_my_pe - PE_start) / PE_stride;
+    int group_rank = shmem_internal_as_rank(PE_start, PE_stride, shmem_internal_my_pe);
     long zero = 0, one = 1;
 
-    int peer = PE_start + ((group_rank + 1) % PE_size) * PE_stride;
+    int peer = shmem_internal_as_pe(PE_start, PE_stride, (group_rank + 1) % PE_size);
     int free_source = 0;
 
     /* One slot for reduce-scatter and another for the allgather */
@@ -666,7 +1214,7 @@ shmem_internal_op_to_all_ring(void *target, const void *source, size_t count, si
         free_source = 1;
         source = tmp;
 
-        shmem_internal_sync(PE_start, PE_stride, PE_size, pSync + 2);
+        shmem_internal_sync(ctx, PE_start, PE_stride, PE_size, pSync + 2);
     }
 
     /* Perform reduce-scatter:
@@ -695,14 +1243,14 @@ shmem_internal_op_to_all_ring(void *target, const void *source, size_t count, si
                                  chunk_in * chunk_in_count * type_size :
                                  (chunk_in * chunk_in_count + count % PE_size) * type_size;
 
-        shmem_internal_put_nbi(SHMEM_CTX_DEFAULT,
+        shmem_internal_put_nbi(ctx,
                                ((uint8_t *) target) + chunk_out_disp,
                                i == 0 ?
                                    ((uint8_t *) source) + chunk_out_disp :
                                    ((uint8_t *) target) + chunk_out_disp,
                                chunk_out_count * type_size, peer);
-        shmem_internal_fence(SHMEM_CTX_DEFAULT);
-        shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(one),
+        shmem_internal_fence(ctx);
+        shmem_internal_atomic(ctx, pSync, &one, sizeof(one),
                               peer, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
 
         /* Wait for chunk */
@@ -714,7 +1262,7 @@ shmem_internal_op_to_all_ring(void *target, const void *source, size_t count, si
     }
 
     /* Reset reduce-scatter pSync */
-    shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &zero, sizeof(zero), shmem_internal_my_pe);
+    shmem_internal_put_scalar(ctx, pSync, &zero, sizeof(zero), shmem_internal_my_pe);
     SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
 
     /* Perform all-gather:
@@ -730,12 +1278,12 @@ shmem_internal_op_to_all_ring(void *target, const void *source, size_t count, si
                                  chunk_out * chunk_out_count * type_size :
                                  (chunk_out * chunk_out_count + count % PE_size) * type_size;
 
-        shmem_internal_put_nbi(SHMEM_CTX_DEFAULT,
+        shmem_internal_put_nbi(ctx,
                                ((uint8_t *) target) + chunk_out_disp,
                                ((uint8_t *) target) + chunk_out_disp,
                                chunk_out_count * type_size, peer);
-        shmem_internal_fence(SHMEM_CTX_DEFAULT);
-        shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync+1, &one, sizeof(one),
+        shmem_internal_fence(ctx);
+        shmem_internal_atomic(ctx, pSync+1, &one, sizeof(one),
                               peer, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
 
         /* Wait for chunk */
@@ -743,7 +1291,7 @@ shmem_internal_op_to_all_ring(void *target, const void *source, size_t count, si
     }
 
     /* reset pSync */
-    shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync+1, &zero, sizeof(zero), shmem_internal_my_pe);
+    shmem_internal_put_scalar(ctx, pSync+1, &zero, sizeof(zero), shmem_internal_my_pe);
     SHMEM_WAIT_UNTIL(pSync+1, SHMEM_CMP_EQ, 0);
 
     if (free_source)
@@ -752,7 +1300,8 @@ shmem_internal_op_to_all_ring(void *target, const void *source, size_t count, si
 
 
 void
-shmem_internal_op_to_all_tree(void *target, const void *source, size_t count, size_t type_size,
+shmem_internal_op_to_all_tree(shmem_ctx_t ctx,
+                              void *target, const void *source, size_t count, size_t type_size,
                               int PE_start, int PE_stride, int PE_size,
                               void *pWrk, long *pSync,
                               shm_internal_op_t op, shm_internal_datatype_t datatype)
@@ -773,7 +1322,8 @@ shmem_internal_op_to_all_tree(void *target, const void *source, size_t count, si
 
     if (count == 0) return;
 
-    if (PE_size == shmem_internal_num_pes) {
+    /* The result is broadcast from PE_start, which must be the tree root */
+    if (PE_size == shmem_internal_num_pes && 0 == PE_start) {
         /* we're the full tree, use the binomial tree */
         parent = full_tree_parent;
         num_children = full_tree_num_children;
@@ -790,21 +1340,21 @@ shmem_internal_op_to_all_tree(void *target, const void *source, size_t count, si
         /* update our target buffer with our contribution.  The put
            will flush any atomic cache value that may currently
            exist. */
-        shmem_internal_put_nb(SHMEM_CTX_DEFAULT, target, source, count * type_size,
+        shmem_internal_put_nb(ctx, target, source, count * type_size,
                               shmem_internal_my_pe, &completion);
-        shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
-        shmem_internal_quiet(SHMEM_CTX_DEFAULT);
+        shmem_internal_put_wait(ctx, &completion);
+        shmem_internal_quiet(ctx);
 
         /* let everyone know that it's safe to send to us */
         for (i = 0 ; i < num_children ; ++i) {
-            shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync + 1, &one, sizeof(one), children[i]);
+            shmem_internal_put_scalar(ctx, pSync + 1, &one, sizeof(one), children[i]);
         }
 
         /* Wait for others to acknowledge sending data */
         SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, num_children);
 
         /* reset pSync */
-        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &zero, sizeof(zero), shmem_internal_my_pe);
+        shmem_internal_put_scalar(ctx, pSync, &zero, sizeof(zero), shmem_internal_my_pe);
         SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
     }
 
@@ -813,34 +1363,35 @@ shmem_internal_op_to_all_tree(void *target, const void *source, size_t count, si
         SHMEM_WAIT(pSync + 1, 0);
 
         /* reset pSync */
-        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync + 1, &zero, sizeof(zero), shmem_internal_my_pe);
+        shmem_internal_put_scalar(ctx, pSync + 1, &zero, sizeof(zero), shmem_internal_my_pe);
         SHMEM_WAIT_UNTIL(pSync + 1, SHMEM_CMP_EQ, 0);
 
         /* send data, ack, and wait for completion */
-        shmem_internal_atomicv(SHMEM_CTX_DEFAULT, target,
+        shmem_internal_atomicv(ctx, target,
                                (num_children == 0) ? source : target,
                                count * type_size, parent,
                                op, datatype, &completion);
-        shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
-        shmem_internal_fence(SHMEM_CTX_DEFAULT);
+        shmem_internal_put_wait(ctx, &completion);
+        shmem_internal_fence(ctx);
 
-        shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(one),
+        shmem_internal_atomic(ctx, pSync, &one, sizeof(one),
                               parent, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
     }
 
     /* broadcast out */
-    shmem_internal_bcast(target, target, count * type_size, 0, PE_start,
+    shmem_internal_bcast(ctx, target, target, count * type_size, 0, PE_start,
                          PE_stride, PE_size, pSync + 2, 0);
 }
 
 
 void
-shmem_internal_op_to_all_recdbl_sw(void *target, const void *source, size_t count, size_t type_size,
+shmem_internal_op_to_all_recdbl_sw(shmem_ctx_t ctx,
+                                   void *target, const void *source, size_t count, size_t type_size,
                                    int PE_start, int PE_stride, int PE_size,
                                    void *pWrk, long *pSync,
                                    shm_internal_op_t op, shm_internal_datatype_t datatype)
 {
-    int my_id = ((shmem_internal_my_pe - PE_start) / PE_stride);
+    int my_id = shmem_internal_as_rank(PE_start, PE_stride, shmem_internal_my_pe);
     int log2_proc = 1, pow2_proc = 2;
     int i = PE_size >> 1;
     size_t wrk_size = type_size*count;
@@ -890,23 +1441,23 @@ shmem_internal_op_to_all_recdbl_sw(void *target, const void *source, size_t coun
     /* extra peer exchange: grab information from extra_peer so its part of
      * pairwise exchange */
     if (my_id >= pow2_proc) {
-        int peer = (my_id - pow2_proc) * PE_stride + PE_start;
+        int peer = shmem_internal_as_pe(PE_start, PE_stride, my_id - pow2_proc);
 
         /* Wait for target ready, required when source and target overlap */
         SHMEM_WAIT_UNTIL(pSync_extra_peer, SHMEM_CMP_EQ, ps_target_ready);
 
-        shmem_internal_put_nb(SHMEM_CTX_DEFAULT, target, current_target, wrk_size, peer,
+        shmem_internal_put_nb(ctx, target, current_target, wrk_size, peer,
                               &completion);
-        shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
-        shmem_internal_fence(SHMEM_CTX_DEFAULT);
+        shmem_internal_put_wait(ctx, &completion);
+        shmem_internal_fence(ctx);
 
-        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync_extra_peer, &ps_data_ready, sizeof(long), peer);
+        shmem_internal_put_scalar(ctx, pSync_extra_peer, &ps_data_ready, sizeof(long), peer);
         SHMEM_WAIT_UNTIL(pSync_extra_peer, SHMEM_CMP_EQ, ps_data_ready);
 
     } else {
         if (my_id < PE_size - pow2_proc) {
-            int peer = (my_id + pow2_proc) * PE_stride + PE_start;
-            shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync_extra_peer, &ps_target_ready, sizeof(long), peer);
+            int peer = shmem_internal_as_pe(PE_start, PE_stride, my_id + pow2_proc);
+            shmem_internal_put_scalar(ctx, pSync_extra_peer, &ps_target_ready, sizeof(long), peer);
 
             SHMEM_WAIT_UNTIL(pSync_extra_peer, SHMEM_CMP_EQ, ps_data_ready);
             shmem_internal_reduce_local(op, datatype, count, target, current_target);
@@ -918,28 +1469,28 @@ shmem_internal_op_to_all_recdbl_sw(void *target, const void *source, size_t coun
 
         for (i = 0; i < log2_proc; i++) {
             long *step_psync = &pSync[i];
-            int peer = (my_id ^ (1 << i)) * PE_stride + PE_start;
+            int peer = shmem_internal_as_pe(PE_start, PE_stride, my_id ^ (1 << i));
 
             if (shmem_internal_my_pe < peer) {
-                shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, step_psync, &ps_target_ready,
+                shmem_internal_put_scalar(ctx, step_psync, &ps_target_ready,
                                          sizeof(long), peer);
                 SHMEM_WAIT_UNTIL(step_psync, SHMEM_CMP_EQ, ps_data_ready);
 
-                shmem_internal_put_nb(SHMEM_CTX_DEFAULT, target, current_target,
+                shmem_internal_put_nb(ctx, target, current_target,
                                       wrk_size, peer, &completion);
-                shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
-                shmem_internal_fence(SHMEM_CTX_DEFAULT);
-                shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, step_psync, &ps_data_ready,
+                shmem_internal_put_wait(ctx, &completion);
+                shmem_internal_fence(ctx);
+                shmem_internal_put_scalar(ctx, step_psync, &ps_data_ready,
                                          sizeof(long), peer);
             }
             else {
                 SHMEM_WAIT_UNTIL(step_psync, SHMEM_CMP_EQ, ps_target_ready);
 
-                shmem_internal_put_nb(SHMEM_CTX_DEFAULT, target, current_target,
+                shmem_internal_put_nb(ctx, target, current_target,
                                       wrk_size, peer, &completion);
-                shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
-                shmem_internal_fence(SHMEM_CTX_DEFAULT);
-                shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, step_psync, &ps_data_ready,
+                shmem_internal_put_wait(ctx, &completion);
+                shmem_internal_fence(ctx);
+                shmem_internal_put_scalar(ctx, step_psync, &ps_data_ready,
                                          sizeof(long), peer);
 
                 SHMEM_WAIT_UNTIL(step_psync, SHMEM_CMP_EQ, ps_data_ready);
@@ -951,13 +1502,13 @@ shmem_internal_op_to_all_recdbl_sw(void *target, const void *source, size_t coun
 
         /* update extra peer with the final result from the pairwise exchange */
         if (my_id < PE_size - pow2_proc) {
-            int peer = (my_id + pow2_proc) * PE_stride + PE_start;
+            int peer = shmem_internal_as_pe(PE_start, PE_stride, my_id + pow2_proc);
 
-            shmem_internal_put_nb(SHMEM_CTX_DEFAULT, target, current_target, wrk_size,
+            shmem_internal_put_nb(ctx, target, current_target, wrk_size,
                                   peer, &completion);
-            shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
-            shmem_internal_fence(SHMEM_CTX_DEFAULT);
-            shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync_extra_peer, &ps_data_ready,
+            shmem_internal_put_wait(ctx, &completion);
+            shmem_internal_fence(ctx);
+            shmem_internal_put_scalar(ctx, pSync_extra_peer, &ps_data_ready,
                                      sizeof(long), peer);
         }
 
@@ -971,257 +1522,455 @@ shmem_internal_op_to_all_recdbl_sw(void *target, const void *source, size_t coun
 }
 
 
-/*****************************************
+/* Rabenseifner's reduction: a reduce-scatter by recursive halving followed
+ * by an allgather by recursive doubling.  PEs beyond the largest power of
+ * two first fold their contribution into a partner in the power of two set
+ * and receive the final result from it at the end.
  *
- * COLLECT (variable size)
+ *   2 log(p) alpha + 2 (p-1)/p n beta + (p-1)/p n gamma
  *
- *****************************************/
+ * pSync usage: [i] counter for step i of both phases (the peer adds one
+ * when it is ready to receive, one when its reduce-scatter data has
+ * arrived, and one when its allgather data has arrived), [SIZE-2] counter
+ * for the extra PE exchange.
+ */
 void
-shmem_internal_collect_linear(void *target, const void *source, size_t len,
-                              int PE_start, int PE_stride, int PE_size, long *pSync)
+shmem_internal_op_to_all_rabenseifner(shmem_ctx_t ctx,
+                                      void *target, const void *source, size_t count,
+                                      size_t type_size, int PE_start, int PE_stride,
+                                      int PE_size, void *pWrk, long *pSync,
+                                      shm_internal_op_t op,
+                                      shm_internal_datatype_t datatype)
 {
-    size_t my_offset;
-    long tmp[2];
-    int peer, start_pe, i;
-
-    /* Need 2 for lengths and barrier for completion */
-    shmem_internal_assert(SHMEM_COLLECT_SYNC_SIZE >= 2 + SHMEM_BARRIER_SYNC_SIZE);
-
-    DEBUG_MSG("target=%p, source=%p, len=%zd, PE_Start=%d, PE_stride=%d, PE_size=%d, pSync=%p\n",
-              target, source, len, PE_start, PE_stride, PE_size, (void*) pSync);
+    int my_id = shmem_internal_as_rank(PE_start, PE_stride, shmem_internal_my_pe);
+    int log2_proc = 0, pow2_proc = 1;
+    int i;
+    size_t wrk_size = type_size * count;
+    size_t lo = 0, hi = count;
+    size_t range_lo[SHMEM_REDUCE_SYNC_SIZE], range_hi[SHMEM_REDUCE_SYNC_SIZE];
+    long completion = 0, one = 1;
+    long *pSync_extra_peer = pSync + SHMEM_REDUCE_SYNC_SIZE - 2;
+    uint8_t *acc;
 
     if (PE_size == 1) {
-        if (target != source) shmem_internal_copy_self(target, source, len);
+        if (target != source) {
+            shmem_internal_copy_self(target, source, wrk_size);
+        }
         return;
     }
 
-    /* Linear prefix sum -- propagate update lengths and calculate offset */
-    if (PE_start == shmem_internal_my_pe) {
-        my_offset = 0;
-        tmp[0] = (long) len; /* FIXME: Potential truncation of size_t into long */
-        tmp[1] = 1; /* FIXME: Packing flag with data relies on byte ordering */
-        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, tmp, 2 * sizeof(long), PE_start + PE_stride);
+    if (count == 0) return;
+
+    while (pow2_proc * 2 <= PE_size) {
+        pow2_proc <<= 1;
+        log2_proc++;
     }
-    else {
-        /* wait for send data */
-        SHMEM_WAIT_UNTIL(&pSync[1], SHMEM_CMP_EQ, 1);
-        my_offset = pSync[0];
 
-        /* Not the last guy, so send offset to next PE */
-        if (shmem_internal_my_pe < PE_start + PE_stride * (PE_size - 1)) {
-            tmp[0] = (long) (my_offset + len);
-            tmp[1] = 1;
-            shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, tmp, 2 * sizeof(long),
-                                     shmem_internal_my_pe + PE_stride);
-        }
+    shmem_internal_assert(log2_proc <= (SHMEM_REDUCE_SYNC_SIZE - 2));
+
+    /* Extra PE: hand our contribution to the partner and wait for the
+     * result.  The target buffer receives the data, so the partner signals
+     * when it is safe to write into its target. */
+    if (my_id >= pow2_proc) {
+        int peer = shmem_internal_as_pe(PE_start, PE_stride, my_id - pow2_proc);
+
+        SHMEM_WAIT_UNTIL(pSync_extra_peer, SHMEM_CMP_GE, 1);
+
+        shmem_internal_put_nb(ctx, target, source, wrk_size, peer,
+                              &completion);
+        shmem_internal_put_wait(ctx, &completion);
+        shmem_internal_fence(ctx);
+        shmem_internal_atomic(ctx, pSync_extra_peer, &one, sizeof(one),
+                              peer, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+
+        SHMEM_WAIT_UNTIL(pSync_extra_peer, SHMEM_CMP_GE, 2);
+        *pSync_extra_peer = SHMEM_SYNC_VALUE;
+        return;
     }
 
-    /* Send data round-robin, ending with my PE */
-    start_pe = shmem_internal_circular_iter_next(shmem_internal_my_pe,
-                                                 PE_start, PE_stride,
-                                                 PE_size);
-    peer = start_pe;
-    do {
-        if (len > 0) {
-            shmem_internal_put_nbi(SHMEM_CTX_DEFAULT, ((uint8_t *) target) + my_offset, source,
-                                  len, peer);
-        }
-        peer = shmem_internal_circular_iter_next(peer, PE_start, PE_stride,
-                                                 PE_size);
-    } while (peer != start_pe);
+    acc = malloc(wrk_size);
+    if (NULL == acc)
+        RAISE_ERROR_MSG("Failed to allocate accumulation buffer (count=%zu, type_size=%zu, size=%zuB)\n",
+                        count, type_size, wrk_size);
 
-    shmem_internal_barrier(PE_start, PE_stride, PE_size, &pSync[2]);
+    memcpy(acc, source, wrk_size);
 
-    pSync[0] = SHMEM_SYNC_VALUE;
-    pSync[1] = SHMEM_SYNC_VALUE;
+    if (my_id < PE_size - pow2_proc) {
+        int peer = shmem_internal_as_pe(PE_start, PE_stride, my_id + pow2_proc);
 
-    for (i = 0; i < SHMEM_BARRIER_SYNC_SIZE; i++)
-        pSync[2+i] = SHMEM_SYNC_VALUE;
-}
+        shmem_internal_atomic(ctx, pSync_extra_peer, &one, sizeof(one),
+                              peer, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+        SHMEM_WAIT_UNTIL(pSync_extra_peer, SHMEM_CMP_GE, 1);
 
+        shmem_internal_reduce_local(op, datatype, count, target, acc);
+    }
 
-/*****************************************
- *
- * COLLECT (same size)
- *
- *****************************************/
-void
-shmem_internal_fcollect_linear(void *target, const void *source, size_t len,
-                               int PE_start, int PE_stride, int PE_size, long *pSync)
-{
-    long tmp = 1;
-    long completion = 0;
+    /* Reduce-scatter: in step i, split the current range in half, keep the
+     * half selected by bit i of our id and send the other half to the peer.
+     * A peer only writes the half we keep, so its data never overlaps the
+     * region we are still reducing from an earlier step. */
+    for (i = 0; i < log2_proc; i++) {
+        int peer = shmem_internal_as_pe(PE_start, PE_stride, my_id ^ (1 << i));
+        size_t mid = lo + (hi - lo) / 2;
+        size_t keep_lo, keep_hi, send_lo, send_hi;
+
+        range_lo[i] = lo;
+        range_hi[i] = hi;
+
+        if (my_id & (1 << i)) {
+            keep_lo = mid; keep_hi = hi;
+            send_lo = lo;  send_hi = mid;
+        } else {
+            keep_lo = lo;  keep_hi = mid;
+            send_lo = mid; send_hi = hi;
+        }
 
-    /* need 1 slot, plus bcast */
-    shmem_internal_assert(SHMEM_COLLECT_SYNC_SIZE >= 1 + SHMEM_BCAST_SYNC_SIZE);
+        /* Signal that our target is ready and wait for the peer */
+        shmem_internal_atomic(ctx, &pSync[i], &one, sizeof(one),
+                              peer, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+        SHMEM_WAIT_UNTIL(&pSync[i], SHMEM_CMP_GE, 1);
 
-    if (PE_start == shmem_internal_my_pe) {
-        /* Copy data into the target */
-        if (source != target) shmem_internal_copy_self(target, source, len);
+        if (send_hi > send_lo) {
+            shmem_internal_put_nb(ctx, (uint8_t *) target + send_lo * type_size,
+                                  acc + send_lo * type_size,
+                                  (send_hi - send_lo) * type_size, peer, &completion);
+            shmem_internal_put_wait(ctx, &completion);
+        }
+        shmem_internal_fence(ctx);
+        shmem_internal_atomic(ctx, &pSync[i], &one, sizeof(one),
+                              peer, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
 
-        /* send completion update */
-        shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &tmp, sizeof(long),
-                              PE_start, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+        SHMEM_WAIT_UNTIL(&pSync[i], SHMEM_CMP_GE, 2);
 
-        /* wait for N updates */
-        SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, PE_size);
+        if (keep_hi > keep_lo)
+            shmem_internal_reduce_local(op, datatype, keep_hi - keep_lo,
+                                        (uint8_t *) target + keep_lo * type_size,
+                                        acc + keep_lo * type_size);
 
-        /* Clear pSync */
-        tmp = 0;
-        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &tmp, sizeof(tmp), PE_start);
-        SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
-    } else {
-        /* Push data into the target */
-        size_t offset = ((shmem_internal_my_pe - PE_start) / PE_stride) * len;
-        shmem_internal_put_nb(SHMEM_CTX_DEFAULT, (char*) target + offset, source, len, PE_start,
-                              &completion);
-        shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
+        lo = keep_lo;
+        hi = keep_hi;
+    }
 
-        /* ensure ordering */
-        shmem_internal_fence(SHMEM_CTX_DEFAULT);
+    memcpy((uint8_t *) target + lo * type_size, acc + lo * type_size,
+           (hi - lo) * type_size);
+    free(acc);
 
-        /* send completion update */
-        shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &tmp, sizeof(long),
-                              PE_start, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+    /* Allgather: retrace the steps, exchanging the reduced ranges */
+    for (i = log2_proc - 1; i >= 0; i--) {
+        int peer = shmem_internal_as_pe(PE_start, PE_stride, my_id ^ (1 << i));
+
+        if (hi > lo) {
+            shmem_internal_put_nb(ctx, (uint8_t *) target + lo * type_size,
+                                  (uint8_t *) target + lo * type_size,
+                                  (hi - lo) * type_size, peer, &completion);
+            shmem_internal_put_wait(ctx, &completion);
+        }
+        shmem_internal_fence(ctx);
+        shmem_internal_atomic(ctx, &pSync[i], &one, sizeof(one),
+                              peer, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+
+        SHMEM_WAIT_UNTIL(&pSync[i], SHMEM_CMP_GE, 3);
+
+        lo = range_lo[i];
+        hi = range_hi[i];
     }
 
-    shmem_internal_bcast(target, target, len * PE_size, 0, PE_start, PE_stride,
-                         PE_size, pSync + 1, 0);
+    /* Send the result to the extra PE */
+    if (my_id < PE_size - pow2_proc) {
+        int peer = shmem_internal_as_pe(PE_start, PE_stride, my_id + pow2_proc);
+
+        shmem_internal_put_nb(ctx, target, target, wrk_size, peer,
+                              &completion);
+        shmem_internal_put_wait(ctx, &completion);
+        shmem_internal_fence(ctx);
+        shmem_internal_atomic(ctx, pSync_extra_peer, &one, sizeof(one),
+                              peer, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+    }
+
+    for (i = 0; i < log2_proc; i++)
+        pSync[i] = SHMEM_SYNC_VALUE;
+    *pSync_extra_peer = SHMEM_SYNC_VALUE;
 }
 
 
-/* Ring algorithm, in which every process sends only to its next
- * highest neighbor, each time sending the data it received in the
- * previous iteration.  This algorithm works regardless of process
- * count and is efficient at larger message sizes.
+/*****************************************
  *
- *   (p - 1) alpha + ((p - 1)/p)n beta
+ * SCAN (prefix reduction)
+ *
+ *****************************************/
+
+/* Recursive doubling scan.  In step k, each PE sends the reduction of the
+ * 2^k contributions ending at itself to the PE 2^k above it, which combines
+ * it with its own partial result.  The target buffer is used to receive
+ * data, so in each step the receiver first signals that it is ready and
+ * the sender waits for that signal before writing.
+ *
+ *   log(p) alpha + log(p) n beta + log(p) n gamma
+ *
+ * pSync usage, as int slots: [2k] ready for step k, [2k+1] data arrived
  */
 void
-shmem_internal_fcollect_ring(void *target, const void *source, size_t len,
-                             int PE_start, int PE_stride, int PE_size, long *pSync)
+shmem_internal_scan_recdbl(shmem_ctx_t ctx,
+                           void *target, const void *source, size_t count, size_t type_size,
+                           int PE_start, int PE_stride, int PE_size, long *pSync,
+                           shm_internal_op_t op, shm_internal_datatype_t datatype,
+                           int exclusive)
 {
-    int i;
-    /* my_id is the index in a theoretical 0...N-1 array of
-       participating tasks */
-    int my_id = ((shmem_internal_my_pe - PE_start) / PE_stride);
-    int next_proc = PE_start + ((my_id + 1) % PE_size) * PE_stride;
+    const int my_id = shmem_internal_as_rank(PE_start, PE_stride, shmem_internal_my_pe);
+    const size_t len = count * type_size;
+    int *pSync_ints = (int *) pSync;
+    int one = 1, zero = 0;
+    int have_excl = 0;
     long completion = 0;
-    long zero = 0, one = 1;
+    int i, distance;
+    uint8_t *acc, *excl;
 
-    /* need 1 slot */
-    shmem_internal_assert(SHMEM_COLLECT_SYNC_SIZE >= 1);
+    /* need 2 int slots for each of up to sizeof(int) * 8 - 1 steps */
+    shmem_internal_assert(SHMEM_REDUCE_SYNC_SIZE * (sizeof(long) / sizeof(int)) >=
+                          2 * (sizeof(int) * 8 - 1));
 
-    if (len == 0) return;
+    if (count == 0) return;
 
-    /* copy my portion to the right place */
-    shmem_internal_copy_self((char*) target + (my_id * len), source, len);
+    if (PE_size == 1) {
+        if (!exclusive && target != source)
+            shmem_internal_copy_self(target, source, len);
+        return;
+    }
 
-    /* send n - 1 messages to the next highest proc.  Each message
-       contains what we received the previous step (including our own
-       data for step 1). */
-    for (i = 1 ; i < PE_size ; ++i) {
-        size_t iter_offset = ((my_id + 1 - i + PE_size) % PE_size) * len;
+    /* acc holds the reduction of the contributions received so far,
+     * including our own, and excl the same without our own */
+    acc = malloc(exclusive ? 2 * len : len);
+    if (NULL == acc)
+        RAISE_ERROR_MSG("Unable to allocate %zub temporary buffer\n",
+                        exclusive ? 2 * len : len);
+    excl = acc + len;
+
+    memcpy(acc, source, len);
+
+    for (i = 0, distance = 1 ; distance < PE_size ; i++, distance <<= 1) {
+        int *ready   = &pSync_ints[2 * i];
+        int *arrived = &pSync_ints[2 * i + 1];
+        int send_to  = (my_id + distance < PE_size) ?
+                       shmem_internal_as_pe(PE_start, PE_stride, my_id + distance) : -1;
+        int recv_from = (my_id - distance >= 0) ?
+                        shmem_internal_as_pe(PE_start, PE_stride, my_id - distance) : -1;
+
+        /* target is free, previous step's data has been consumed */
+        if (recv_from >= 0) {
+            shmem_internal_put_scalar(ctx, ready, &one, sizeof(int),
+                                      recv_from);
+        }
 
-        /* send data to me + 1 */
-        shmem_internal_put_nb(SHMEM_CTX_DEFAULT, (char*) target + iter_offset, (char*) target + iter_offset,
-                             len, next_proc, &completion);
-        shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
-        shmem_internal_fence(SHMEM_CTX_DEFAULT);
+        if (send_to >= 0) {
+            SHMEM_WAIT_UNTIL(ready, SHMEM_CMP_EQ, 1);
+            shmem_internal_put_scalar(ctx, ready, &zero, sizeof(int),
+                                      shmem_internal_my_pe);
+            SHMEM_WAIT_UNTIL(ready, SHMEM_CMP_EQ, 0);
 
-        /* send completion for this round to next proc.  Note that we
-           only ever sent to next_proc and there's a shmem_fence
-           between successive calls to the put above.  So a rolling
-           counter is safe here. */
-        shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(long),
-                              next_proc, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+            shmem_internal_put_nb(ctx, target, acc, len, send_to,
+                                  &completion);
+            shmem_internal_put_wait(ctx, &completion);
+            shmem_internal_fence(ctx);
+            shmem_internal_put_scalar(ctx, arrived, &one, sizeof(int),
+                                      send_to);
+        }
 
-        /* wait for completion for this round */
-        SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_GE, i);
+        if (recv_from >= 0) {
+            SHMEM_WAIT_UNTIL(arrived, SHMEM_CMP_EQ, 1);
+            shmem_internal_put_scalar(ctx, arrived, &zero, sizeof(int),
+                                      shmem_internal_my_pe);
+            SHMEM_WAIT_UNTIL(arrived, SHMEM_CMP_EQ, 0);
+
+            if (exclusive) {
+                if (have_excl) {
+                    shmem_internal_reduce_local(op, datatype, count, target, excl);
+                } else {
+                    memcpy(excl, target, len);
+                    have_excl = 1;
+                }
+            }
+            shmem_internal_reduce_local(op, datatype, count, target, acc);
+        }
     }
 
-    /* zero out psync */
-    shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &zero, sizeof(long), shmem_internal_my_pe);
-    SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
+    /* The target of the first PE is not modified by an exclusive scan */
+    if (!exclusive)
+        memcpy(target, acc, len);
+    else if (have_excl)
+        memcpy(target, excl, len);
+
+    free(acc);
 }
 
 
-/* recursive doubling algorithm.  Pairs of doubling distance send
- * doubling amounts of data at each step.  This implementation only
- * supports power of two processes and is less efficient than the ring
- * algorithm at large messages.
+/* Pipelined chain scan.  PE i waits for the prefix of PE i - 1 to arrive
+ * in its target, one segment at a time, combines it with its own
+ * contribution and forwards the result to PE i + 1.  Each segment is
+ * written to its final location, so only the first write into the target
+ * of the next PE needs to be gated on that PE having entered the scan.
  *
- *   log(p) alpha + (p-1)/p n beta
+ *   (p + n/s) alpha + (1 + (p-1)s/n) n beta + n gamma,  s = segment size
+ *
+ * pSync usage: [0] ready, [1] number of segments arrived
  */
 void
-shmem_internal_fcollect_recdbl(void *target, const void *source, size_t len,
-                               int PE_start, int PE_stride, int PE_size, long *pSync)
+shmem_internal_scan_ring(shmem_ctx_t ctx,
+                         void *target, const void *source, size_t count, size_t type_size,
+                         int PE_start, int PE_stride, int PE_size, long *pSync,
+                         shm_internal_op_t op, shm_internal_datatype_t datatype,
+                         int exclusive)
 {
-    int my_id = ((shmem_internal_my_pe - PE_start) / PE_stride);
-    int i;
+    const int my_id = shmem_internal_as_rank(PE_start, PE_stride, shmem_internal_my_pe);
+    const size_t len = count * type_size;
+    const int prev = (my_id > 0) ? shmem_internal_as_pe(PE_start, PE_stride, my_id - 1) : -1;
+    const int next = (my_id < PE_size - 1) ?
+                     shmem_internal_as_pe(PE_start, PE_stride, my_id + 1) : -1;
+    size_t seg_count = shmem_internal_params.SCAN_SEGMENT_SIZE / type_size;
+    size_t offset, nelems;
+    long one = 1, zero = 0, step = 0;
     long completion = 0;
-    size_t curr_offset;
-    int *pSync_ints = (int*) pSync;
-    int one = 1, neg_one = -1;
-    int distance;
+    const uint8_t *src = source;
+    uint8_t *tmp = NULL, *fwd_buf = NULL;
 
-    /* need log2(num_procs) int slots.  max_num_procs is
-       2^(sizeof(int)*8-1)-1, so make the math a bit easier and assume
-       2^(sizeof(int) * 8), which means log2(num_procs) is always less
-       than sizeof(int) * 8. */
-    /* Note: pSync can be treated as a byte array rather than an int array to
-     * get better cache locality.  We chose int here for portability, since SUM
-     * on INT is required by the SHMEM atomics API. */
-    shmem_internal_assert(SHMEM_COLLECT_SYNC_SIZE >= (sizeof(int) * 8) / (sizeof(long) / sizeof(int)));
-    shmem_internal_assert(0 == (PE_size & (PE_size - 1)));
+    /* need 2 slots */
+    shmem_internal_assert(SHMEM_REDUCE_SYNC_SIZE >= 2);
 
-    if (len == 0) return;
+    if (count == 0) return;
 
-    /* copy my portion to the right place */
-    curr_offset = my_id * len;
-    shmem_internal_copy_self((char*) target + curr_offset, source, len);
+    if (PE_size == 1) {
+        if (!exclusive && target != source)
+            shmem_internal_copy_self(target, source, len);
+        return;
+    }
 
-    for (i = 0, distance = 0x1 ; distance < PE_size ; i++, distance <<= 1) {
-        int peer = my_id ^ distance;
-        int real_peer = PE_start + (peer * PE_stride);
+    if (seg_count == 0) seg_count = 1;
 
-        /* send data to peer */
-        shmem_internal_put_nb(SHMEM_CTX_DEFAULT, (char*) target + curr_offset, (char*) target + curr_offset,
-                              distance * len, real_peer, &completion);
-        shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
-        shmem_internal_fence(SHMEM_CTX_DEFAULT);
+    /* The target receives the prefix of the previous PE, keep a copy of
+     * the source if it is about to be overwritten */
+    if (target == source && prev >= 0) {
+        tmp = malloc(len);
+        if (NULL == tmp)
+            RAISE_ERROR_MSG("Unable to allocate %zub temporary buffer\n", len);
+        memcpy(tmp, source, len);
+        src = tmp;
+    }
 
-        /* mark completion for this round */
-        shmem_internal_atomic(SHMEM_CTX_DEFAULT, &pSync_ints[i], &one, sizeof(int),
-                              real_peer, SHM_INTERNAL_SUM, SHM_INTERNAL_INT);
+    /* Exclusive scan leaves the incoming prefix in the target, the
+     * inclusive prefix is computed in a separate buffer to be forwarded */
+    if (exclusive && prev >= 0 && next >= 0) {
+        fwd_buf = malloc(seg_count * type_size);
+        if (NULL == fwd_buf)
+            RAISE_ERROR_MSG("Unable to allocate %zub temporary buffer\n",
+                            seg_count * type_size);
+    }
 
-        SHMEM_WAIT_UNTIL(&pSync_ints[i], SHMEM_CMP_NE, 0);
+    if (prev >= 0) {
+        shmem_internal_put_scalar(ctx, &pSync[0], &one, sizeof(long), prev);
+    }
 
-        /* this slot is no longer used, so subtract off results now */
-        shmem_internal_atomic(SHMEM_CTX_DEFAULT, &pSync_ints[i], &neg_one, sizeof(int),
-                              shmem_internal_my_pe, SHM_INTERNAL_SUM, SHM_INTERNAL_INT);
+    if (next >= 0) {
+        SHMEM_WAIT_UNTIL(&pSync[0], SHMEM_CMP_EQ, 1);
+        shmem_internal_put_scalar(ctx, &pSync[0], &zero, sizeof(long),
+                                  shmem_internal_my_pe);
+        SHMEM_WAIT_UNTIL(&pSync[0], SHMEM_CMP_EQ, 0);
+    }
 
-        if (my_id > peer) {
-            curr_offset -= (distance * len);
+    for (offset = 0 ; offset < count ; offset += nelems) {
+        uint8_t *target_seg = (uint8_t *) target + offset * type_size;
+        const uint8_t *src_seg = src + offset * type_size;
+        const void *fwd = src_seg;
+
+        nelems = (count - offset < seg_count) ? count - offset : seg_count;
+
+        if (prev < 0) {
+            if (!exclusive && target != source)
+                memcpy(target_seg, src_seg, nelems * type_size);
+        } else {
+            SHMEM_WAIT_UNTIL(&pSync[1], SHMEM_CMP_GE, step + 1);
+
+            if (exclusive) {
+                if (next >= 0) {
+                    memcpy(fwd_buf, target_seg, nelems * type_size);
+                    shmem_internal_reduce_local(op, datatype, nelems, (void *) src_seg,
+                                                fwd_buf);
+                    fwd = fwd_buf;
+                }
+            } else {
+                shmem_internal_reduce_local(op, datatype, nelems, (void *) src_seg,
+                                            target_seg);
+                fwd = target_seg;
+            }
+        }
+
+        step++;
+
+        if (next >= 0) {
+            shmem_internal_put_nb(ctx, target_seg, fwd, nelems * type_size,
+                                  next, &completion);
+            shmem_internal_put_wait(ctx, &completion);
+            shmem_internal_fence(ctx);
+            shmem_internal_put_scalar(ctx, &pSync[1], &step, sizeof(long),
+                                      next);
         }
     }
 
-    shmem_internal_quiet(SHMEM_CTX_DEFAULT);
+    if (prev >= 0) {
+        shmem_internal_put_scalar(ctx, &pSync[1], &zero, sizeof(long),
+                                  shmem_internal_my_pe);
+        SHMEM_WAIT_UNTIL(&pSync[1], SHMEM_CMP_EQ, 0);
+    }
+
+    free(tmp);
+    free(fwd_buf);
 }
 
 
+/*****************************************
+ *
+ * COLLECT (variable size)
+ *
+ *****************************************/
 void
-shmem_internal_alltoall(void *dest, const void *source, size_t len,
-                        int PE_start, int PE_stride, int PE_size, long *pSync)
+shmem_internal_collect_linear(shmem_ctx_t ctx, void *target, const void *source, size_t len,
+                              int PE_start, int PE_stride, int PE_size, long *pSync)
 {
-    const int my_as_rank = (shmem_internal_my_pe - PE_start) / PE_stride;
-    const void *dest_ptr = (uint8_t *) dest + my_as_rank * len;
+    size_t my_offset;
+    long tmp[2];
     int peer, start_pe, i;
 
-    shmem_internal_assert(SHMEM_ALLTOALL_SYNC_SIZE >= SHMEM_BARRIER_SYNC_SIZE);
+    /* Need 2 for lengths and barrier for completion */
+    shmem_internal_assert(SHMEM_COLLECT_SYNC_SIZE >= 2 + SHMEM_BARRIER_SYNC_SIZE);
 
-    if (0 == len)
+    DEBUG_MSG("target=%p, source=%p, len=%zd, PE_Start=%d, PE_stride=%d, PE_size=%d, pSync=%p\n",
+              target, source, len, PE_start, PE_stride, PE_size, (void*) pSync);
+
+    if (PE_size == 1) {
+        if (target != source) shmem_internal_copy_self(target, source, len);
         return;
+    }
+
+    /* Linear prefix sum -- propagate update lengths and calculate offset */
+    if (PE_start == shmem_internal_my_pe) {
+        my_offset = 0;
+        tmp[0] = (long) len; /* FIXME: Potential truncation of size_t into long */
+        tmp[1] = 1; /* FIXME: Packing flag with data relies on byte ordering */
+        shmem_internal_put_scalar(ctx, pSync, tmp, 2 * sizeof(long),
+                                  shmem_internal_as_pe(PE_start, PE_stride, 1));
+    }
+    else {
+        /* wait for send data */
+        SHMEM_WAIT_UNTIL(&pSync[1], SHMEM_CMP_EQ, 1);
+        my_offset = pSync[0];
+
+        /* Not the last guy, so send offset to next PE */
+        int my_id = shmem_internal_as_rank(PE_start, PE_stride, shmem_internal_my_pe);
+        if (my_id < PE_size - 1) {
+            tmp[0] = (long) (my_offset + len);
+            tmp[1] = 1;
+            shmem_internal_put_scalar(ctx, pSync, tmp, 2 * sizeof(long),
+                                     shmem_internal_as_pe(PE_start, PE_stride, my_id + 1));
+        }
+    }
 
     /* Send data round-robin, ending with my PE */
     start_pe = shmem_internal_circular_iter_next(shmem_internal_my_pe,
@@ -1229,42 +1978,93 @@ shmem_internal_alltoall(void *dest, const void *source, size_t len,
                                                  PE_size);
     peer = start_pe;
     do {
-        int peer_as_rank = (peer - PE_start) / PE_stride; /* Peer's index in active set */
-
-        shmem_internal_put_nbi(SHMEM_CTX_DEFAULT, (void *) dest_ptr, (uint8_t *) source + peer_as_rank * len,
-                              len, peer);
+        if (len > 0) {
+            shmem_internal_put_nbi(ctx, ((uint8_t *) target) + my_offset, source,
+                                  len, peer);
+        }
         peer = shmem_internal_circular_iter_next(peer, PE_start, PE_stride,
                                                  PE_size);
     } while (peer != start_pe);
 
-    shmem_internal_barrier(PE_start, PE_stride, PE_size, pSync);
+    shmem_internal_barrier(ctx, PE_start, PE_stride, PE_size, &pSync[2]);
+
+    pSync[0] = SHMEM_SYNC_VALUE;
+    pSync[1] = SHMEM_SYNC_VALUE;
 
     for (i = 0; i < SHMEM_BARRIER_SYNC_SIZE; i++)
-        pSync[i] = SHMEM_SYNC_VALUE;
+        pSync[2+i] = SHMEM_SYNC_VALUE;
 }
 
 
-void
-shmem_internal_alltoalls(void *dest, const void *source, ptrdiff_t dst,
-                         ptrdiff_t sst, size_t elem_size, size_t nelems,
-                         int PE_start, int PE_stride, int PE_size, long *pSync)
+/* Compute this PE's offset into the collect target and the total size of
+ * the collected data.  Offsets are propagated with a linear prefix sum and
+ * the last PE in the chain broadcasts the total.  The broadcast is not
+ * completed at the root, so the root can still have puts to [2] and [3]
+ * in flight when it starts the exchange; exchanges therefore only use
+ * slots from [4] on.
+ *
+ * pSync usage: [0] offset, [1] offset flag, [2] broadcast, [3] total
+ */
+static void
+shmem_internal_collect_offsets(shmem_ctx_t ctx, size_t len, int PE_start, int PE_stride,
+                               int PE_size, long *pSync, size_t *my_offset,
+                               size_t *total)
 {
-    const int my_as_rank = (shmem_internal_my_pe - PE_start) / PE_stride;
-    const void *dest_base = (uint8_t *) dest + my_as_rank * nelems * dst * elem_size;
-    int peer, start_pe, i;
+    long tmp[2];
+    long zero = 0;
+    int my_id = shmem_internal_as_rank(PE_start, PE_stride, shmem_internal_my_pe);
 
-    shmem_internal_assert(SHMEM_ALLTOALLS_SYNC_SIZE >= SHMEM_BARRIER_SYNC_SIZE);
+    if (PE_start == shmem_internal_my_pe) {
+        *my_offset = 0;
+    } else {
+        /* wait for send data */
+        SHMEM_WAIT_UNTIL(&pSync[1], SHMEM_CMP_EQ, 1);
+        *my_offset = pSync[0];
 
-    if (0 == nelems)
-        return;
+        tmp[0] = tmp[1] = 0;
+        shmem_internal_put_scalar(ctx, pSync, tmp, 2 * sizeof(long),
+                                  shmem_internal_my_pe);
+        SHMEM_WAIT_UNTIL(&pSync[1], SHMEM_CMP_EQ, 0);
+    }
 
-    /* Implementation note: Neither OFI nor Portals presently has support for
-     * noncontiguous data at the target of a one-sided operation.  I'm not sure
-     * of the best communication schedule for the resulting doubly-nested
-     * all-to-all.  It may be preferable in some scenarios to exchange the
-     * loops below to spread out the communication and decrease the exposure to
-     * incast.
-     */
+    if (my_id != PE_size - 1) {
+        tmp[0] = (long) (*my_offset + len); /* FIXME: Potential truncation of size_t into long */
+        tmp[1] = 1;
+        shmem_internal_put_scalar(ctx, pSync, tmp, 2 * sizeof(long),
+                                  shmem_internal_as_pe(PE_start, PE_stride, my_id + 1));
+        shmem_internal_bcast(ctx, &pSync[3], &pSync[3], sizeof(long), PE_size - 1,
+                             PE_start, PE_stride, PE_size, &pSync[2], 0);
+        *total = (size_t) pSync[3];
+
+        shmem_internal_put_scalar(ctx, &pSync[3], &zero, sizeof(long),
+                                  shmem_internal_my_pe);
+        SHMEM_WAIT_UNTIL(&pSync[3], SHMEM_CMP_EQ, 0);
+    } else {
+        tmp[0] = (long) (*my_offset + len);
+        shmem_internal_bcast(ctx, &pSync[3], tmp, sizeof(long), PE_size - 1,
+                             PE_start, PE_stride, PE_size, &pSync[2], 0);
+        *total = *my_offset + len;
+    }
+}
+
+
+/* Exchange the blocks of a collect once the offsets are known: every PE
+ * puts its block to every other PE, followed by an increment of the peer's
+ * arrival counter.  A barrier would need SHMEM_BARRIER_SYNC_SIZE slots clear
+ * of the offset broadcast, which a fast peer can still be writing to.  The
+ * counter is not written again before every PE has received the total of
+ * the next collect, so this PE has left the current one by then.
+ *
+ * pSync usage: [4] arrival counter
+ */
+static void
+shmem_internal_collect_exchange_linear(shmem_ctx_t ctx,
+                                       void *target, const void *source, size_t len,
+                                       size_t my_offset, int PE_start, int PE_stride,
+                                       int PE_size, long *pSync)
+{
+    int peer, start_pe;
+    long one = 1, zero = 0;
 
     /* Send data round-robin, ending with my PE */
     start_pe = shmem_internal_circular_iter_next(shmem_internal_my_pe,
@@ -1272,24 +2072,1584 @@ shmem_internal_alltoalls(void *dest, const void *source, ptrdiff_t dst,
                                                  PE_size);
     peer = start_pe;
     do {
-        size_t i;
-        int peer_as_rank    = (peer - PE_start) / PE_stride; /* Peer's index in active set */
-        uint8_t *dest_ptr   = (uint8_t *) dest_base;
-        uint8_t *source_ptr = (uint8_t *) source + peer_as_rank * nelems * sst * elem_size;
+        if (len > 0) {
+            shmem_internal_put_nbi(ctx, ((uint8_t *) target) + my_offset, source,
+                                  len, peer);
+        }
+        peer = shmem_internal_circular_iter_next(peer, PE_start, PE_stride,
+                                                 PE_size);
+    } while (peer != start_pe);
 
-        for (i = nelems ; i > 0; i--) {
-            shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, (void *) dest_ptr, (uint8_t *) source_ptr,
-                                     elem_size, peer);
+    shmem_internal_fence(ctx);
 
-            source_ptr += sst * elem_size;
-            dest_ptr   += dst * elem_size;
-        }
+    peer = start_pe;
+    do {
+        if (peer != shmem_internal_my_pe)
+            shmem_internal_atomic(ctx, &pSync[4], &one, sizeof(long), peer,
+                                  SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
         peer = shmem_internal_circular_iter_next(peer, PE_start, PE_stride,
                                                  PE_size);
     } while (peer != start_pe);
 
-    shmem_internal_barrier(PE_start, PE_stride, PE_size, pSync);
+    /* Complete the puts from source before returning */
+    shmem_internal_quiet(ctx);
 
-    for (i = 0; i < SHMEM_BARRIER_SYNC_SIZE; i++)
-        pSync[i] = SHMEM_SYNC_VALUE;
+    SHMEM_WAIT_UNTIL(&pSync[4], SHMEM_CMP_EQ, PE_size - 1);
+
+    shmem_internal_put_scalar(ctx, &pSync[4], &zero, sizeof(long),
+                              shmem_internal_my_pe);
+    SHMEM_WAIT_UNTIL(&pSync[4], SHMEM_CMP_EQ, 0);
+}
+
+
+/* Ring exchange of variable sized blocks.  In step i, each PE forwards the
+ * block it received in step i - 1 (its own block in step 1) to the next PE,
+ * followed by the offset and length of that block.  Because the metadata
+ * slots are reused in every step, the receiver returns a credit once it has
+ * read them and the sender waits for that credit before overwriting them.
+ *
+ *   2(p-1) alpha + (p-1)/p n beta
+ *
+ * pSync usage: [4] block offset, [5] block length, [6] step, [7] credit
+ */
+static void
+shmem_internal_collect_exchange_ring(shmem_ctx_t ctx, void *target, size_t len, size_t my_offset,
+                                     int PE_start, int PE_stride, int PE_size,
+                                     long *pSync)
+{
+    int i;
+    /* my_id is the index in a theoretical 0...N-1 array of
+       participating tasks */
+    int my_id = shmem_internal_as_rank(PE_start, PE_stride, shmem_internal_my_pe);
+    int next_proc = shmem_internal_as_pe(PE_start, PE_stride, (my_id + 1) % PE_size);
+    int prev_proc = shmem_internal_as_pe(PE_start, PE_stride, (my_id - 1 + PE_size) % PE_size);
+    size_t blk_offset = my_offset, blk_len = len;
+    long completion = 0;
+    long meta[4];
+
+    for (i = 1 ; i < PE_size ; ++i) {
+        /* send the block received in the previous step to me + 1 */
+        if (blk_len > 0) {
+            shmem_internal_put_nb(ctx, (char*) target + blk_offset,
+                                  (char*) target + blk_offset, blk_len, next_proc,
+                                  &completion);
+            shmem_internal_put_wait(ctx, &completion);
+        }
+
+        /* wait until me + 1 has read the previous block's metadata */
+        if (i > 1) SHMEM_WAIT_UNTIL(&pSync[7], SHMEM_CMP_GE, i - 1);
+
+        meta[0] = (long) blk_offset;
+        meta[1] = (long) blk_len;
+        shmem_internal_put_scalar(ctx, &pSync[4], meta, 2 * sizeof(long),
+                                  next_proc);
+        shmem_internal_fence(ctx);
+
+        meta[2] = i;
+        shmem_internal_put_scalar(ctx, &pSync[6], &meta[2], sizeof(long),
+                                  next_proc);
+
+        /* wait for the block from me - 1 */
+        SHMEM_WAIT_UNTIL(&pSync[6], SHMEM_CMP_GE, i);
+        blk_offset = (size_t) pSync[4];
+        blk_len = (size_t) pSync[5];
+
+        if (i == PE_size - 1) {
+            /* last step, nothing more will be written to the metadata
+             * slots in this collective */
+            meta[0] = meta[1] = meta[2] = 0;
+            shmem_internal_put_scalar(ctx, &pSync[4], meta, 3 * sizeof(long),
+                                      shmem_internal_my_pe);
+            SHMEM_WAIT_UNTIL(&pSync[6], SHMEM_CMP_EQ, 0);
+        }
+
+        /* return the credit to me - 1 */
+        meta[3] = i;
+        shmem_internal_put_scalar(ctx, &pSync[7], &meta[3], sizeof(long),
+                                  prev_proc);
+    }
+
+    SHMEM_WAIT_UNTIL(&pSync[7], SHMEM_CMP_EQ, PE_size - 1);
+
+    meta[0] = 0;
+    shmem_internal_put_scalar(ctx, &pSync[7], meta, sizeof(long),
+                              shmem_internal_my_pe);
+    SHMEM_WAIT_UNTIL(&pSync[7], SHMEM_CMP_EQ, 0);
+}
+
+
+/* Maximum number of recursive doubling steps that fit in the collect pSync
+ * after the slots used by shmem_internal_collect_offsets */
+#define COLLECT_RECDBL_MAX_STEPS (SHMEM_COLLECT_SYNC_SIZE - 4)
+
+static inline int
+shmem_internal_collect_recdbl_supported(int PE_size)
+{
+    return 0 == (PE_size & (PE_size - 1)) &&
+           PE_size <= (1 << COLLECT_RECDBL_MAX_STEPS);
+}
+
+
+/* Recursive doubling exchange of variable sized blocks.  At step k, each PE
+ * holds the contiguous range of the target contributed by its group of 2^k
+ * PEs and swaps it with the partner group.  The partner's range is adjacent
+ * to our own, so only its far boundary needs to be sent, which is done in a
+ * per-step pSync slot (biased by one so zero means "not arrived").
+ * Requires a power of two number of PEs.
+ *
+ *   log(p) alpha + (p-1)/p n beta
+ *
+ * pSync usage: [4 .. 4 + log2(PE_size)) step boundaries
+ */
+static void
+shmem_internal_collect_exchange_recdbl(shmem_ctx_t ctx, void *target, size_t len, size_t my_offset,
+                                       int PE_start, int PE_stride, int PE_size,
+                                       long *pSync)
+{
+    int my_id = shmem_internal_as_rank(PE_start, PE_stride, shmem_internal_my_pe);
+    int i, distance;
+    long completion = 0;
+    long boundary, zero = 0;
+    size_t lo = my_offset, hi = my_offset + len;
+
+    shmem_internal_assert(shmem_internal_collect_recdbl_supported(PE_size));
+
+    for (i = 0, distance = 0x1 ; distance < PE_size ; i++, distance <<= 1) {
+        int peer = my_id ^ distance;
+        int real_peer = shmem_internal_as_pe(PE_start, PE_stride, peer);
+
+        /* send data to peer */
+        if (hi > lo) {
+            shmem_internal_put_nb(ctx, (char*) target + lo, (char*) target + lo,
+                                  hi - lo, real_peer, &completion);
+            shmem_internal_put_wait(ctx, &completion);
+        }
+        shmem_internal_fence(ctx);
+
+        /* send the boundary the peer does not know about */
+        boundary = (long) ((peer < my_id) ? hi : lo) + 1;
+        shmem_internal_put_scalar(ctx, &pSync[4 + i], &boundary, sizeof(long),
+                                  real_peer);
+
+        SHMEM_WAIT_UNTIL(&pSync[4 + i], SHMEM_CMP_NE, 0);
+
+        if (peer < my_id) {
+            lo = (size_t) (pSync[4 + i] - 1);
+        } else {
+            hi = (size_t) (pSync[4 + i] - 1);
+        }
+
+        /* this slot is no longer used in this collective */
+        shmem_internal_put_scalar(ctx, &pSync[4 + i], &zero, sizeof(long),
+                                  shmem_internal_my_pe);
+        SHMEM_WAIT_UNTIL(&pSync[4 + i], SHMEM_CMP_EQ, 0);
+    }
+}
+
+
+void
+shmem_internal_collect_ring(shmem_ctx_t ctx, void *target, const void *source, size_t len,
+                            int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    size_t my_offset, total;
+
+    /* Need 4 for offsets and 4 for the ring metadata */
+    shmem_internal_assert(SHMEM_COLLECT_SYNC_SIZE >= 8);
+
+    DEBUG_MSG("target=%p, source=%p, len=%zd, PE_Start=%d, PE_stride=%d, PE_size=%d, pSync=%p\n",
+              target, source, len, PE_start, PE_stride, PE_size, (void*) pSync);
+
+    if (PE_size == 1) {
+        if (target != source) shmem_internal_copy_self(target, source, len);
+        return;
+    }
+
+    shmem_internal_collect_offsets(ctx, len, PE_start, PE_stride, PE_size, pSync,
+                                   &my_offset, &total);
+
+    if (total == 0) return;
+
+    /* copy my portion to the right place */
+    if (len > 0)
+        shmem_internal_copy_self((char*) target + my_offset, source, len);
+
+    shmem_internal_collect_exchange_ring(ctx, target, len, my_offset, PE_start,
+                                         PE_stride, PE_size, pSync);
+}
+
+
+/* Falls back to the ring exchange if the number of PEs is not a power of
+ * two or is too large for the pSync to hold all steps */
+void
+shmem_internal_collect_recdbl(shmem_ctx_t ctx, void *target, const void *source, size_t len,
+                              int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    size_t my_offset, total;
+
+    shmem_internal_assert(SHMEM_COLLECT_SYNC_SIZE >= 8);
+
+    DEBUG_MSG("target=%p, source=%p, len=%zd, PE_Start=%d, PE_stride=%d, PE_size=%d, pSync=%p\n",
+              target, source, len, PE_start, PE_stride, PE_size, (void*) pSync);
+
+    if (PE_size == 1) {
+        if (target != source) shmem_internal_copy_self(target, source, len);
+        return;
+    }
+
+    shmem_internal_collect_offsets(ctx, len, PE_start, PE_stride, PE_size, pSync,
+                                   &my_offset, &total);
+
+    if (total == 0) return;
+
+    if (len > 0)
+        shmem_internal_copy_self((char*) target + my_offset, source, len);
+
+    if (shmem_internal_collect_recdbl_supported(PE_size)) {
+        shmem_internal_collect_exchange_recdbl(ctx, target, len, my_offset, PE_start,
+                                               PE_stride, PE_size, pSync);
+    } else {
+        shmem_internal_collect_exchange_ring(ctx, target, len, my_offset, PE_start,
+                                             PE_stride, PE_size, pSync);
+    }
+}
+
+
+/* Select the exchange once the total size is known, since the local
+ * contribution may differ between PEs but the total does not.  Small
+ * collects use direct puts; larger ones use recursive doubling when the
+ * PE count permits it and the ring otherwise. */
+void
+shmem_internal_collect_auto(shmem_ctx_t ctx, void *target, const void *source, size_t len,
+                            int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    size_t my_offset, total;
+
+    shmem_internal_assert(SHMEM_COLLECT_SYNC_SIZE >= 8);
+
+    DEBUG_MSG("target=%p, source=%p, len=%zd, PE_Start=%d, PE_stride=%d, PE_size=%d, pSync=%p\n",
+              target, source, len, PE_start, PE_stride, PE_size, (void*) pSync);
+
+    if (PE_size == 1) {
+        if (target != source) shmem_internal_copy_self(target, source, len);
+        return;
+    }
+
+    shmem_internal_collect_offsets(ctx, len, PE_start, PE_stride, PE_size, pSync,
+                                   &my_offset, &total);
+
+    if (total == 0) return;
+
+    if (total / PE_size < shmem_internal_params.COLL_SIZE_CROSSOVER) {
+        shmem_internal_collect_exchange_linear(ctx, target, source, len, my_offset,
+                                               PE_start, PE_stride, PE_size, pSync);
+        return;
+    }
+
+    if (len > 0)
+        shmem_internal_copy_self((char*) target + my_offset, source, len);
+
+    if (shmem_internal_collect_recdbl_supported(PE_size)) {
+        shmem_internal_collect_exchange_recdbl(ctx, target, len, my_offset, PE_start,
+                                               PE_stride, PE_size, pSync);
+    } else {
+        shmem_internal_collect_exchange_ring(ctx, target, len, my_offset, PE_start,
+                                             PE_stride, PE_size, pSync);
+    }
+}
+
+
+/*****************************************
+ *
+ * COLLECT (same size)
+ *
+ *****************************************/
+void
+shmem_internal_fcollect_linear(shmem_ctx_t ctx, void *target, const void *source, size_t len,
+                               int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    long tmp = 1;
+    long completion = 0;
+
+    /* need 1 slot, plus bcast */
+    shmem_internal_assert(SHMEM_COLLECT_SYNC_SIZE >= 1 + SHMEM_BCAST_SYNC_SIZE);
+
+    if (PE_start == shmem_internal_my_pe) {
+        /* Copy data into the target */
+        if (source != target) shmem_internal_copy_self(target, source, len);
+
+        /* send completion update */
+        shmem_internal_atomic(ctx, pSync, &tmp, sizeof(long),
+                              PE_start, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+
+        /* wait for N updates */
+        SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, PE_size);
+
+        /* Clear pSync */
+        tmp = 0;
+        shmem_internal_put_scalar(ctx, pSync, &tmp, sizeof(tmp), PE_start);
+        SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
+    } else {
+        /* Push data into the target */
+        size_t offset = shmem_internal_as_rank(PE_start, PE_stride, shmem_internal_my_pe) * len;
+        shmem_internal_put_nb(ctx, (char*) target + offset, source, len, PE_start,
+                              &completion);
+        shmem_internal_put_wait(ctx, &completion);
+
+        /* ensure ordering */
+        shmem_internal_fence(ctx);
+
+        /* send completion update */
+        shmem_internal_atomic(ctx, pSync, &tmp, sizeof(long),
+                              PE_start, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+    }
+
+    shmem_internal_bcast(ctx, target, target, len * PE_size, 0, PE_start, PE_stride,
+                         PE_size, pSync + 1, 0);
+}
+
+
+/* Ring algorithm, in which every process sends only to its next
+ * highest neighbor, each time sending the data it received in the
+ * previous iteration.  This algorithm works regardless of process
+ * count and is efficient at larger message sizes.
+ *
+ *   (p - 1) alpha + ((p - 1)/p)n beta
+ */
+void
+shmem_internal_fcollect_ring(shmem_ctx_t ctx, void *target, const void *source, size_t len,
+                             int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    int i;
+    /* my_id is the index in a theoretical 0...N-1 array of
+       participating tasks */
+    int my_id = shmem_internal_as_rank(PE_start, PE_stride, shmem_internal_my_pe);
+    int next_proc = shmem_internal_as_pe(PE_start, PE_stride, (my_id + 1) % PE_size);
+    long completion = 0;
+    long zero = 0, one = 1;
+
+    /* need 1 slot */
+    shmem_internal_assert(SHMEM_COLLECT_SYNC_SIZE >= 1);
+
+    if (len == 0) return;
+
+    /* copy my portion to the right place */
+    shmem_internal_copy_self((char*) target + (my_id * len), source, len);
+
+    /* send n - 1 messages to the next highest proc.  Each message
+       contains what we received the previous step (including our own
+       data for step 1). */
+    for (i = 1 ; i < PE_size ; ++i) {
+        size_t iter_offset = ((my_id + 1 - i + PE_size) % PE_size) * len;
+
+        /* send data to me + 1 */
+        shmem_internal_put_nb(ctx, (char*) target + iter_offset, (char*) target + iter_offset,
+                             len, next_proc, &completion);
+        shmem_internal_put_wait(ctx, &completion);
+        shmem_internal_fence(ctx);
+
+        /* send completion for this round to next proc.  Note that we
+           only ever sent to next_proc and there's a shmem_fence
+           between successive calls to the put above.  So a rolling
+           counter is safe here. */
+        shmem_internal_atomic(ctx, pSync, &one, sizeof(long),
+                              next_proc, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+
+        /* wait for completion for this round */
+        SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_GE, i);
+    }
+
+    /* zero out psync */
+    shmem_internal_put_scalar(ctx, pSync, &zero, sizeof(long), shmem_internal_my_pe);
+    SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
+}
+
+
+/* recursive doubling algorithm.  Pairs of doubling distance send
+ * doubling amounts of data at each step.  This implementation only
+ * supports power of two processes and is less efficient than the ring
+ * algorithm at large messages.
+ *
+ *   log(p) alpha + (p-1)/p n beta
+ */
+void
+shmem_internal_fcollect_recdbl(shmem_ctx_t ctx, void *target, const void *source, size_t len,
+                               int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    int my_id = shmem_internal_as_rank(PE_start, PE_stride, shmem_internal_my_pe);
+    int i;
+    long completion = 0;
+    size_t curr_offset;
+    int *pSync_ints = (int*) pSync;
+    int one = 1, neg_one = -1;
+    int distance;
+
+    /* need log2(num_procs) int slots.  max_num_procs is
+       2^(sizeof(int)*8-1)-1, so make the math a bit easier and assume
+       2^(sizeof(int) * 8), which means log2(num_procs) is always less
+       than sizeof(int) * 8. */
+    /* Note: pSync can be treated as a byte array rather than an int array to
+     * get better cache locality.  We chose int here for portability, since SUM
+     * on INT is required by the SHMEM atomics API. */
+    shmem_internal_assert(SHMEM_COLLECT_SYNC_SIZE >= (sizeof(int) * 8) / (sizeof(long) / sizeof(int)));
+    shmem_internal_assert(0 == (PE_size & (PE_size - 1)));
+
+    if (len == 0) return;
+
+    /* copy my portion to the right place */
+    curr_offset = my_id * len;
+    shmem_internal_copy_self((char*) target + curr_offset, source, len);
+
+    for (i = 0, distance = 0x1 ; distance < PE_size ; i++, distance <<= 1) {
+        int peer = my_id ^ distance;
+        int real_peer = shmem_internal_as_pe(PE_start, PE_stride, peer);
+
+        /* send data to peer */
+        shmem_internal_put_nb(ctx, (char*) target + curr_offset, (char*) target + curr_offset,
+                              distance * len, real_peer, &completion);
+        shmem_internal_put_wait(ctx, &completion);
+        shmem_internal_fence(ctx);
+
+        /* mark completion for this round */
+        shmem_internal_atomic(ctx, &pSync_ints[i], &one, sizeof(int),
+                              real_peer, SHM_INTERNAL_SUM, SHM_INTERNAL_INT);
+
+        SHMEM_WAIT_UNTIL(&pSync_ints[i], SHMEM_CMP_NE, 0);
+
+        /* this slot is no longer used, so subtract off results now */
+        shmem_internal_atomic(ctx, &pSync_ints[i], &neg_one, sizeof(int),
+                              shmem_internal_my_pe, SHM_INTERNAL_SUM, SHM_INTERNAL_INT);
+
+        if (my_id > peer) {
+            curr_offset -= (distance * len);
+        }
+    }
+
+    shmem_internal_quiet(ctx);
+}
+
+
+/* Bruck algorithm.  In step k, each PE sends the blocks it holds to the PE
+ * 2^k below it.  Because PE i always holds the contiguous (modulo PE_size)
+ * range of blocks starting at block i, the blocks can be written directly
+ * into their final position in the target buffer and no rotation is needed.
+ * Works for any number of PEs.
+ *
+ *   ceil(log(p)) alpha + (p-1)/p n beta
+ */
+void
+shmem_internal_fcollect_bruck(shmem_ctx_t ctx, void *target, const void *source, size_t len,
+                              int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    int my_id = shmem_internal_as_rank(PE_start, PE_stride, shmem_internal_my_pe);
+    int i;
+    long completion = 0;
+    int *pSync_ints = (int*) pSync;
+    int one = 1, neg_one = -1;
+    int distance;
+
+    /* need ceil(log2(num_procs)) int slots, see fcollect_recdbl */
+    shmem_internal_assert(SHMEM_COLLECT_SYNC_SIZE >= (sizeof(int) * 8) / (sizeof(long) / sizeof(int)));
+
+    if (len == 0) return;
+
+    /* copy my portion to the right place */
+    shmem_internal_copy_self((char*) target + my_id * len, source, len);
+
+    for (i = 0, distance = 0x1 ; distance < PE_size ; i++, distance <<= 1) {
+        int peer = (my_id - distance + PE_size) % PE_size;
+        int real_peer = shmem_internal_as_pe(PE_start, PE_stride, peer);
+        int nblocks = (distance < PE_size - distance) ? distance : PE_size - distance;
+        int first = (nblocks < PE_size - my_id) ? nblocks : PE_size - my_id;
+
+        /* send blocks [my_id, my_id + nblocks), which may wrap around */
+        shmem_internal_put_nb(ctx, (char*) target + my_id * len,
+                              (char*) target + my_id * len, first * len, real_peer,
+                              &completion);
+        if (nblocks > first) {
+            shmem_internal_put_nb(ctx, target, target,
+                                  (nblocks - first) * len, real_peer, &completion);
+        }
+        shmem_internal_put_wait(ctx, &completion);
+        shmem_internal_fence(ctx);
+
+        /* mark completion for this round */
+        shmem_internal_atomic(ctx, &pSync_ints[i], &one, sizeof(int),
+                              real_peer, SHM_INTERNAL_SUM, SHM_INTERNAL_INT);
+
+        SHMEM_WAIT_UNTIL(&pSync_ints[i], SHMEM_CMP_NE, 0);
+
+        /* this slot is no longer used, so subtract off results now */
+        shmem_internal_atomic(ctx, &pSync_ints[i], &neg_one, sizeof(int),
+                              shmem_internal_my_pe, SHM_INTERNAL_SUM, SHM_INTERNAL_INT);
+    }
+
+    shmem_internal_quiet(ctx);
+}
+
+
+void
+shmem_internal_alltoall_linear(shmem_ctx_t ctx, void *dest, const void *source, size_t len,
+                               int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    const int my_as_rank = shmem_internal_as_rank(PE_start, PE_stride, shmem_internal_my_pe);
+    const void *dest_ptr = (uint8_t *) dest + my_as_rank * len;
+    int peer, start_pe, i;
+
+    shmem_internal_assert(SHMEM_ALLTOALL_SYNC_SIZE >= SHMEM_BARRIER_SYNC_SIZE);
+
+    if (0 == len)
+        return;
+
+    /* Send data round-robin, ending with my PE */
+    start_pe = shmem_internal_circular_iter_next(shmem_internal_my_pe,
+                                                 PE_start, PE_stride,
+                                                 PE_size);
+    peer = start_pe;
+    do {
+        int peer_as_rank = shmem_internal_as_rank(PE_start, PE_stride, peer); /* Peer's index in active set */
+
+        shmem_internal_put_nbi(ctx, (void *) dest_ptr, (uint8_t *) source + peer_as_rank * len,
+                              len, peer);
+        peer = shmem_internal_circular_iter_next(peer, PE_start, PE_stride,
+                                                 PE_size);
+    } while (peer != start_pe);
+
+    shmem_internal_barrier(ctx, PE_start, PE_stride, PE_size, pSync);
+
+    for (i = 0; i < SHMEM_BARRIER_SYNC_SIZE; i++)
+        pSync[i] = SHMEM_SYNC_VALUE;
+}
+
+
+/* Same round-robin schedule as the linear algorithm, but at most
+ * SHMEM_ALLTOALL_THROTTLE puts are outstanding at any time, which bounds
+ * the amount of data injected toward peers that are already congested. */
+void
+shmem_internal_alltoall_throttle(shmem_ctx_t ctx, void *dest, const void *source, size_t len,
+                                 int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    const int my_as_rank = shmem_internal_as_rank(PE_start, PE_stride, shmem_internal_my_pe);
+    const void *dest_ptr = (uint8_t *) dest + my_as_rank * len;
+    const long window = shmem_internal_params.ALLTOALL_THROTTLE;
+    int peer, start_pe, i;
+    long outstanding = 0;
+
+    shmem_internal_assert(SHMEM_ALLTOALL_SYNC_SIZE >= SHMEM_BARRIER_SYNC_SIZE);
+
+    if (0 == len)
+        return;
+
+    /* Send data round-robin, ending with my PE */
+    start_pe = shmem_internal_circular_iter_next(shmem_internal_my_pe,
+                                                 PE_start, PE_stride,
+                                                 PE_size);
+    peer = start_pe;
+    do {
+        int peer_as_rank = shmem_internal_as_rank(PE_start, PE_stride, peer); /* Peer's index in active set */
+
+        if (window > 0 && outstanding == window) {
+            shmem_internal_quiet(ctx);
+            outstanding = 0;
+        }
+
+        shmem_internal_put_nbi(ctx, (void *) dest_ptr, (uint8_t *) source + peer_as_rank * len,
+                              len, peer);
+        outstanding++;
+
+        peer = shmem_internal_circular_iter_next(peer, PE_start, PE_stride,
+                                                 PE_size);
+    } while (peer != start_pe);
+
+    shmem_internal_barrier(ctx, PE_start, PE_stride, PE_size, pSync);
+
+    for (i = 0; i < SHMEM_BARRIER_SYNC_SIZE; i++)
+        pSync[i] = SHMEM_SYNC_VALUE;
+}
+
+
+/* Pairwise exchange.  In step k each PE sends its block to peer my_id ^ k
+ * (or my_id + k when the PE count is not a power of two), so every PE
+ * receives exactly one block per step.  A PE does not start step k + 1
+ * until it has received k blocks, which keeps the PEs in lock step and
+ * avoids incast.  The receive counter lives in an int slot of the barrier
+ * pSync that none of the barrier algorithms use.
+ *
+ *   (p-1) alpha + (p-1)/p n beta
+ */
+void
+shmem_internal_alltoall_pairwise(shmem_ctx_t ctx, void *dest, const void *source, size_t len,
+                                 int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    const int my_id = shmem_internal_as_rank(PE_start, PE_stride, shmem_internal_my_pe);
+    const int pow2 = (0 == (PE_size & (PE_size - 1)));
+    int *counter = &((int *) pSync)[ALLTOALL_COUNTER_SLOT];
+    long completion = 0;
+    int one = 1, zero = 0;
+    int i;
+
+    shmem_internal_assert(SHMEM_ALLTOALL_SYNC_SIZE >= SHMEM_BARRIER_SYNC_SIZE);
+    shmem_internal_assert(PE_size <= (1 << ALLTOALL_COUNTER_SLOT));
+
+    if (0 == len)
+        return;
+
+    shmem_internal_copy_self((uint8_t *) dest + my_id * len,
+                             (uint8_t *) source + my_id * len, len);
+
+    for (i = 1; i < PE_size; i++) {
+        int peer = pow2 ? my_id ^ i : (my_id + i) % PE_size;
+        int real_peer = shmem_internal_as_pe(PE_start, PE_stride, peer);
+
+        shmem_internal_put_nb(ctx, (uint8_t *) dest + my_id * len,
+                              (uint8_t *) source + peer * len, len, real_peer,
+                              &completion);
+        shmem_internal_put_wait(ctx, &completion);
+        shmem_internal_fence(ctx);
+
+        shmem_internal_atomic(ctx, counter, &one, sizeof(int),
+                              real_peer, SHM_INTERNAL_SUM, SHM_INTERNAL_INT);
+
+        SHMEM_WAIT_UNTIL(counter, SHMEM_CMP_GE, i);
+    }
+
+    /* All blocks have arrived; nobody writes the counter again until the
+     * next alltoall, which cannot start before the barrier below */
+    shmem_internal_put_scalar(ctx, counter, &zero, sizeof(int),
+                              shmem_internal_my_pe);
+    SHMEM_WAIT_UNTIL(counter, SHMEM_CMP_EQ, 0);
+
+    shmem_internal_barrier(ctx, PE_start, PE_stride, PE_size, pSync);
+
+    for (i = 0; i < SHMEM_BARRIER_SYNC_SIZE; i++)
+        pSync[i] = SHMEM_SYNC_VALUE;
+}
+
+
+/* Clear-to-send for the alltoall scratch buffer.  Each PE tells the
+ * npeers PEs that will write into its scratch buffer that it has entered
+ * the collective, by incrementing a counter in their pSync, and then waits
+ * until all npeers PEs it writes to have done the same.  Until then, a
+ * receiver may still be using its scratch buffer for a collective over a
+ * different, overlapping active set.  The pSync is private to the
+ * collective, so the signal cannot be confused with one for another
+ * active set. */
+static void
+shmem_internal_alltoall_scratch_cts(shmem_ctx_t ctx, const int *peers, int npeers,
+                                    long *pSync)
+{
+    int *counter = &((int *) pSync)[ALLTOALL_COUNTER_SLOT];
+    int one = 1, zero = 0;
+    int i;
+
+    for (i = 0; i < npeers; i++)
+        shmem_internal_atomic(ctx, counter, &one, sizeof(int), peers[i],
+                              SHM_INTERNAL_SUM, SHM_INTERNAL_INT);
+
+    SHMEM_WAIT_UNTIL(counter, SHMEM_CMP_EQ, npeers);
+
+    /* Every peer has signaled, nobody writes the counter again until the
+     * next alltoall, which cannot start before the closing barrier */
+    shmem_internal_put_scalar(ctx, counter, &zero, sizeof(int),
+                              shmem_internal_my_pe);
+    SHMEM_WAIT_UNTIL(counter, SHMEM_CMP_EQ, 0);
+}
+
+
+/* The Bruck algorithm shares a single scratch buffer among all active sets
+ * and threads, so it is not used when collectives may be called
+ * concurrently from multiple threads */
+static int
+shmem_internal_alltoall_bruck_ok(size_t len, int PE_size)
+{
+    return NULL != alltoall_scratch &&
+           shmem_internal_thread_level != SHMEM_THREAD_MULTIPLE &&
+           len <= alltoall_scratch_size / (PE_size / 2 + 1);
+}
+
+
+/* Bruck algorithm.  Blocks are rotated so that block i is destined for PE
+ * my_id + i, then in step k every block whose index has bit k set is
+ * forwarded to PE my_id + 2^k.  The blocks sent in each step are packed
+ * into a single message, trading extra copies for log(p) messages instead
+ * of p - 1, which pays off for small blocks.
+ *
+ * Packed blocks are received into the symmetric alltoall_scratch buffer.
+ * Its header holds one "ready" slot per step, set by the receiver once the
+ * data of the previous step has been unpacked, and a data arrival flag.
+ * The receivers of all steps must have entered the collective before the
+ * first step is sent.
+ *
+ *   2 log(p) alpha + log(p)/2 n beta
+ */
+void
+shmem_internal_alltoall_bruck(shmem_ctx_t ctx, void *dest, const void *source, size_t len,
+                              int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    const int my_id = shmem_internal_as_rank(PE_start, PE_stride, shmem_internal_my_pe);
+    long *ready = (long *) alltoall_scratch;
+    long *arrived = &ready[ALLTOALL_SCRATCH_STEPS];
+    uint8_t *recv_buf = (uint8_t *) alltoall_scratch + ALLTOALL_SCRATCH_HDR;
+    uint8_t *tmp, *pack_buf;
+    int senders[ALLTOALL_SCRATCH_STEPS] = { 0 };
+    long completion = 0;
+    long step;
+    int i, k, distance;
+
+    shmem_internal_assert(SHMEM_ALLTOALL_SYNC_SIZE >= SHMEM_BARRIER_SYNC_SIZE);
+    shmem_internal_assert(PE_size <= (1 << ALLTOALL_COUNTER_SLOT));
+
+    if (0 == len)
+        return;
+
+    if (!shmem_internal_alltoall_bruck_ok(len, PE_size)) {
+        shmem_internal_alltoall_linear(ctx, dest, source, len, PE_start, PE_stride,
+                                       PE_size, pSync);
+        return;
+    }
+
+    tmp = malloc(PE_size * len + (PE_size / 2 + 1) * len);
+    if (NULL == tmp)
+        RAISE_ERROR_MSG("Unable to allocate %zub temporary buffer\n",
+                        PE_size * len + (PE_size / 2 + 1) * len);
+    pack_buf = tmp + PE_size * len;
+
+    /* Local rotation, block i is destined for PE my_id + i */
+    for (i = 0; i < PE_size; i++)
+        memcpy(tmp + i * len, (uint8_t *) source + ((my_id + i) % PE_size) * len, len);
+
+    /* In step k, PE my_id - 2^k writes into our scratch buffer */
+    for (k = 0, distance = 1; distance < PE_size; k++, distance <<= 1)
+        senders[k] = shmem_internal_as_pe(PE_start, PE_stride,
+                                          (my_id - distance + PE_size) % PE_size);
+
+    shmem_internal_alltoall_scratch_cts(ctx, senders, k, pSync);
+
+    for (k = 0, distance = 1; distance < PE_size; k++, distance <<= 1) {
+        int dst = shmem_internal_as_pe(PE_start, PE_stride, (my_id + distance) % PE_size);
+        int src = shmem_internal_as_pe(PE_start, PE_stride, (my_id - distance + PE_size) % PE_size);
+        size_t nblocks = 0;
+
+        for (i = 0; i < PE_size; i++) {
+            if (i & distance)
+                memcpy(pack_buf + nblocks++ * len, tmp + i * len, len);
+        }
+
+        step = k + 1;
+
+        /* The receiver's scratch buffer is free once it has given the
+         * clear-to-send, later steps must wait until the receiver has
+         * unpacked the previous one */
+        if (k > 0) {
+            shmem_internal_put_scalar(ctx, &ready[k], &step, sizeof(long), src);
+            SHMEM_WAIT_UNTIL(&ready[k], SHMEM_CMP_EQ, step);
+        }
+
+        shmem_internal_put_nb(ctx, recv_buf, pack_buf, nblocks * len, dst,
+                              &completion);
+        shmem_internal_put_wait(ctx, &completion);
+        shmem_internal_fence(ctx);
+        shmem_internal_put_scalar(ctx, arrived, &step, sizeof(long), dst);
+
+        SHMEM_WAIT_UNTIL(arrived, SHMEM_CMP_GE, step);
+
+        for (i = 0, nblocks = 0; i < PE_size; i++) {
+            if (i & distance)
+                memcpy(tmp + i * len, recv_buf + nblocks++ * len, len);
+        }
+    }
+
+    /* Inverse rotation, block i came from PE my_id - i */
+    for (i = 0; i < PE_size; i++)
+        memcpy((uint8_t *) dest + ((my_id - i + PE_size) % PE_size) * len, tmp + i * len, len);
+
+    free(tmp);
+
+    /* Nobody writes the header again until the next alltoall, which cannot
+     * start before the barrier below */
+    memset(alltoall_scratch, 0, ALLTOALL_SCRATCH_HDR);
+
+    shmem_internal_barrier(ctx, PE_start, PE_stride, PE_size, pSync);
+
+    for (i = 0; i < SHMEM_BARRIER_SYNC_SIZE; i++)
+        pSync[i] = SHMEM_SYNC_VALUE;
+}
+
+
+/* Copy nelems elements of elem_size bytes between strided buffers; strides
+ * are in units of elements, as in the alltoalls API */
+static inline void
+shmem_internal_copy_strided(uint8_t *dest, ptrdiff_t dst, const uint8_t *source,
+                            ptrdiff_t sst, size_t elem_size, size_t nelems)
+{
+    size_t i;
+
+    for (i = 0; i < nelems; i++) {
+        memcpy(dest, source, elem_size);
+        dest   += dst * elem_size;
+        source += sst * elem_size;
+    }
+}
+
+
+/* Strided alltoall.  Rather than sending one message per element, the
+ * elements for each peer are packed into a contiguous buffer and sent as a
+ * single message:
+ *
+ *  - dst == 1: the packed block is put directly into the destination.
+ *  - otherwise, if the blocks of all PEs fit in the alltoall scratch buffer,
+ *    each block is put into the scratch buffer of the peer, followed by an
+ *    increment of its arrival counter, and each PE unpacks the blocks it
+ *    received into the strided destination.  Every peer must have given
+ *    the clear-to-send before the first block is put.
+ *
+ * Otherwise elements are sent individually.  Neither OFI nor Portals
+ * presently exposes noncontiguous data at the target of a one-sided
+ * operation through the transport API, which rules out doing the scatter
+ * in the network.
+ */
+void
+shmem_internal_alltoalls(shmem_ctx_t ctx, void *dest, const void *source, ptrdiff_t dst,
+                         ptrdiff_t sst, size_t elem_size, size_t nelems,
+                         int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    const int my_as_rank = shmem_internal_as_rank(PE_start, PE_stride, shmem_internal_my_pe);
+    const size_t blk_size = nelems * elem_size;
+    const void *dest_base = (uint8_t *) dest + my_as_rank * nelems * dst * elem_size;
+    long *arrived = NULL;
+    uint8_t *recv_buf = NULL;
+    uint8_t *pack_buf = NULL;
+    long completion = 0;
+    int peer, start_pe, i;
+    int use_scratch;
+
+    shmem_internal_assert(SHMEM_ALLTOALLS_SYNC_SIZE >= SHMEM_BARRIER_SYNC_SIZE);
+
+    if (0 == nelems)
+        return;
+
+    /* The scratch buffer is shared by all threads, see
+     * shmem_internal_alltoall_bruck_ok */
+    use_scratch = dst != 1 && NULL != alltoall_scratch &&
+                  shmem_internal_thread_level != SHMEM_THREAD_MULTIPLE &&
+                  blk_size <= alltoall_scratch_size / PE_size &&
+                  PE_size <= (1 << ALLTOALL_COUNTER_SLOT);
+
+    if (use_scratch) {
+        int *peers = malloc((PE_size - 1) * sizeof(int));
+        if (NULL == peers)
+            RAISE_ERROR_MSG("Unable to allocate %zub temporary buffer\n",
+                            (PE_size - 1) * sizeof(int));
+
+        for (i = 0, peer = 0; i < PE_size; i++) {
+            if (i == my_as_rank) continue;
+            peers[peer++] = shmem_internal_as_pe(PE_start, PE_stride, i);
+        }
+
+        shmem_internal_alltoall_scratch_cts(ctx, peers, PE_size - 1, pSync);
+        free(peers);
+
+        arrived = &((long *) alltoall_scratch)[ALLTOALL_SCRATCH_STEPS];
+        recv_buf = (uint8_t *) alltoall_scratch + ALLTOALL_SCRATCH_HDR;
+    }
+
+    if (sst != 1 && (dst == 1 || use_scratch)) {
+        pack_buf = malloc(blk_size);
+        if (NULL == pack_buf)
+            RAISE_ERROR_MSG("Unable to allocate %zub temporary buffer\n", blk_size);
+    }
+
+    /* Send data round-robin, ending with my PE */
+    start_pe = shmem_internal_circular_iter_next(shmem_internal_my_pe,
+                                                 PE_start, PE_stride,
+                                                 PE_size);
+    peer = start_pe;
+    do {
+        int peer_as_rank    = shmem_internal_as_rank(PE_start, PE_stride, peer); /* Peer's index in active set */
+        uint8_t *source_ptr = (uint8_t *) source + peer_as_rank * nelems * sst * elem_size;
+        const void *send_buf = source_ptr;
+
+        if (use_scratch && peer == shmem_internal_my_pe) {
+            shmem_internal_copy_strided((uint8_t *) dest_base, dst, source_ptr, sst,
+                                        elem_size, nelems);
+        } else if (dst == 1 || use_scratch) {
+            if (sst != 1) {
+                shmem_internal_copy_strided(pack_buf, 1, source_ptr, sst,
+                                            elem_size, nelems);
+                send_buf = pack_buf;
+            }
+
+            shmem_internal_put_nb(ctx,
+                                  use_scratch ? (void *) (recv_buf + my_as_rank * blk_size) :
+                                                (void *) dest_base,
+                                  send_buf, blk_size, peer, &completion);
+            shmem_internal_put_wait(ctx, &completion);
+        } else {
+            shmem_internal_iput(ctx, (void *) dest_base, source_ptr, dst, sst,
+                                elem_size, nelems, peer);
+        }
+        peer = shmem_internal_circular_iter_next(peer, PE_start, PE_stride,
+                                                 PE_size);
+    } while (peer != start_pe);
+
+    if (NULL != pack_buf)
+        free(pack_buf);
+
+    if (use_scratch) {
+        long one = 1;
+
+        /* Signal arrival of the packed blocks to all peers */
+        shmem_internal_fence(ctx);
+
+        for (i = 0; i < PE_size; i++) {
+            peer = shmem_internal_as_pe(PE_start, PE_stride, i);
+            if (peer == shmem_internal_my_pe) continue;
+            shmem_internal_atomic(ctx, arrived, &one, sizeof(long),
+                                  peer, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+        }
+
+        SHMEM_WAIT_UNTIL(arrived, SHMEM_CMP_EQ, PE_size - 1);
+
+        for (i = 0; i < PE_size; i++) {
+            if (i == my_as_rank) continue;
+            shmem_internal_copy_strided((uint8_t *) dest + i * nelems * dst * elem_size,
+                                        dst, recv_buf + i * blk_size, 1,
+                                        elem_size, nelems);
+        }
+
+        /* Nobody writes the counter again until the next alltoall, which
+         * cannot start before the barrier below */
+        *arrived = 0;
+    }
+
+    shmem_internal_barrier(ctx, PE_start, PE_stride, PE_size, pSync);
+
+    for (i = 0; i < SHMEM_BARRIER_SYNC_SIZE; i++)
+        pSync[i] = SHMEM_SYNC_VALUE;
+}
+
+
+/*****************************************
+ *
+ * NON-BLOCKING COLLECTIVES
+ *
+ * Each request is a resumable version of one of the algorithms above.  The
+ * progress function runs the algorithm until it would have to wait for a
+ * pSync update from a peer and then returns, recording where to resume.
+ * Outstanding requests are kept in a list in the order they were started
+ * and are progressed by test/wait, by the start of the next non-blocking
+ * collective, by every wait for a remote update (SHMEM_WAIT_UNTIL and
+ * friends), and by every blocking team collective and barrier_all, which
+ * first complete all outstanding requests.  Since every PE completes its own
+ * requests before entering a blocking collective, a PE waiting for its peers
+ * in a request never waits on a PE that is blocked elsewhere.
+ *
+ *****************************************/
+enum coll_req_type_t {
+    COLL_REQ_SYNC = 0,
+    COLL_REQ_BCAST,
+    COLL_REQ_REDUCE,
+    COLL_REQ_FCOLLECT,
+    COLL_REQ_ALLTOALL,
+    COLL_REQ_NOTIFY
+};
+
+struct shmem_internal_coll_req_t {
+    enum coll_req_type_t type;
+    shmem_ctx_t ctx;
+    int PE_start, PE_stride, PE_size;
+    long *pSync;
+    void *target;
+    const void *source;
+    size_t len;                 /* Bytes per PE */
+    size_t count;               /* Reduction elements */
+    shm_internal_op_t op;
+    shm_internal_datatype_t datatype;
+    int parent, num_children;   /* Tree, for bcast and reduce */
+    int *children;
+    void *tmp;
+    int state;                  /* Where to resume the algorithm */
+    int step;                   /* Round within the current state */
+    int done;
+    int detached;               /* No handle, freed when it completes */
+    shmem_internal_coll_notify_fn_t notify; /* Called with target and value */
+    long value;
+    struct shmem_internal_coll_req_t *next;
+};
+
+/* Non-blocking counterpart of SHMEM_WAIT_UNTIL: sets ret when the condition
+ * holds and otherwise pokes the transport */
+#define COLL_REQ_TEST(var, cond, value, ret)                            \
+    do {                                                                \
+        SHMEM_TEST(cond, var, value, ret);                              \
+        if (ret) {                                                      \
+            shmem_internal_membar_acq_rel();                            \
+            shmem_transport_syncmem();                                  \
+        } else {                                                        \
+            shmem_transport_probe();                                    \
+        }                                                               \
+    } while (0)
+
+
+/* Dissemination barrier, see shmem_internal_sync_dissem.  state records
+ * whether this round's notification was sent. */
+static int
+coll_req_sync_progress(shmem_internal_coll_req_t *req)
+{
+    int one = 1, neg_one = -1, ret;
+    int *pSync_ints = (int *) req->pSync;
+    int coll_rank = shmem_internal_as_rank(req->PE_start, req->PE_stride,
+                                           shmem_internal_my_pe);
+
+    for ( ; (1L << req->step) < req->PE_size ; req->step++, req->state = 0) {
+        int i = req->step;
+
+        if (0 == req->state) {
+            int to = (int) ((coll_rank + (1L << i)) % req->PE_size);
+
+            to = shmem_internal_as_pe(req->PE_start, req->PE_stride, to);
+            shmem_internal_atomic(req->ctx, &pSync_ints[i], &one, sizeof(int),
+                                  to, SHM_INTERNAL_SUM, SHM_INTERNAL_INT);
+            req->state = 1;
+        }
+
+        COLL_REQ_TEST(&pSync_ints[i], SHMEM_CMP_NE, 0, ret);
+        if (!ret) return 0;
+
+        shmem_internal_atomic(req->ctx, &pSync_ints[i], &neg_one, sizeof(int),
+                              shmem_internal_my_pe, SHM_INTERNAL_SUM, SHM_INTERNAL_INT);
+    }
+
+    /* Ensure local pSync decrements are done before the pSync is reused */
+    shmem_internal_quiet(req->ctx);
+
+    return 1;
+}
+
+
+/* Tree broadcast without completion acks, see shmem_internal_bcast_tree.
+ * Waits for the data from the parent on pSync[0], then forwards send_buf
+ * (the target buffer, except at the root) to the children. */
+static int
+coll_req_bcast_tree_progress(shmem_internal_coll_req_t *req, long *pSync, const void *send_buf)
+{
+    long zero = 0, one = 1;
+    long completion = 0;
+    int i, ret;
+
+    if (req->parent != shmem_internal_my_pe) {
+        COLL_REQ_TEST(pSync, SHMEM_CMP_NE, 0, ret);
+        if (!ret) return 0;
+
+        send_buf = req->target;
+    }
+
+    if (0 != req->num_children) {
+        for (i = 0 ; i < req->num_children ; ++i) {
+            shmem_internal_put_nb(req->ctx, req->target, send_buf, req->len,
+                                  req->children[i], &completion);
+        }
+        shmem_internal_put_wait(req->ctx, &completion);
+
+        shmem_internal_fence(req->ctx);
+
+        for (i = 0 ; i < req->num_children ; ++i) {
+            shmem_internal_put_scalar(req->ctx, pSync, &one, sizeof(long),
+                                      req->children[i]);
+        }
+    }
+
+    /* Clear pSync */
+    shmem_internal_put_scalar(req->ctx, pSync, &zero, sizeof(zero),
+                              shmem_internal_my_pe);
+    SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
+
+    return 1;
+}
+
+
+/* Tree reduction followed by a tree broadcast of the result from the root,
+ * as in shmem_internal_op_to_all_tree.  Rather than having the children
+ * combine their data into the parent's buffer with atomics, each child
+ * announces on the parent's pSync[0] that its partial result is ready in
+ * its own target buffer, and the parent reads and combines it.  This works
+ * for all operations and datatypes, and no PE has to wait for a clear to
+ * send. */
+static int
+coll_req_reduce_progress(shmem_internal_coll_req_t *req)
+{
+    long zero = 0, one = 1;
+    int i, ret;
+
+    switch (req->state) {
+    case 0:
+        if (req->target != req->source)
+            shmem_internal_copy_self(req->target, req->source, req->len);
+        req->state = 1;
+        /* fall through */
+    case 1:
+        if (0 != req->num_children) {
+            COLL_REQ_TEST(req->pSync, SHMEM_CMP_EQ, req->num_children, ret);
+            if (!ret) return 0;
+
+            for (i = 0 ; i < req->num_children ; ++i) {
+                shmem_internal_get(req->ctx, req->tmp, req->target, req->len,
+                                   req->children[i]);
+                shmem_internal_get_wait(req->ctx);
+                shmem_internal_reduce_local(req->op, req->datatype, req->count,
+                                            req->tmp, req->target);
+            }
+
+            /* reset pSync */
+            shmem_internal_put_scalar(req->ctx, req->pSync, &zero, sizeof(zero),
+                                      shmem_internal_my_pe);
+            SHMEM_WAIT_UNTIL(req->pSync, SHMEM_CMP_EQ, 0);
+        }
+
+        if (req->parent != shmem_internal_my_pe) {
+            shmem_internal_membar_acq_rel();
+            shmem_internal_atomic(req->ctx, req->pSync, &one, sizeof(one),
+                                  req->parent, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+        }
+        req->state = 2;
+        /* fall through */
+    case 2:
+        return coll_req_bcast_tree_progress(req, req->pSync + 2, req->target);
+    default:
+        RAISE_ERROR_MSG("Invalid reduction state (%d)\n", req->state);
+    }
+
+    return 0;
+}
+
+
+/* Ring algorithm, see shmem_internal_fcollect_ring.  step is the last round
+ * whose data was sent. */
+static int
+coll_req_fcollect_progress(shmem_internal_coll_req_t *req)
+{
+    int my_id = shmem_internal_as_rank(req->PE_start, req->PE_stride, shmem_internal_my_pe);
+    int next_proc = shmem_internal_as_pe(req->PE_start, req->PE_stride,
+                                         (my_id + 1) % req->PE_size);
+    long completion = 0;
+    long zero = 0, one = 1;
+    int ret;
+
+    if (0 == req->state) {
+        shmem_internal_copy_self((char*) req->target + (my_id * req->len), req->source,
+                                 req->len);
+        req->state = 1;
+    }
+
+    while (req->step < req->PE_size - 1) {
+        if (req->step > 0) {
+            COLL_REQ_TEST(req->pSync, SHMEM_CMP_GE, req->step, ret);
+            if (!ret) return 0;
+        }
+
+        req->step++;
+        size_t iter_offset = ((my_id + 1 - req->step + req->PE_size) % req->PE_size) * req->len;
+
+        shmem_internal_put_nb(req->ctx, (char*) req->target + iter_offset,
+                              (char*) req->target + iter_offset,
+                              req->len, next_proc, &completion);
+        shmem_internal_put_wait(req->ctx, &completion);
+        shmem_internal_fence(req->ctx);
+
+        shmem_internal_atomic(req->ctx, req->pSync, &one, sizeof(long),
+                              next_proc, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+    }
+
+    COLL_REQ_TEST(req->pSync, SHMEM_CMP_GE, req->PE_size - 1, ret);
+    if (!ret) return 0;
+
+    /* zero out psync */
+    shmem_internal_put_scalar(req->ctx, req->pSync, &zero, sizeof(long), shmem_internal_my_pe);
+    SHMEM_WAIT_UNTIL(req->pSync, SHMEM_CMP_EQ, 0);
+
+    return 1;
+}
+
+
+/* Pairwise exchange, see shmem_internal_alltoall_pairwise.  The receive
+ * counter is pSync[0].  Each request has a pSync of its own that is not
+ * reused until every PE has completed the request, so the final barrier of
+ * the blocking algorithm is not needed. */
+static int
+coll_req_alltoall_progress(shmem_internal_coll_req_t *req)
+{
+    const int my_id = shmem_internal_as_rank(req->PE_start, req->PE_stride,
+                                             shmem_internal_my_pe);
+    const int pow2 = (0 == (req->PE_size & (req->PE_size - 1)));
+    long completion = 0;
+    long zero = 0, one = 1;
+    int ret;
+
+    if (0 == req->state) {
+        shmem_internal_copy_self((uint8_t *) req->target + my_id * req->len,
+                                 (uint8_t *) req->source + my_id * req->len, req->len);
+        req->state = 1;
+    }
+
+    while (req->step < req->PE_size - 1) {
+        if (req->step > 0) {
+            COLL_REQ_TEST(req->pSync, SHMEM_CMP_GE, req->step, ret);
+            if (!ret) return 0;
+        }
+
+        req->step++;
+        int peer = pow2 ? my_id ^ req->step : (my_id + req->step) % req->PE_size;
+        int real_peer = shmem_internal_as_pe(req->PE_start, req->PE_stride, peer);
+
+        shmem_internal_put_nb(req->ctx, (uint8_t *) req->target + my_id * req->len,
+                              (uint8_t *) req->source + peer * req->len, req->len,
+                              real_peer, &completion);
+        shmem_internal_put_wait(req->ctx, &completion);
+        shmem_internal_fence(req->ctx);
+
+        shmem_internal_atomic(req->ctx, req->pSync, &one, sizeof(long),
+                              real_peer, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+    }
+
+    COLL_REQ_TEST(req->pSync, SHMEM_CMP_GE, req->PE_size - 1, ret);
+    if (!ret) return 0;
+
+    shmem_internal_put_scalar(req->ctx, req->pSync, &zero, sizeof(long),
+                              shmem_internal_my_pe);
+    SHMEM_WAIT_UNTIL(req->pSync, SHMEM_CMP_EQ, 0);
+
+    return 1;
+}
+
+
+/* Calls the notify function once every request started before this one
+ * has completed */
+static int
+coll_req_notify_progress(shmem_internal_coll_req_t *req)
+{
+    if (req != coll_reqs_head) return 0;
+
+    shmem_internal_quiet(req->ctx);
+    req->notify(req->ctx, req->target, req->value);
+
+    return 1;
+}
+
+
+static int
+coll_req_progress(shmem_internal_coll_req_t *req)
+{
+    switch (req->type) {
+    case COLL_REQ_SYNC:
+        return coll_req_sync_progress(req);
+    case COLL_REQ_BCAST:
+        return coll_req_bcast_tree_progress(req, req->pSync, req->source);
+    case COLL_REQ_REDUCE:
+        return coll_req_reduce_progress(req);
+    case COLL_REQ_FCOLLECT:
+        return coll_req_fcollect_progress(req);
+    case COLL_REQ_ALLTOALL:
+        return coll_req_alltoall_progress(req);
+    case COLL_REQ_NOTIFY:
+        return coll_req_notify_progress(req);
+    default:
+        RAISE_ERROR_MSG("Invalid collective request type (%d)\n", req->type);
+    }
+
+    return 0;
+}
+
+
+static void
+coll_req_free(shmem_internal_coll_req_t *req)
+{
+    free(req->children);
+    free(req->tmp);
+    free(req);
+}
+
+
+/* Advance every outstanding request once, in the order they were started,
+ * and unlink the ones that completed.  Caller holds coll_reqs_lock.  The
+ * waits inside the progress functions call back into
+ * shmem_internal_coll_reqs_progress, which coll_reqs_progressing turns into
+ * a no-op. */
+static void
+coll_reqs_progress_all(void)
+{
+    shmem_internal_coll_req_t *req = coll_reqs_head, *prev = NULL;
+
+    coll_reqs_progressing = 1;
+
+    while (NULL != req) {
+        shmem_internal_coll_req_t *next = req->next;
+
+        if (coll_req_progress(req)) {
+            req->done = 1;
+            if (NULL == prev)
+                coll_reqs_head = next;
+            else
+                prev->next = next;
+            if (coll_reqs_tail == req)
+                coll_reqs_tail = prev;
+            req->next = NULL;
+            if (req->detached)
+                coll_req_free(req);
+        } else {
+            prev = req;
+        }
+
+        req = next;
+    }
+
+    coll_reqs_progressing = 0;
+}
+
+
+static shmem_internal_coll_req_t *
+coll_req_alloc(enum coll_req_type_t type, shmem_ctx_t ctx, int PE_start, int PE_stride,
+               int PE_size, long *pSync)
+{
+    shmem_internal_coll_req_t *req = calloc(1, sizeof(shmem_internal_coll_req_t));
+
+    if (NULL == req)
+        RAISE_ERROR_STR("Out of memory allocating collective request");
+
+    req->type      = type;
+    req->ctx       = ctx;
+    req->PE_start  = PE_start;
+    req->PE_stride = PE_stride;
+    req->PE_size   = PE_size;
+    req->pSync     = pSync;
+
+    return req;
+}
+
+
+static void
+coll_req_build_tree(shmem_internal_coll_req_t *req, int PE_root)
+{
+    req->children = malloc(sizeof(int) * tree_radix);
+    if (NULL == req->children)
+        RAISE_ERROR_STR("Out of memory allocating collective request");
+
+    shmem_internal_build_kary_tree(tree_radix, req->PE_start, req->PE_stride, req->PE_size,
+                                   PE_root, &req->parent, &req->num_children,
+                                   req->children);
+}
+
+
+/* Queue the request and make as much progress as possible without waiting.
+ * Requests with nothing to do complete immediately. */
+static shmem_internal_coll_req_t *
+coll_req_start(shmem_internal_coll_req_t *req)
+{
+    if (req->PE_size == 1 || (req->type != COLL_REQ_SYNC && req->len == 0)) {
+        if (req->type != COLL_REQ_SYNC && req->target != req->source && req->len > 0)
+            shmem_internal_copy_self(req->target, req->source, req->len);
+        req->done = 1;
+        return req;
+    }
+
+    SHMEM_MUTEX_LOCK(coll_reqs_lock);
+    if (NULL == coll_reqs_tail)
+        coll_reqs_head = req;
+    else
+        coll_reqs_tail->next = req;
+    coll_reqs_tail = req;
+
+    coll_reqs_progress_all();
+    SHMEM_MUTEX_UNLOCK(coll_reqs_lock);
+
+    return req;
+}
+
+
+shmem_internal_coll_req_t *
+shmem_internal_sync_nb(shmem_ctx_t ctx, int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    shmem_internal_assert(SHMEM_BARRIER_SYNC_SIZE >= (sizeof(int) * 8) / (sizeof(long) / sizeof(int)));
+
+    return coll_req_start(coll_req_alloc(COLL_REQ_SYNC, ctx, PE_start, PE_stride, PE_size,
+                                         pSync));
+}
+
+
+shmem_internal_coll_req_t *
+shmem_internal_bcast_nb(shmem_ctx_t ctx, void *target, const void *source, size_t len,
+                        int PE_root, int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    shmem_internal_coll_req_t *req = coll_req_alloc(COLL_REQ_BCAST, ctx, PE_start,
+                                                    PE_stride, PE_size, pSync);
+
+    shmem_internal_assert(SHMEM_BCAST_SYNC_SIZE >= 1);
+
+    req->target = target;
+    req->source = source;
+    req->len    = len;
+
+    /* The broadcast does not write the root's target buffer */
+    if (PE_size == 1 || len == 0) {
+        req->done = 1;
+        return req;
+    }
+
+    coll_req_build_tree(req, PE_root);
+
+    return coll_req_start(req);
+}
+
+
+shmem_internal_coll_req_t *
+shmem_internal_op_to_all_nb(shmem_ctx_t ctx, void *target, const void *source, size_t count,
+                            size_t type_size, int PE_start, int PE_stride, int PE_size,
+                            long *pSync, shm_internal_op_t op,
+                            shm_internal_datatype_t datatype)
+{
+    shmem_internal_coll_req_t *req = coll_req_alloc(COLL_REQ_REDUCE, ctx, PE_start,
+                                                    PE_stride, PE_size, pSync);
+
+    shmem_internal_assert(SHMEM_REDUCE_SYNC_SIZE >= 2 + SHMEM_BCAST_SYNC_SIZE);
+
+    req->target   = target;
+    req->source   = source;
+    req->len      = count * type_size;
+    req->count    = count;
+    req->op       = op;
+    req->datatype = datatype;
+
+    if (PE_size > 1 && count > 0) {
+        req->tmp = malloc(req->len);
+        if (NULL == req->tmp)
+            RAISE_ERROR_MSG("Unable to allocate %zub temporary buffer\n", req->len);
+
+        coll_req_build_tree(req, 0);
+    }
+
+    return coll_req_start(req);
+}
+
+
+shmem_internal_coll_req_t *
+shmem_internal_fcollect_nb(shmem_ctx_t ctx, void *target, const void *source, size_t len,
+                           int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    shmem_internal_coll_req_t *req = coll_req_alloc(COLL_REQ_FCOLLECT, ctx, PE_start,
+                                                    PE_stride, PE_size, pSync);
+
+    shmem_internal_assert(SHMEM_COLLECT_SYNC_SIZE >= 1);
+
+    req->target = target;
+    req->source = source;
+    req->len    = len;
+
+    return coll_req_start(req);
+}
+
+
+shmem_internal_coll_req_t *
+shmem_internal_alltoall_nb(shmem_ctx_t ctx, void *dest, const void *source, size_t len,
+                           int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    shmem_internal_coll_req_t *req = coll_req_alloc(COLL_REQ_ALLTOALL, ctx, PE_start,
+                                                    PE_stride, PE_size, pSync);
+
+    req->target = dest;
+    req->source = source;
+    req->len    = len;
+
+    return coll_req_start(req);
+}
+
+
+/* Returns 1 and frees the request if it has completed, otherwise progresses
+ * all outstanding requests and returns 0 */
+int
+shmem_internal_coll_req_test(shmem_internal_coll_req_t *req)
+{
+    int done;
+
+    SHMEM_MUTEX_LOCK(coll_reqs_lock);
+    if (!req->done)
+        coll_reqs_progress_all();
+    done = req->done;
+    SHMEM_MUTEX_UNLOCK(coll_reqs_lock);
+
+    if (done)
+        coll_req_free(req);
+
+    return done;
+}
+
+
+void
+shmem_internal_coll_req_wait(shmem_internal_coll_req_t *req)
+{
+    while (!shmem_internal_coll_req_test(req))
+        SPINLOCK_BODY();
+}
+
+
+/* Call fn(ctx, arg, value), after quieting ctx, once every non-blocking
+ * collective started so far has completed.  Does not wait for the
+ * outstanding collectives. */
+void
+shmem_internal_coll_req_notify(shmem_ctx_t ctx, shmem_internal_coll_notify_fn_t fn,
+                               void *arg, long value)
+{
+    shmem_internal_coll_req_t *req;
+
+    SHMEM_MUTEX_LOCK(coll_reqs_lock);
+    if (NULL == coll_reqs_head) {
+        SHMEM_MUTEX_UNLOCK(coll_reqs_lock);
+        shmem_internal_quiet(ctx);
+        fn(ctx, arg, value);
+        return;
+    }
+
+    req = coll_req_alloc(COLL_REQ_NOTIFY, ctx, shmem_internal_my_pe, 1, 1, NULL);
+    req->notify   = fn;
+    req->target   = arg;
+    req->value    = value;
+    req->detached = 1;
+
+    coll_reqs_tail->next = req;
+    coll_reqs_tail = req;
+
+    coll_reqs_progress_all();
+    SHMEM_MUTEX_UNLOCK(coll_reqs_lock);
+}
+
+
+/* Advance the outstanding requests without waiting for them.  Called from
+ * the wait loops in shmem_synchronization.h, so returns immediately when
+ * there is nothing to do or when this PE is already progressing requests. */
+void
+shmem_internal_coll_reqs_progress(void)
+{
+    if (NULL == coll_reqs_head || coll_reqs_progressing) return;
+
+    SHMEM_MUTEX_LOCK(coll_reqs_lock);
+    coll_reqs_progress_all();
+    SHMEM_MUTEX_UNLOCK(coll_reqs_lock);
+}
+
+
+/* Complete all outstanding requests.  Called by every blocking team
+ * collective and barrier_all before it starts. */
+void
+shmem_internal_coll_req_drain(void)
+{
+    if (NULL == coll_reqs_head) return;
+
+    for (;;) {
+        int empty;
+
+        SHMEM_MUTEX_LOCK(coll_reqs_lock);
+        coll_reqs_progress_all();
+        empty = (NULL == coll_reqs_head);
+        SHMEM_MUTEX_UNLOCK(coll_reqs_lock);
+
+        if (empty) break;
+        SPINLOCK_BODY();
+    }
 }
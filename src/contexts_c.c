@@ -42,11 +42,7 @@ shmem_ctx_create(long options, shmem_ctx_t *ctx)
 {
     SHMEM_ERR_CHECK_INITIALIZED();
 
-    int ret = shmem_transport_ctx_create(&shmem_internal_team_world, options, (shmem_transport_ctx_t **) ctx);
-
-    if (0 != ret) *ctx = SHMEM_CTX_INVALID;
-
-    return ret;
+    return shmem_internal_team_create_ctx(&shmem_internal_team_world, options, ctx);
 }
 
 
@@ -65,6 +61,7 @@ shmem_ctx_destroy(shmem_ctx_t ctx)
     }
 
     shmem_internal_quiet(ctx);
+    shmem_internal_agg_ctx_destroy(ctx);
     shmem_transport_ctx_destroy((shmem_transport_ctx_t *) ctx);
 
     return;
@@ -77,6 +77,8 @@ static vm_address_t get_base_address(mach_port_t task, size_t *region_size, void
 
 void *shmem_internal_heap_base = NULL;
 long shmem_internal_heap_length = 0;
+void *shmem_internal_atomics_heap_base = NULL;
+long shmem_internal_atomics_heap_length = 0;
 void *shmem_internal_data_base = NULL;
 long shmem_internal_data_length = 0;
 
@@ -147,6 +149,8 @@ shmem_internal_shutdown(void)
 
     shmem_internal_finalized = 1;
 
+    shmem_internal_agg_fini();
+
     shmem_internal_team_fini();
 
     shmem_transport_fini();
@@ -373,6 +377,11 @@ shmem_internal_heap_postinit(void)
         goto cleanup_postinit;
     }
 
+    if (0 == shmem_internal_my_pe && shmem_internal_params.INFO) {
+        shmem_internal_symmetric_print_info();
+        fflush(NULL);
+    }
+
     DEBUG_MSG("Thread level=%s, Num. PEs=%d\n"
               RAISE_PE_PREFIX
               "Sym. heap=%p len=%ld -- data=%p len=%ld\n",
@@ -514,6 +523,12 @@ shmem_internal_heap_postinit(void)
     }
     teams_initialized = 1;
 
+    ret = shmem_internal_agg_init();
+    if (ret != 0) {
+        RETURN_ERROR_MSG("Initialization of aggregation failed (%d)\n", ret);
+        goto cleanup_postinit;
+    }
+
     shmem_internal_randr_init();
     randr_initialized = 1;
 
@@ -542,6 +542,8 @@ MAX_RELEASE_CHECK_RATE   default: 4095 unless not HAVE_MMAP
 #define MORECORE_CONTIGUOUS 1
 #define HAVE_MMAP 0
 #define HAVE_MREMAP 0
+/* mspaces back the sub-heap for SHMEM_MALLOC_ATOMICS_REMOTE allocations */
+#define MSPACES 1
 #define USAGE_ERROR_ACTION(m, p)                                        \
     do {                                                                \
         RETURN_ERROR_MSG("Symmetric heap usage error detected, "        \
@@ -1301,6 +1303,13 @@ DLMALLOC_EXPORT void  dlmalloc_stats(void);
 */
 size_t dlmalloc_usable_size(void*);
 
+/* BEGIN SHMEM CHANGES */
+/* Tag in-use blocks with the spare FLAG4 chunk bit, see below */
+void dlmalloc_set_flag4(void*);
+void dlmalloc_clear_flag4(void*);
+int dlmalloc_flag4(void*);
+/* END SHMEM CHANGES */
+
 #endif /* ONLY_MSPACES */
 
 #if MSPACES
@@ -1453,6 +1462,14 @@ DLMALLOC_EXPORT int mspace_trim(mspace msp, size_t pad);
 */
 DLMALLOC_EXPORT int mspace_mallopt(int, int);
 
+/* BEGIN SHMEM CHANGES */
+/* Prototypes for mspace routines defined below but not declared upstream */
+DLMALLOC_EXPORT void* mspace_realloc_in_place(mspace msp, void* oldmem, size_t bytes);
+DLMALLOC_EXPORT size_t mspace_bulk_free(mspace msp, void* array[], size_t nelem);
+DLMALLOC_EXPORT size_t mspace_footprint_limit(mspace msp);
+DLMALLOC_EXPORT size_t mspace_set_footprint_limit(mspace msp, size_t bytes);
+/* END SHMEM CHANGES */
+
 #endif /* MSPACES */
 
 #ifdef __cplusplus
@@ -5427,6 +5444,23 @@ size_t dlmalloc_usable_size(void* mem) {
   return 0;
 }
 
+/* BEGIN SHMEM CHANGES */
+/* FLAG4 of an in-use chunk is not used by dlmalloc and marks blocks owned by
+ * the per-thread allocation caches.  Neighboring chunks update the same
+ * word, so the bit must only be changed under the allocator lock. */
+void dlmalloc_set_flag4(void* mem) {
+  set_flag4(mem2chunk(mem));
+}
+
+void dlmalloc_clear_flag4(void* mem) {
+  clear_flag4(mem2chunk(mem));
+}
+
+int dlmalloc_flag4(void* mem) {
+  return flag4inuse(mem2chunk(mem)) != 0;
+}
+/* END SHMEM CHANGES */
+
 #endif /* !ONLY_MSPACES */
 
 /* ----------------------------- user mspaces ---------------------------- */
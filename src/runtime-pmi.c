@@ -38,6 +38,7 @@ static char *kvs_name, *kvs_key, *kvs_value;
 static int max_name_len, max_key_len, max_val_len;
 static int initialized_pmi = 0;
 static int *location_array = NULL;
+static int node_mapped = 0;
 
 #define SINGLETON_KEY_LEN 128
 #define SINGLETON_VAL_LEN 1024
@@ -204,6 +205,30 @@ shmem_runtime_exchange(void)
         return 0;
 
     if (location_array) {
+        int mode = shmem_runtime_util_node_mapping_mode();
+
+        if (mode != SHMEM_RUNTIME_NODE_MAPPING_HOSTNAME) {
+            const char *mapping = NULL;
+
+            if (PMI_SUCCESS == PMI_KVS_Get(kvs_name, "PMI_process_mapping",
+                                           kvs_value, max_val_len)) {
+                mapping = kvs_value;
+            }
+
+            ret = shmem_runtime_util_populate_node_mapping(mapping, location_array,
+                                                           size, rank, &node_size);
+            if (ret == 0) {
+                node_mapped = 1;
+            } else if (mode == SHMEM_RUNTIME_NODE_MAPPING_PROCESS) {
+                RETURN_ERROR_MSG("PMI_process_mapping unavailable or invalid (%d)\n", ret);
+                return 8;
+            } else {
+                DEBUG_MSG("PMI_process_mapping unavailable (%d), using hostname exchange\n", ret);
+            }
+        }
+    }
+
+    if (location_array && !node_mapped) {
         ret = shmem_runtime_util_put_hostname();
         if (ret != 0) {
             RETURN_ERROR_MSG("KVS hostname put (%d)", ret);
@@ -219,7 +244,7 @@ shmem_runtime_exchange(void)
         return 6;
     }
 
-    if (location_array) {
+    if (location_array && !node_mapped) {
         ret = shmem_runtime_util_populate_node(location_array, size, &node_size);
         if (0 != ret) {
             RETURN_ERROR_MSG("Node PE mapping failed (%d)\n", ret);
@@ -42,6 +42,7 @@ static char *kvs_name, *kvs_key, *kvs_value;
 static int max_name_len, max_key_len, max_val_len;
 static int initialized_pmi = 0;
 static int *location_array = NULL;
+static int node_mapped = 0;
 
 
 int
@@ -151,6 +152,33 @@ shmem_runtime_exchange(void)
     int ret;
 
     if (location_array) {
+        int mode = shmem_runtime_util_node_mapping_mode();
+
+        if (mode != SHMEM_RUNTIME_NODE_MAPPING_HOSTNAME) {
+            const char *mapping = NULL;
+
+            int found = 0;
+
+            if (PMI2_SUCCESS == PMI2_Info_GetJobAttr("PMI_process_mapping",
+                                                     kvs_value, max_val_len,
+                                                     &found) && found) {
+                mapping = kvs_value;
+            }
+
+            ret = shmem_runtime_util_populate_node_mapping(mapping, location_array,
+                                                           size, rank, &node_size);
+            if (ret == 0) {
+                node_mapped = 1;
+            } else if (mode == SHMEM_RUNTIME_NODE_MAPPING_PROCESS) {
+                RETURN_ERROR_MSG("PMI_process_mapping unavailable or invalid (%d)\n", ret);
+                return 8;
+            } else {
+                DEBUG_MSG("PMI_process_mapping unavailable (%d), using hostname exchange\n", ret);
+            }
+        }
+    }
+
+    if (location_array && !node_mapped) {
         ret = shmem_runtime_util_put_hostname();
         if (ret != 0) {
             RETURN_ERROR_MSG("KVS hostname put (%d)", ret);
@@ -162,7 +190,7 @@ shmem_runtime_exchange(void)
         return 5;
     }
 
-    if (location_array) {
+    if (location_array && !node_mapped) {
         ret = shmem_runtime_util_populate_node(location_array, size, &node_size);
         if (0 != ret) {
             RETURN_ERROR_MSG("Node PE mapping failed (%d)\n", ret);
@@ -41,6 +41,15 @@ void shmem_runtime_barrier(void);
 /* Utility functions used to implement the runtime layer */
 int shmem_runtime_util_put_hostname(void);
 int shmem_runtime_util_populate_node(int *location_array, int size, int *node_size);
+int shmem_runtime_util_populate_node_mapping(const char *mapping, int *location_array,
+                                             int size, int rank, int *node_size);
+
+/* Node locality discovery modes, selected with SHMEM_PMI_NODE_MAPPING */
+#define SHMEM_RUNTIME_NODE_MAPPING_AUTO     0
+#define SHMEM_RUNTIME_NODE_MAPPING_PROCESS  1
+#define SHMEM_RUNTIME_NODE_MAPPING_HOSTNAME 2
+
+int shmem_runtime_util_node_mapping_mode(void);
 
 int shmem_runtime_util_encode(const void *inval, int invallen, char *outval, int outvallen);
 int shmem_runtime_util_decode(const char *inval, void *outval, size_t outvallen);
@@ -19,6 +19,7 @@
 #include <errno.h>
 #include <unistd.h>
 #include <limits.h>
+#include <ctype.h>
 
 #include "shmem_internal.h"
 #include "runtime.h"
@@ -164,3 +165,145 @@ int shmem_runtime_util_populate_node(int *location_array, int size, int *node_si
 
     return 0;
 }
+
+
+int shmem_runtime_util_node_mapping_mode(void)
+{
+    char *type = shmem_internal_params.PMI_NODE_MAPPING;
+
+    if (0 == strcmp(type, "auto")) {
+        return SHMEM_RUNTIME_NODE_MAPPING_AUTO;
+    } else if (0 == strcmp(type, "process_mapping")) {
+        return SHMEM_RUNTIME_NODE_MAPPING_PROCESS;
+    } else if (0 == strcmp(type, "hostname")) {
+        return SHMEM_RUNTIME_NODE_MAPPING_HOSTNAME;
+    } else {
+        RAISE_WARN_MSG("Ignoring bad PMI node mapping '%s'\n", type);
+        return SHMEM_RUNTIME_NODE_MAPPING_AUTO;
+    }
+}
+
+
+static const char *
+mapping_skip(const char *str, char c)
+{
+    while (isspace((unsigned char) *str)) str++;
+    if (*str != c) return NULL;
+    return str + 1;
+}
+
+
+static const char *
+mapping_int(const char *str, long *val)
+{
+    char *end;
+
+    while (isspace((unsigned char) *str)) str++;
+    errno = 0;
+    *val = strtol(str, &end, 10);
+    if (end == str || errno != 0 || *val < 0) return NULL;
+    return end;
+}
+
+
+/* Populate the topology array from a "PMI_process_mapping" attribute, as
+ * published by Hydra and Slurm.  The mapping has the form
+ * "(vector,(start_node,node_count,pes_per_node),...)"; blocks are applied in
+ * order and repeated until every PE has been placed.  Unlike
+ * shmem_runtime_util_populate_node, this requires no KVS reads, so the cost
+ * does not grow with the number of nodes in the job. */
+int shmem_runtime_util_populate_node_mapping(const char *mapping, int *location_array,
+                                             int size, int rank, int *node_size)
+{
+    const char *p = mapping;
+    long (*blocks)[3] = NULL;
+    int nblocks = 0, max_blocks = 0;
+    int i, b, pe, my_node = -1, n_node_pes = 0;
+    int *node_ids;
+
+    if (NULL == mapping) return 1;
+
+    if (NULL == (p = mapping_skip(p, '('))) return 2;
+    while (isspace((unsigned char) *p)) p++;
+    if (0 != strncmp(p, "vector", strlen("vector"))) return 2;
+    p += strlen("vector");
+
+    for (;;) {
+        const char *next = mapping_skip(p, ',');
+
+        if (NULL == next) break;
+        p = next;
+
+        if (nblocks == max_blocks) {
+            long (*tmp)[3];
+            max_blocks = max_blocks ? 2 * max_blocks : 8;
+            tmp = realloc(blocks, max_blocks * sizeof(*blocks));
+            if (NULL == tmp) {
+                free(blocks);
+                return 3;
+            }
+            blocks = tmp;
+        }
+
+        if (NULL == (p = mapping_skip(p, '(')) ||
+            NULL == (p = mapping_int(p, &blocks[nblocks][0])) ||
+            NULL == (p = mapping_skip(p, ',')) ||
+            NULL == (p = mapping_int(p, &blocks[nblocks][1])) ||
+            NULL == (p = mapping_skip(p, ',')) ||
+            NULL == (p = mapping_int(p, &blocks[nblocks][2])) ||
+            NULL == (p = mapping_skip(p, ')'))) {
+            free(blocks);
+            return 2;
+        }
+
+        if (blocks[nblocks][1] > 0 && blocks[nblocks][2] > 0)
+            nblocks++;
+    }
+
+    if (NULL == mapping_skip(p, ')') || nblocks == 0) {
+        free(blocks);
+        return 2;
+    }
+
+    node_ids = malloc(sizeof(int) * size);
+    if (NULL == node_ids) {
+        free(blocks);
+        return 3;
+    }
+
+    /* Assign a node id to every PE by walking the blocks cyclically */
+    for (pe = 0; pe < size; ) {
+        for (b = 0; b < nblocks && pe < size; b++) {
+            long node, j;
+            for (node = 0; node < blocks[b][1] && pe < size; node++) {
+                for (j = 0; j < blocks[b][2] && pe < size; j++) {
+                    node_ids[pe++] = (int) (blocks[b][0] + node);
+                }
+            }
+        }
+    }
+
+    free(blocks);
+
+    my_node = node_ids[rank];
+
+    for (i = 0; i < size; i++) {
+        if (node_ids[i] == my_node) {
+            location_array[i] = n_node_pes;
+            n_node_pes++;
+        }
+        else
+            location_array[i] = -1;
+    }
+
+    free(node_ids);
+
+    if (n_node_pes < 1 || n_node_pes > size) {
+        RETURN_ERROR_MSG("Invalid node size (%d)\n", n_node_pes);
+        return 1;
+    }
+
+    *node_size = n_node_pes;
+
+    return 0;
+}
@@ -0,0 +1,663 @@
+/* -*- C -*-
+ *
+ * This file is part of the Sandia OpenSHMEM software package. For license
+ * information, see the LICENSE file in the top level directory of the
+ * distribution.
+ *
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "shmem.h"
+#include "shmem_internal.h"
+#include "shmem_internal_op.h"
+#include "shmem_comm.h"
+#include "shmem_aggregate.h"
+#include "shmem_team.h"
+
+#define AGG_KIND_PUT    1
+#define AGG_KIND_ATOMIC 2
+#define AGG_KIND_SET    3
+
+#define AGG_SEG_DATA    0
+#define AGG_SEG_HEAP    1
+
+#define AGG_ALIGN(len) (((len) + 7) & ~((size_t) 7))
+
+/* Header of one aggregated operation, followed by its payload padded to eight
+ * bytes */
+typedef struct {
+    uint64_t offset;
+    uint32_t len;
+    uint8_t  kind;
+    uint8_t  segment;
+    uint8_t  op;
+    uint8_t  datatype;
+} agg_rec_t;
+
+struct shmem_internal_agg_t {
+    shmem_ctx_t             ctx;
+    char                  **bufs;       /* per-destination send buffers */
+    size_t                 *used;
+    int                    *dirty;      /* destinations with used > 0 */
+    int                     ndirty;
+    long                   *shipped;    /* ticket after the last batch shipped to each PE */
+    long                   *applied;    /* head of each mailbox when last read */
+    int                    *inflight;   /* destinations with applied < shipped */
+    int                     ninflight;
+    char                   *scratch;    /* batches applied on behalf of a target */
+    double                  oldest;     /* time the first dirty buffer was started */
+#ifdef ENABLE_THREADS
+    shmem_internal_mutex_t  lock;
+#endif
+    shmem_internal_agg_t   *next;
+};
+
+static shmem_internal_agg_t *agg_list = NULL;
+#ifdef ENABLE_THREADS
+static shmem_internal_mutex_t agg_list_lock;
+#endif
+
+/* Symmetric mailbox: a ring of slots, each holding one batch.  Senders take
+ * a ticket with a fetch-add on agg_mailbox_ticket and write their batch to
+ * slot (ticket % agg_nslots) once the batch shipped agg_nslots tickets
+ * earlier has been applied.  Batches are applied in ticket order;
+ * agg_mailbox_head is the ticket of the next one.  The state word of a slot
+ * holds the ticket it is for and whether the slot is free for that ticket,
+ * holds its ready batch, or is being applied.  A batch is claimed with a
+ * compare-and-swap on the state, so it can be applied by the target, when
+ * it waits in the library, or by any sender that needs it applied, which
+ * gets the batch and issues its operations to the target directly. */
+#define AGG_FREE        0
+#define AGG_READY       1
+#define AGG_BUSY        2
+#define AGG_STATE(ticket, st) ((ticket) * 4 + (st))
+
+typedef struct {
+    long state;
+    long len;                           /* bytes of records */
+    /* records follow */
+} agg_slot_t;
+
+static long *agg_mailbox_ticket = NULL;
+static long *agg_mailbox_head = NULL;
+static char *agg_mailbox = NULL;
+static size_t agg_slot_size;
+static long agg_nslots;
+
+/* Context used by the target to apply its own mailbox */
+static shmem_ctx_t agg_apply_ctx;
+#ifdef ENABLE_THREADS
+static shmem_internal_mutex_t agg_mailbox_lock;
+#endif
+
+
+static inline agg_slot_t *
+agg_slot(long ticket)
+{
+    return (agg_slot_t *) (agg_mailbox + (ticket % agg_nslots) * agg_slot_size);
+}
+
+
+static int
+agg_segment(const void *addr, uint8_t *segment, uint64_t *offset)
+{
+    /* AMOs on the atomics heap must stay on the NIC */
+    if (shmem_internal_in_atomics_heap(addr))
+        return 1;
+
+    if ((char *) addr >= (char *) shmem_internal_data_base &&
+        (char *) addr < (char *) shmem_internal_data_base + shmem_internal_data_length) {
+        *segment = AGG_SEG_DATA;
+        *offset  = (char *) addr - (char *) shmem_internal_data_base;
+        return 0;
+    } else if ((char *) addr >= (char *) shmem_internal_heap_base &&
+               (char *) addr < (char *) shmem_internal_heap_base + shmem_internal_heap_length) {
+        *segment = AGG_SEG_HEAP;
+        *offset  = (char *) addr - (char *) shmem_internal_heap_base;
+        return 0;
+    }
+
+    return 1;
+}
+
+
+static inline void *
+agg_rec_addr(const agg_rec_t *rec)
+{
+    char *base = (rec->segment == AGG_SEG_DATA) ? (char *) shmem_internal_data_base :
+                                                  (char *) shmem_internal_heap_base;
+    return base + rec->offset;
+}
+
+
+/* Direct paths used to ship and replay buffers; these bypass the
+ * aggregation hooks in shmem_comm.h */
+static inline void
+agg_direct_put(shmem_ctx_t ctx, void *target, const void *source, size_t len,
+               int pe, long *completion)
+{
+    if (shmem_shr_transport_use_write(ctx, target, source, len, pe)) {
+        shmem_shr_transport_put(ctx, target, source, len, pe);
+    } else {
+        shmem_transport_put_nb((shmem_transport_ctx_t *)ctx, target, source, len, pe, completion);
+    }
+}
+
+
+static inline void
+agg_direct_set(shmem_ctx_t ctx, void *target, const void *source, size_t len, int pe,
+               int datatype)
+{
+    if (shmem_shr_transport_use_atomic(ctx, target, len, pe, datatype)) {
+        shmem_shr_transport_atomic_set(ctx, target, source, len, pe, datatype);
+    } else {
+        shmem_transport_atomic_set((shmem_transport_ctx_t *)ctx, target, source, len,
+                                   pe, datatype);
+    }
+}
+
+
+static inline void
+agg_direct_atomic(shmem_ctx_t ctx, const agg_rec_t *rec, int pe)
+{
+    void *target = agg_rec_addr(rec);
+    const void *source = rec + 1;
+
+    if (rec->kind == AGG_KIND_SET) {
+        agg_direct_set(ctx, target, source, rec->len, pe, rec->datatype);
+    } else {
+        if (shmem_shr_transport_use_atomic(ctx, target, rec->len, pe, rec->datatype)) {
+            shmem_shr_transport_atomic(ctx, target, source, rec->len, pe,
+                                       rec->op, rec->datatype);
+        } else {
+            shmem_transport_atomic((shmem_transport_ctx_t *)ctx, target, source,
+                                   rec->len, pe, rec->op, rec->datatype);
+        }
+    }
+}
+
+
+/* Apply the batch at the head of pe's mailbox if it is ready.  The caller
+ * is pe itself or a sender that needs the batch applied; buf holds the
+ * batch when it is applied remotely.  The operations are issued through the
+ * transport, so aggregated AMOs stay atomic with respect to AMOs issued
+ * directly, and complete before the head moves on.  Returns nonzero if a
+ * batch was applied. */
+static int
+agg_apply_head(shmem_ctx_t ctx, int pe, char *buf)
+{
+    agg_slot_t *slot;
+    long head, ready, busy, state, len, pos;
+    long completion = 0;
+    const char *recs;
+
+    shmem_internal_atomic_fetch(ctx, &head, agg_mailbox_head, sizeof(long), pe,
+                                SHM_INTERNAL_LONG);
+    shmem_internal_get_wait(ctx);
+
+    slot  = agg_slot(head);
+    ready = AGG_STATE(head, AGG_READY);
+    busy  = AGG_STATE(head, AGG_BUSY);
+    shmem_internal_cswap(ctx, &slot->state, &busy, &state, &ready, sizeof(long), pe,
+                         SHM_INTERNAL_LONG);
+    shmem_internal_get_wait(ctx);
+
+    if (state != ready)
+        return 0;
+
+    if (pe == shmem_internal_my_pe) {
+        shmem_internal_membar_acq_rel();
+        shmem_transport_syncmem();
+        len  = slot->len;
+        recs = (const char *) (slot + 1);
+    } else {
+        shmem_internal_get(ctx, &len, &slot->len, sizeof(long), pe);
+        shmem_internal_get_wait(ctx);
+        shmem_internal_get(ctx, buf, slot + 1, len, pe);
+        shmem_internal_get_wait(ctx);
+        recs = buf;
+    }
+
+    for (pos = 0; pos < len;) {
+        const agg_rec_t *rec = (const agg_rec_t *) (recs + pos);
+
+        if (rec->kind != AGG_KIND_PUT)
+            agg_direct_atomic(ctx, rec, pe);
+        else if (pe == shmem_internal_my_pe)
+            memcpy(agg_rec_addr(rec), rec + 1, rec->len);
+        else
+            agg_direct_put(ctx, agg_rec_addr(rec), rec + 1, rec->len, pe, &completion);
+
+        pos += sizeof(agg_rec_t) + AGG_ALIGN(rec->len);
+    }
+
+    /* Senders learn from the head that their operations have been applied */
+    shmem_internal_put_wait(ctx, &completion);
+    shmem_transport_quiet((shmem_transport_ctx_t *) ctx);
+    shmem_internal_membar();
+
+    state = AGG_STATE(head + agg_nslots, AGG_FREE);
+    agg_direct_set(ctx, &slot->state, &state, sizeof(long), pe, SHM_INTERNAL_LONG);
+    head++;
+    agg_direct_set(ctx, agg_mailbox_head, &head, sizeof(long), pe, SHM_INTERNAL_LONG);
+    shmem_transport_quiet((shmem_transport_ctx_t *) ctx);
+
+    return 1;
+}
+
+
+/* Wait until every batch this context shipped to pe has been applied, so
+ * that operations issued directly to pe cannot overtake them.  The context
+ * applies the batches itself rather than wait for pe to do it, so this
+ * completes even while pe computes outside the library.  Caller holds
+ * agg->lock. */
+static void
+agg_wait_applied(shmem_internal_agg_t *agg, int pe)
+{
+    while (agg->applied[pe] < agg->shipped[pe]) {
+        shmem_internal_atomic_fetch(agg->ctx, &agg->applied[pe], agg_mailbox_head,
+                                    sizeof(long), pe, SHM_INTERNAL_LONG);
+        shmem_internal_get_wait(agg->ctx);
+        if (agg->applied[pe] >= agg->shipped[pe])
+            break;
+
+        /* The head batch may be from another sender that is still writing it */
+        if (!agg_apply_head(agg->ctx, pe, agg->scratch)) {
+            shmem_internal_agg_progress();
+            SPINLOCK_BODY();
+        }
+    }
+}
+
+
+static void
+agg_wait_applied_all(shmem_internal_agg_t *agg)
+{
+    for (int i = 0; i < agg->ninflight; i++)
+        agg_wait_applied(agg, agg->inflight[i]);
+
+    agg->ninflight = 0;
+}
+
+
+/* Ship the buffer for one destination.  A ticket is taken with a fetch-add,
+ * and once its slot is free, the records and their length are written with
+ * one put, followed by the ready state.  A slot is free once the batch
+ * before it has been applied, which the context does itself if needed.
+ * Caller holds agg->lock. */
+static void
+agg_ship(shmem_internal_agg_t *agg, int pe)
+{
+    long one = 1;
+    long ticket, free_state, state;
+    long completion = 0;
+    agg_slot_t *slot;
+
+    shmem_internal_fetch_atomic(agg->ctx, agg_mailbox_ticket, &one, &ticket,
+                                sizeof(long), pe, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+    shmem_internal_get_wait(agg->ctx);
+
+    slot = agg_slot(ticket);
+    free_state = AGG_STATE(ticket, AGG_FREE);
+
+    for (;;) {
+        shmem_internal_atomic_fetch(agg->ctx, &state, &slot->state, sizeof(long), pe,
+                                    SHM_INTERNAL_LONG);
+        shmem_internal_get_wait(agg->ctx);
+        if (state == free_state)
+            break;
+
+        if (!agg_apply_head(agg->ctx, pe, agg->scratch)) {
+            shmem_internal_agg_progress();
+            SPINLOCK_BODY();
+        }
+    }
+
+    /* The send buffer starts with the length, matching the slot layout */
+    *(long *) agg->bufs[pe] = (long) agg->used[pe];
+    agg_direct_put(agg->ctx, &slot->len, agg->bufs[pe], sizeof(long) + agg->used[pe],
+                   pe, &completion);
+
+    /* The batch must not be seen as ready before it arrives */
+    shmem_transport_fence((shmem_transport_ctx_t *) agg->ctx);
+    shmem_internal_membar_release();
+    state = AGG_STATE(ticket, AGG_READY);
+    agg_direct_set(agg->ctx, &slot->state, &state, sizeof(long), pe, SHM_INTERNAL_LONG);
+
+    if (agg->applied[pe] >= agg->shipped[pe])
+        agg->inflight[agg->ninflight++] = pe;
+    agg->shipped[pe] = ticket + 1;
+
+    /* The send buffer is reused as soon as the put completes locally */
+    shmem_internal_put_wait(agg->ctx, &completion);
+    agg->used[pe] = 0;
+}
+
+
+static void
+agg_ship_all(shmem_internal_agg_t *agg)
+{
+    for (int i = 0; i < agg->ndirty; i++)
+        agg_ship(agg, agg->dirty[i]);
+
+    agg->ndirty = 0;
+}
+
+
+/* Ship the buffer for one destination ahead of the others and take it off
+ * the dirty list.  Caller holds agg->lock. */
+static void
+agg_ship_one(shmem_internal_agg_t *agg, int pe)
+{
+    if (agg->used[pe] == 0)
+        return;
+
+    agg_ship(agg, pe);
+
+    for (int i = 0; i < agg->ndirty; i++) {
+        if (agg->dirty[i] == pe) {
+            agg->dirty[i] = agg->dirty[--agg->ndirty];
+            break;
+        }
+    }
+}
+
+
+/* Buffer one operation, or return 1 if the caller must issue it directly.
+ * Operations to a destination are applied in the order they were issued, so
+ * before an operation to a destination that has buffered or shipped
+ * operations is issued directly, those are shipped and applied. */
+static int
+agg_buffer(shmem_ctx_t ctx, int kind, void *target, const void *source,
+           size_t len, int pe, int op, int datatype)
+{
+    shmem_internal_agg_t *agg;
+    agg_rec_t *rec;
+    size_t need = sizeof(agg_rec_t) + AGG_ALIGN(len);
+    uint8_t segment;
+    uint64_t offset;
+    int direct;
+
+    /* Operations on the local PE are never buffered */
+    if (pe == shmem_internal_my_pe)
+        return 1;
+
+    agg = ((shmem_transport_ctx_t *) ctx)->agg;
+
+    direct = need > shmem_internal_params.AGGREGATE_BATCH ||
+             (kind == AGG_KIND_PUT && len > shmem_internal_params.AGGREGATE_THRESHOLD) ||
+             agg_segment(target, &segment, &offset);
+
+    SHMEM_MUTEX_LOCK(agg->lock);
+
+    if (!direct && NULL == agg->bufs[pe]) {
+        agg->bufs[pe] = malloc(sizeof(long) + shmem_internal_params.AGGREGATE_BATCH);
+        direct = (NULL == agg->bufs[pe]);
+    }
+
+    if (direct) {
+        agg_ship_one(agg, pe);
+        agg_wait_applied(agg, pe);
+        SHMEM_MUTEX_UNLOCK(agg->lock);
+        return 1;
+    }
+
+    /* A destination is on the dirty list exactly when its buffer is not
+     * empty, so a full buffer is shipped in place */
+    if (agg->used[pe] == 0) {
+        if (agg->ndirty == 0)
+            agg->oldest = shmem_internal_wtime();
+        agg->dirty[agg->ndirty++] = pe;
+    } else if (agg->used[pe] + need > shmem_internal_params.AGGREGATE_BATCH) {
+        agg_ship(agg, pe);
+    }
+
+    rec = (agg_rec_t *) (agg->bufs[pe] + sizeof(long) + agg->used[pe]);
+    rec->offset   = offset;
+    rec->len      = (uint32_t) len;
+    rec->kind     = (uint8_t) kind;
+    rec->segment  = segment;
+    rec->op       = (uint8_t) op;
+    rec->datatype = (uint8_t) datatype;
+    memcpy(rec + 1, source, len);
+    agg->used[pe] += need;
+
+    if (shmem_internal_params.AGGREGATE_FLUSH_USEC > 0 &&
+        (shmem_internal_wtime() - agg->oldest) * 1.0e6 >
+        (double) shmem_internal_params.AGGREGATE_FLUSH_USEC)
+        agg_ship_all(agg);
+
+    SHMEM_MUTEX_UNLOCK(agg->lock);
+
+    return 0;
+}
+
+
+int
+shmem_internal_agg_init(void)
+{
+    size_t size = shmem_internal_params.AGGREGATE_SIZE;
+
+    SHMEM_MUTEX_INIT(agg_list_lock);
+    SHMEM_MUTEX_INIT(agg_mailbox_lock);
+
+    if (size == 0)
+        return 0;
+
+    agg_slot_size = sizeof(agg_slot_t) + AGG_ALIGN(shmem_internal_params.AGGREGATE_BATCH);
+    agg_nslots = (long) (size / agg_slot_size);
+
+    if (agg_nslots == 0) {
+        RAISE_WARN_MSG("Aggregation mailbox (%zu) is smaller than one batch (%zu), "
+                       "operations will not be aggregated\n", size, agg_slot_size);
+        return 0;
+    }
+
+    agg_mailbox_ticket = shmem_internal_shmalloc(2 * sizeof(long) + agg_nslots * agg_slot_size);
+    if (NULL == agg_mailbox_ticket)
+        return -1;
+
+    agg_mailbox_head = agg_mailbox_ticket + 1;
+    agg_mailbox = (char *) (agg_mailbox_ticket + 2);
+    *agg_mailbox_ticket = 0;
+    *agg_mailbox_head = 0;
+    for (long i = 0; i < agg_nslots; i++) {
+        agg_slot(i)->state = AGG_STATE(i, AGG_FREE);
+        agg_slot(i)->len = 0;
+    }
+
+    if (0 != shmem_internal_team_create_ctx(&shmem_internal_team_world,
+                                            SHMEM_CTX_SERIALIZED, &agg_apply_ctx)) {
+        DEBUG_MSG("Could not create a context for applying aggregated operations\n");
+        agg_apply_ctx = SHMEM_CTX_DEFAULT;
+    }
+
+    return 0;
+}
+
+
+void
+shmem_internal_agg_fini(void)
+{
+    while (agg_list != NULL)
+        shmem_internal_agg_ctx_destroy(agg_list->ctx);
+
+    if (NULL != agg_mailbox && agg_apply_ctx != SHMEM_CTX_DEFAULT)
+        shmem_transport_ctx_destroy((shmem_transport_ctx_t *) agg_apply_ctx);
+
+    SHMEM_MUTEX_DESTROY(agg_list_lock);
+    SHMEM_MUTEX_DESTROY(agg_mailbox_lock);
+}
+
+
+int
+shmem_internal_agg_ctx_create(shmem_ctx_t ctx)
+{
+    shmem_internal_agg_t *agg;
+
+    /* Without a mailbox the context behaves like any other context */
+    if (NULL == agg_mailbox)
+        return 0;
+
+    agg = calloc(1, sizeof(shmem_internal_agg_t));
+    if (NULL == agg)
+        return -1;
+
+    agg->bufs     = calloc(shmem_internal_num_pes, sizeof(char *));
+    agg->used     = calloc(shmem_internal_num_pes, sizeof(size_t));
+    agg->dirty    = malloc(shmem_internal_num_pes * sizeof(int));
+    agg->shipped  = calloc(shmem_internal_num_pes, sizeof(long));
+    agg->applied  = calloc(shmem_internal_num_pes, sizeof(long));
+    agg->inflight = malloc(shmem_internal_num_pes * sizeof(int));
+    agg->scratch  = malloc(shmem_internal_params.AGGREGATE_BATCH);
+
+    if (NULL == agg->bufs || NULL == agg->used || NULL == agg->dirty ||
+        NULL == agg->shipped || NULL == agg->applied || NULL == agg->inflight ||
+        NULL == agg->scratch) {
+        free(agg->bufs);
+        free(agg->used);
+        free(agg->dirty);
+        free(agg->shipped);
+        free(agg->applied);
+        free(agg->inflight);
+        free(agg->scratch);
+        free(agg);
+        return -1;
+    }
+
+    agg->ctx = ctx;
+    SHMEM_MUTEX_INIT(agg->lock);
+
+    SHMEM_MUTEX_LOCK(agg_list_lock);
+    agg->next = agg_list;
+    agg_list  = agg;
+    SHMEM_MUTEX_UNLOCK(agg_list_lock);
+
+    ((shmem_transport_ctx_t *) ctx)->agg = agg;
+
+    return 0;
+}
+
+
+void
+shmem_internal_agg_ctx_destroy(shmem_ctx_t ctx)
+{
+    shmem_internal_agg_t **prev, *agg = ((shmem_transport_ctx_t *) ctx)->agg;
+
+    if (NULL == agg)
+        return;
+
+    SHMEM_MUTEX_LOCK(agg_list_lock);
+    for (prev = &agg_list; *prev != agg; prev = &(*prev)->next)
+        ;
+    *prev = agg->next;
+    SHMEM_MUTEX_UNLOCK(agg_list_lock);
+
+    agg_ship_all(agg);
+    agg_wait_applied_all(agg);
+    shmem_transport_quiet((shmem_transport_ctx_t *) ctx);
+    ((shmem_transport_ctx_t *) ctx)->agg = NULL;
+
+    for (int i = 0; i < shmem_internal_num_pes; i++)
+        free(agg->bufs[i]);
+
+    SHMEM_MUTEX_DESTROY(agg->lock);
+    free(agg->bufs);
+    free(agg->used);
+    free(agg->dirty);
+    free(agg->shipped);
+    free(agg->applied);
+    free(agg->inflight);
+    free(agg->scratch);
+    free(agg);
+}
+
+
+int
+shmem_internal_agg_put(shmem_ctx_t ctx, void *target, const void *source,
+                       size_t len, int pe)
+{
+    return agg_buffer(ctx, AGG_KIND_PUT, target, source, len, pe, 0, 0);
+}
+
+
+int
+shmem_internal_agg_atomic(shmem_ctx_t ctx, void *target, const void *source,
+                          size_t len, int pe, shm_internal_op_t op,
+                          shm_internal_datatype_t datatype)
+{
+    return agg_buffer(ctx, AGG_KIND_ATOMIC, target, source, len, pe, op, datatype);
+}
+
+
+int
+shmem_internal_agg_atomic_set(shmem_ctx_t ctx, void *target, const void *source,
+                              size_t len, int pe, shm_internal_datatype_t datatype)
+{
+    return agg_buffer(ctx, AGG_KIND_SET, target, source, len, pe, 0, datatype);
+}
+
+
+void
+shmem_internal_agg_flush(shmem_ctx_t ctx)
+{
+    shmem_internal_agg_t *agg = ((shmem_transport_ctx_t *) ctx)->agg;
+
+    SHMEM_MUTEX_LOCK(agg->lock);
+    agg_ship_all(agg);
+    SHMEM_MUTEX_UNLOCK(agg->lock);
+}
+
+
+void
+shmem_internal_agg_quiet(shmem_ctx_t ctx)
+{
+    shmem_internal_agg_t *agg = ((shmem_transport_ctx_t *) ctx)->agg;
+
+    SHMEM_MUTEX_LOCK(agg->lock);
+    agg_ship_all(agg);
+    agg_wait_applied_all(agg);
+    SHMEM_MUTEX_UNLOCK(agg->lock);
+}
+
+
+void
+shmem_internal_agg_quiet_all(void)
+{
+    shmem_internal_agg_t *agg;
+
+    SHMEM_MUTEX_LOCK(agg_list_lock);
+    for (agg = agg_list; agg != NULL; agg = agg->next) {
+        SHMEM_MUTEX_LOCK(agg->lock);
+        agg_ship_all(agg);
+        agg_wait_applied_all(agg);
+        SHMEM_MUTEX_UNLOCK(agg->lock);
+
+        shmem_transport_quiet((shmem_transport_ctx_t *) agg->ctx);
+    }
+    SHMEM_MUTEX_UNLOCK(agg_list_lock);
+}
+
+
+void
+shmem_internal_agg_progress(void)
+{
+    long head;
+
+    if (NULL == agg_mailbox)
+        return;
+
+    /* Return without locking unless the next batch is ready */
+    head = *(volatile long *) agg_mailbox_head;
+    if (*(volatile long *) &agg_slot(head)->state != AGG_STATE(head, AGG_READY))
+        return;
+
+    SHMEM_MUTEX_LOCK(agg_mailbox_lock);
+    while (agg_apply_head(agg_apply_ctx, shmem_internal_my_pe, NULL))
+        ;
+    SHMEM_MUTEX_UNLOCK(agg_mailbox_lock);
+}
@@ -0,0 +1,68 @@
+/* -*- C -*-
+ *
+ * This file is part of the Sandia OpenSHMEM software package. For license
+ * information, see the LICENSE file in the top level directory of the
+ * distribution.
+ *
+ */
+
+#ifndef SHMEM_AGGREGATE_H
+#define SHMEM_AGGREGATE_H
+
+#include "shmem_internal.h"
+#include "transport.h"
+
+/* Aggregating contexts (SHMEMX_CTX_AGGREGATE) buffer small puts and
+ * non-fetching AMOs per destination PE and ship each buffer as a single put
+ * into a slot of a symmetric ring mailbox on the destination.  The
+ * destination applies the batches in its mailbox whenever it waits in the
+ * library.  Quiet on the context waits for its batches to be applied and
+ * applies them itself, by getting each batch and issuing its operations
+ * directly, when the destination does not.  An operation the context issues
+ * directly to a destination first waits for the batches shipped there, so
+ * operations to one PE are applied in order. */
+
+struct shmem_internal_agg_t;
+typedef struct shmem_internal_agg_t shmem_internal_agg_t;
+
+/* Nonzero if ctx aggregates; the state hangs off the context object, so the
+ * communication routines test it with a single load */
+static inline int
+shmem_internal_agg_enabled(shmem_ctx_t ctx)
+{
+    return NULL != ((shmem_transport_ctx_t *) ctx)->agg;
+}
+
+int shmem_internal_agg_init(void);
+void shmem_internal_agg_fini(void);
+
+int shmem_internal_agg_ctx_create(shmem_ctx_t ctx);
+void shmem_internal_agg_ctx_destroy(shmem_ctx_t ctx);
+
+/* Each returns 0 if the operation was buffered and nonzero if the caller
+ * must issue it directly, in which case the earlier operations to pe have
+ * been applied */
+int shmem_internal_agg_put(shmem_ctx_t ctx, void *target, const void *source,
+                           size_t len, int pe);
+int shmem_internal_agg_atomic(shmem_ctx_t ctx, void *target, const void *source,
+                              size_t len, int pe, shm_internal_op_t op,
+                              shm_internal_datatype_t datatype);
+int shmem_internal_agg_atomic_set(shmem_ctx_t ctx, void *target,
+                                  const void *source, size_t len, int pe,
+                                  shm_internal_datatype_t datatype);
+
+/* Ship all buffered operations of an aggregating context (fence), or ship
+ * them and wait until they have been applied (quiet); no-ops for other
+ * contexts */
+void shmem_internal_agg_flush(shmem_ctx_t ctx);
+void shmem_internal_agg_quiet(shmem_ctx_t ctx);
+
+/* Apply the batches that have arrived in the local mailbox; called by
+ * waiting PEs */
+void shmem_internal_agg_progress(void);
+
+/* Quiet every aggregating context; called by barrier_all before it
+ * synchronizes */
+void shmem_internal_agg_quiet_all(void);
+
+#endif
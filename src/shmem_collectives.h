@@ -25,12 +25,21 @@ enum coll_type_t {
     TREE,
     DISSEM,
     RING,
-    RECDBL
+    RECDBL,
+    HIER,
+    PAIRWISE,
+    BRUCK,
+    THROTTLE,
+    PIPELINE,
+    SCATTER,
+    RABENSEIFNER
 };
 typedef enum coll_type_t coll_type_t;
 
 extern char *coll_type_str[];
 
+void shmem_internal_coll_req_drain(void);
+
 extern long *shmem_internal_barrier_all_psync;
 extern long *shmem_internal_sync_all_psync;
 
@@ -39,14 +48,22 @@ extern coll_type_t shmem_internal_bcast_type;
 extern coll_type_t shmem_internal_reduce_type;
 extern coll_type_t shmem_internal_collect_type;
 extern coll_type_t shmem_internal_fcollect_type;
+extern coll_type_t shmem_internal_alltoall_type;
+extern coll_type_t shmem_internal_scan_type;
 
-void shmem_internal_sync_linear(int PE_start, int PE_stride, int PE_size, long *pSync);
-void shmem_internal_sync_tree(int PE_start, int PE_stride, int PE_size, long *pSync);
-void shmem_internal_sync_dissem(int PE_start, int PE_stride, int PE_size, long *pSync);
+void shmem_internal_sync_linear(shmem_ctx_t ctx,
+                                int PE_start, int PE_stride, int PE_size, long *pSync);
+void shmem_internal_sync_tree(shmem_ctx_t ctx,
+                              int PE_start, int PE_stride, int PE_size, long *pSync);
+void shmem_internal_sync_dissem(shmem_ctx_t ctx,
+                                int PE_start, int PE_stride, int PE_size, long *pSync);
+void shmem_internal_sync_hier(shmem_ctx_t ctx,
+                              int PE_start, int PE_stride, int PE_size, long *pSync);
+void shmem_internal_hier_sync_free(void *hier_sync);
 
 static inline
 void
-shmem_internal_sync(int PE_start, int PE_stride, int PE_size, long *pSync)
+shmem_internal_sync(shmem_ctx_t ctx, int PE_start, int PE_stride, int PE_size, long *pSync)
 {
     if (shmem_internal_params.BARRIERS_FLUSH) {
         fflush(stdout);
@@ -58,19 +75,22 @@ shmem_internal_sync(int PE_start, int PE_stride, int PE_size, long *pSync)
     switch (shmem_internal_barrier_type) {
     case AUTO:
         if (PE_size < shmem_internal_params.COLL_CROSSOVER) {
-            shmem_internal_sync_linear(PE_start, PE_stride, PE_size, pSync);
+            shmem_internal_sync_linear(ctx, PE_start, PE_stride, PE_size, pSync);
         } else {
-            shmem_internal_sync_tree(PE_start, PE_stride, PE_size, pSync);
+            shmem_internal_sync_tree(ctx, PE_start, PE_stride, PE_size, pSync);
         }
         break;
     case LINEAR:
-        shmem_internal_sync_linear(PE_start, PE_stride, PE_size, pSync);
+        shmem_internal_sync_linear(ctx, PE_start, PE_stride, PE_size, pSync);
         break;
     case TREE:
-        shmem_internal_sync_tree(PE_start, PE_stride, PE_size, pSync);
+        shmem_internal_sync_tree(ctx, PE_start, PE_stride, PE_size, pSync);
         break;
     case DISSEM:
-        shmem_internal_sync_dissem(PE_start, PE_stride, PE_size, pSync);
+        shmem_internal_sync_dissem(ctx, PE_start, PE_stride, PE_size, pSync);
+        break;
+    case HIER:
+        shmem_internal_sync_hier(ctx, PE_start, PE_stride, PE_size, pSync);
         break;
     default:
         RAISE_ERROR_MSG("Illegal barrier/sync type (%d)\n",
@@ -87,16 +107,17 @@ static inline
 void
 shmem_internal_sync_all(void)
 {
-    shmem_internal_sync(0, 1, shmem_internal_num_pes, shmem_internal_sync_all_psync);
+    shmem_internal_coll_req_drain();
+    shmem_internal_sync(SHMEM_CTX_DEFAULT, 0, 1, shmem_internal_num_pes, shmem_internal_sync_all_psync);
 }
 
 
 static inline
 void
-shmem_internal_barrier(int PE_start, int PE_stride, int PE_size, long *pSync)
+shmem_internal_barrier(shmem_ctx_t ctx, int PE_start, int PE_stride, int PE_size, long *pSync)
 {
-    shmem_internal_quiet(SHMEM_CTX_DEFAULT);
-    shmem_internal_sync(PE_start, PE_stride, PE_size, pSync);
+    shmem_internal_quiet(ctx);
+    shmem_internal_sync(ctx, PE_start, PE_stride, PE_size, pSync);
 }
 
 
@@ -104,42 +125,66 @@ static inline
 void
 shmem_internal_barrier_all(void)
 {
+    shmem_internal_coll_req_drain();
+    shmem_internal_agg_quiet_all();
     shmem_internal_quiet(SHMEM_CTX_DEFAULT);
-    shmem_internal_sync(0, 1, shmem_internal_num_pes, shmem_internal_barrier_all_psync);
+    shmem_internal_sync(SHMEM_CTX_DEFAULT, 0, 1, shmem_internal_num_pes, shmem_internal_barrier_all_psync);
 }
 
 
-void shmem_internal_bcast_linear(void *target, const void *source, size_t len,
+void shmem_internal_bcast_linear(shmem_ctx_t ctx, void *target, const void *source, size_t len,
                                  int PE_root, int PE_start, int PE_stride, int PE_size,
                                  long *pSync, int complete);
-void shmem_internal_bcast_tree(void *target, const void *source, size_t len,
+void shmem_internal_bcast_tree(shmem_ctx_t ctx, void *target, const void *source, size_t len,
                                int PE_root, int PE_start, int PE_stride, int PE_size,
                                long *pSync, int complete);
+void shmem_internal_bcast_pipeline(shmem_ctx_t ctx, void *target, const void *source, size_t len,
+                                   int PE_root, int PE_start, int PE_stride, int PE_size,
+                                   long *pSync, int complete);
+void shmem_internal_bcast_scatter(shmem_ctx_t ctx, void *target, const void *source, size_t len,
+                                  int PE_root, int PE_start, int PE_stride, int PE_size,
+                                  long *pSync, int complete);
 
 static inline
 void
-shmem_internal_bcast(void *target, const void *source, size_t len,
+shmem_internal_bcast(shmem_ctx_t ctx, void *target, const void *source, size_t len,
                      int PE_root, int PE_start, int PE_stride, int PE_size,
                      long *pSync, int complete)
 {
     switch (shmem_internal_bcast_type) {
     case AUTO:
-        if (PE_size < shmem_internal_params.COLL_CROSSOVER) {
-            shmem_internal_bcast_linear(target, source, len, PE_root, PE_start,
-                                        PE_stride, PE_size, pSync, complete);
+        if (len < shmem_internal_params.COLL_SIZE_CROSSOVER) {
+            if (PE_size < shmem_internal_params.COLL_CROSSOVER) {
+                shmem_internal_bcast_linear(ctx, target, source, len, PE_root, PE_start,
+                                            PE_stride, PE_size, pSync, complete);
+            } else {
+                shmem_internal_bcast_tree(ctx, target, source, len, PE_root, PE_start,
+                                          PE_stride, PE_size, pSync, complete);
+            }
+        } else if (len / PE_size < shmem_internal_params.BCAST_SEGMENT_SIZE) {
+            shmem_internal_bcast_pipeline(ctx, target, source, len, PE_root, PE_start,
+                                          PE_stride, PE_size, pSync, complete);
         } else {
-            shmem_internal_bcast_tree(target, source, len, PE_root, PE_start,
-                                      PE_stride, PE_size, pSync, complete);
+            shmem_internal_bcast_scatter(ctx, target, source, len, PE_root, PE_start,
+                                         PE_stride, PE_size, pSync, complete);
         }
         break;
     case LINEAR:
-        shmem_internal_bcast_linear(target, source, len, PE_root, PE_start,
+        shmem_internal_bcast_linear(ctx, target, source, len, PE_root, PE_start,
                                     PE_stride, PE_size, pSync, complete);
         break;
     case TREE:
-        shmem_internal_bcast_tree(target, source, len, PE_root, PE_start,
+        shmem_internal_bcast_tree(ctx, target, source, len, PE_root, PE_start,
                                   PE_stride, PE_size, pSync, complete);
         break;
+    case PIPELINE:
+        shmem_internal_bcast_pipeline(ctx, target, source, len, PE_root, PE_start,
+                                      PE_stride, PE_size, pSync, complete);
+        break;
+    case SCATTER:
+        shmem_internal_bcast_scatter(ctx, target, source, len, PE_root, PE_start,
+                                     PE_stride, PE_size, pSync, complete);
+        break;
     default:
         RAISE_ERROR_MSG("Illegal broadcast type (%d)\n",
                         shmem_internal_bcast_type);
@@ -147,27 +192,52 @@ shmem_internal_bcast(void *target, const void *source, size_t len,
 }
 
 
-void shmem_internal_op_to_all_linear(void *target, const void *source, size_t count, size_t type_size,
+void shmem_internal_op_to_all_linear(shmem_ctx_t ctx,
+                                     void *target, const void *source, size_t count, size_t type_size,
                                      int PE_start, int PE_stride, int PE_size,
                                      void *pWrk, long *pSync,
                                      shm_internal_op_t op, shm_internal_datatype_t datatype);
-void shmem_internal_op_to_all_ring(void *target, const void *source, size_t count, size_t type_size,
+void shmem_internal_op_to_all_ring(shmem_ctx_t ctx,
+                                   void *target, const void *source, size_t count, size_t type_size,
                                    int PE_start, int PE_stride, int PE_size,
                                    void *pWrk, long *pSync,
                                    shm_internal_op_t op, shm_internal_datatype_t datatype);
-void shmem_internal_op_to_all_tree(void *target, const void *source, size_t count, size_t type_size,
+void shmem_internal_op_to_all_tree(shmem_ctx_t ctx,
+                                   void *target, const void *source, size_t count, size_t type_size,
                                    int PE_start, int PE_stride, int PE_size,
                                    void *pWrk, long *pSync,
                                    shm_internal_op_t op, shm_internal_datatype_t datatype);
 
-void shmem_internal_op_to_all_recdbl_sw(void *target, const void *source, size_t count, size_t type_size,
+void shmem_internal_op_to_all_recdbl_sw(shmem_ctx_t ctx,
+                                        void *target, const void *source, size_t count, size_t type_size,
                                    int PE_start, int PE_stride, int PE_size,
                                    void *pWrk, long *pSync,
                                    shm_internal_op_t op, shm_internal_datatype_t datatype);
+void shmem_internal_op_to_all_rabenseifner(shmem_ctx_t ctx,
+                                           void *target, const void *source, size_t count,
+                                           size_t type_size, int PE_start, int PE_stride,
+                                           int PE_size, void *pWrk, long *pSync,
+                                           shm_internal_op_t op,
+                                           shm_internal_datatype_t datatype);
+
+/* Rabenseifner's algorithm folds PEs beyond the largest power of two into
+ * partners, doubling their traffic.  Only auto-select it when there are
+ * few such PEs. */
+static inline
+int
+shmem_internal_reduce_rabenseifner_ok(int PE_size)
+{
+    int pow2_proc = 1;
+
+    while (pow2_proc * 2 <= PE_size)
+        pow2_proc <<= 1;
+
+    return PE_size - pow2_proc <= pow2_proc / 4;
+}
 
 static inline
 void
-shmem_internal_op_to_all(void *target, const void *source, size_t count,
+shmem_internal_op_to_all(shmem_ctx_t ctx, void *target, const void *source, size_t count,
                          size_t type_size, int PE_start, int PE_stride,
                          int PE_size, void *pWrk, long *pSync,
                          shm_internal_op_t op,
@@ -179,21 +249,26 @@ shmem_internal_op_to_all(void *target, const void *source, size_t count,
         case AUTO:
             if (shmem_transport_atomic_supported(op, datatype)) {
                 if (PE_size < shmem_internal_params.COLL_CROSSOVER) {
-                    shmem_internal_op_to_all_linear(target, source, count, type_size,
+                    shmem_internal_op_to_all_linear(ctx, target, source, count, type_size,
                                                     PE_start, PE_stride, PE_size,
                                                     pWrk, pSync, op, datatype);
                 } else {
-                    shmem_internal_op_to_all_tree(target, source, count, type_size,
+                    shmem_internal_op_to_all_tree(ctx, target, source, count, type_size,
                                                   PE_start, PE_stride, PE_size,
                                                   pWrk, pSync, op, datatype);
                 }
             } else {
                 if (count * type_size < shmem_internal_params.COLL_SIZE_CROSSOVER)
-                    shmem_internal_op_to_all_recdbl_sw(target, source, count, type_size,
+                    shmem_internal_op_to_all_recdbl_sw(ctx, target, source, count, type_size,
                                                        PE_start, PE_stride, PE_size,
                                                        pWrk, pSync, op, datatype);
+                else if (count * type_size < shmem_internal_params.REDUCE_RING_CROSSOVER &&
+                         shmem_internal_reduce_rabenseifner_ok(PE_size))
+                    shmem_internal_op_to_all_rabenseifner(ctx, target, source, count, type_size,
+                                                          PE_start, PE_stride, PE_size,
+                                                          pWrk, pSync, op, datatype);
                 else
-                    shmem_internal_op_to_all_ring(target, source, count, type_size,
+                    shmem_internal_op_to_all_ring(ctx, target, source, count, type_size,
                                                   PE_start, PE_stride, PE_size,
                                                   pWrk, pSync, op, datatype);
             }
@@ -201,36 +276,41 @@ shmem_internal_op_to_all(void *target, const void *source, size_t count,
             break;
         case LINEAR:
             if (shmem_transport_atomic_supported(op, datatype)) {
-                shmem_internal_op_to_all_linear(target, source, count, type_size,
+                shmem_internal_op_to_all_linear(ctx, target, source, count, type_size,
                                                 PE_start, PE_stride, PE_size,
                                                 pWrk, pSync, op, datatype);
             } else {
-                shmem_internal_op_to_all_recdbl_sw(target, source, count, type_size,
+                shmem_internal_op_to_all_recdbl_sw(ctx, target, source, count, type_size,
                                                    PE_start, PE_stride, PE_size,
                                                    pWrk, pSync, op, datatype);
             }
             break;
         case RING:
-            shmem_internal_op_to_all_ring(target, source, count, type_size,
+            shmem_internal_op_to_all_ring(ctx, target, source, count, type_size,
                                           PE_start, PE_stride, PE_size,
                                           pWrk, pSync, op, datatype);
             break;
         case TREE:
             if (shmem_transport_atomic_supported(op, datatype)) {
-                shmem_internal_op_to_all_tree(target, source, count, type_size,
+                shmem_internal_op_to_all_tree(ctx, target, source, count, type_size,
                                               PE_start, PE_stride, PE_size,
                                               pWrk, pSync, op, datatype);
             } else {
-                shmem_internal_op_to_all_recdbl_sw(target, source, count, type_size,
+                shmem_internal_op_to_all_recdbl_sw(ctx, target, source, count, type_size,
                                                    PE_start, PE_stride, PE_size,
                                                    pWrk, pSync, op, datatype);
             }
             break;
         case RECDBL:
-            shmem_internal_op_to_all_recdbl_sw(target, source, count, type_size,
+            shmem_internal_op_to_all_recdbl_sw(ctx, target, source, count, type_size,
                                                PE_start, PE_stride, PE_size,
                                                pWrk, pSync, op, datatype);
             break;
+        case RABENSEIFNER:
+            shmem_internal_op_to_all_rabenseifner(ctx, target, source, count, type_size,
+                                                  PE_start, PE_stride, PE_size,
+                                                  pWrk, pSync, op, datatype);
+            break;
         default:
             RAISE_ERROR_MSG("Illegal reduction type (%d)\n",
                             shmem_internal_reduce_type);
@@ -238,21 +318,90 @@ shmem_internal_op_to_all(void *target, const void *source, size_t count,
 }
 
 
-void shmem_internal_collect_linear(void *target, const void *source, size_t len,
+void shmem_internal_scan_recdbl(shmem_ctx_t ctx,
+                                void *target, const void *source, size_t count, size_t type_size,
+                                int PE_start, int PE_stride, int PE_size, long *pSync,
+                                shm_internal_op_t op, shm_internal_datatype_t datatype,
+                                int exclusive);
+void shmem_internal_scan_ring(shmem_ctx_t ctx,
+                              void *target, const void *source, size_t count, size_t type_size,
+                              int PE_start, int PE_stride, int PE_size, long *pSync,
+                              shm_internal_op_t op, shm_internal_datatype_t datatype,
+                              int exclusive);
+
+static inline
+void
+shmem_internal_scan(shmem_ctx_t ctx,
+                    void *target, const void *source, size_t count, size_t type_size,
+                    int PE_start, int PE_stride, int PE_size, long *pSync,
+                    shm_internal_op_t op, shm_internal_datatype_t datatype,
+                    int exclusive)
+{
+    shmem_internal_assert(type_size > 0);
+
+    switch (shmem_internal_scan_type) {
+        case AUTO:
+            if (count * type_size < shmem_internal_params.COLL_SIZE_CROSSOVER) {
+                shmem_internal_scan_recdbl(ctx, target, source, count, type_size,
+                                           PE_start, PE_stride, PE_size, pSync,
+                                           op, datatype, exclusive);
+            } else {
+                shmem_internal_scan_ring(ctx, target, source, count, type_size,
+                                         PE_start, PE_stride, PE_size, pSync,
+                                         op, datatype, exclusive);
+            }
+            break;
+        case RECDBL:
+            shmem_internal_scan_recdbl(ctx, target, source, count, type_size,
+                                       PE_start, PE_stride, PE_size, pSync,
+                                       op, datatype, exclusive);
+            break;
+        case RING:
+            shmem_internal_scan_ring(ctx, target, source, count, type_size,
+                                     PE_start, PE_stride, PE_size, pSync,
+                                     op, datatype, exclusive);
+            break;
+        default:
+            RAISE_ERROR_MSG("Illegal scan type (%d)\n",
+                            shmem_internal_scan_type);
+    }
+}
+
+
+void shmem_internal_collect_linear(shmem_ctx_t ctx, void *target, const void *source, size_t len,
+                                   int PE_start, int PE_stride, int PE_size, long *pSync);
+void shmem_internal_collect_ring(shmem_ctx_t ctx, void *target, const void *source, size_t len,
+                                 int PE_start, int PE_stride, int PE_size, long *pSync);
+void shmem_internal_collect_recdbl(shmem_ctx_t ctx, void *target, const void *source, size_t len,
                                    int PE_start, int PE_stride, int PE_size, long *pSync);
+void shmem_internal_collect_auto(shmem_ctx_t ctx, void *target, const void *source, size_t len,
+                                 int PE_start, int PE_stride, int PE_size, long *pSync);
 
 static inline
 void
-shmem_internal_collect(void *target, const void *source, size_t len,
+shmem_internal_collect(shmem_ctx_t ctx, void *target, const void *source, size_t len,
                   int PE_start, int PE_stride, int PE_size, long *pSync)
 {
     switch (shmem_internal_collect_type) {
     case AUTO:
-        shmem_internal_collect_linear(target, source, len, PE_start, PE_stride,
-                                      PE_size, pSync);
+        if (PE_size < shmem_internal_params.COLL_CROSSOVER) {
+            shmem_internal_collect_linear(ctx, target, source, len, PE_start, PE_stride,
+                                          PE_size, pSync);
+        } else {
+            shmem_internal_collect_auto(ctx, target, source, len, PE_start, PE_stride,
+                                        PE_size, pSync);
+        }
         break;
     case LINEAR:
-        shmem_internal_collect_linear(target, source, len, PE_start, PE_stride,
+        shmem_internal_collect_linear(ctx, target, source, len, PE_start, PE_stride,
+                                      PE_size, pSync);
+        break;
+    case RING:
+        shmem_internal_collect_ring(ctx, target, source, len, PE_start, PE_stride,
+                                    PE_size, pSync);
+        break;
+    case RECDBL:
+        shmem_internal_collect_recdbl(ctx, target, source, len, PE_start, PE_stride,
                                       PE_size, pSync);
         break;
     default:
@@ -262,40 +411,54 @@ shmem_internal_collect(void *target, const void *source, size_t len,
 }
 
 
-void shmem_internal_fcollect_linear(void *target, const void *source, size_t len,
+void shmem_internal_fcollect_linear(shmem_ctx_t ctx, void *target, const void *source, size_t len,
                                     int PE_start, int PE_stride, int PE_size, long *pSync);
-void shmem_internal_fcollect_ring(void *target, const void *source, size_t len,
+void shmem_internal_fcollect_ring(shmem_ctx_t ctx, void *target, const void *source, size_t len,
                                   int PE_start, int PE_stride, int PE_size, long *pSync);
-void shmem_internal_fcollect_recdbl(void *target, const void *source, size_t len,
+void shmem_internal_fcollect_recdbl(shmem_ctx_t ctx, void *target, const void *source, size_t len,
                                     int PE_start, int PE_stride, int PE_size, long *pSync);
+void shmem_internal_fcollect_bruck(shmem_ctx_t ctx, void *target, const void *source, size_t len,
+                                   int PE_start, int PE_stride, int PE_size, long *pSync);
 
 static inline
 void
-shmem_internal_fcollect(void *target, const void *source, size_t len,
+shmem_internal_fcollect(shmem_ctx_t ctx, void *target, const void *source, size_t len,
                    int PE_start, int PE_stride, int PE_size, long *pSync)
 {
     switch (shmem_internal_fcollect_type) {
     case AUTO:
-        shmem_internal_fcollect_ring(target, source, len, PE_start, PE_stride,
-                                     PE_size, pSync);
+        if (len * PE_size >= shmem_internal_params.COLL_SIZE_CROSSOVER) {
+            shmem_internal_fcollect_ring(ctx, target, source, len, PE_start, PE_stride,
+                                         PE_size, pSync);
+        } else if (0 == (PE_size & (PE_size - 1))) {
+            shmem_internal_fcollect_recdbl(ctx, target, source, len, PE_start, PE_stride,
+                                           PE_size, pSync);
+        } else {
+            shmem_internal_fcollect_bruck(ctx, target, source, len, PE_start, PE_stride,
+                                          PE_size, pSync);
+        }
         break;
     case LINEAR:
-        shmem_internal_fcollect_linear(target, source, len, PE_start, PE_stride,
+        shmem_internal_fcollect_linear(ctx, target, source, len, PE_start, PE_stride,
                                        PE_size, pSync);
         break;
     case RING:
-        shmem_internal_fcollect_ring(target, source, len, PE_start, PE_stride,
+        shmem_internal_fcollect_ring(ctx, target, source, len, PE_start, PE_stride,
                                      PE_size, pSync);
         break;
     case RECDBL:
         if (0 == (PE_size & (PE_size - 1))) {
-            shmem_internal_fcollect_recdbl(target, source, len, PE_start, PE_stride,
+            shmem_internal_fcollect_recdbl(ctx, target, source, len, PE_start, PE_stride,
                                            PE_size, pSync);
         } else {
-            shmem_internal_fcollect_ring(target, source, len, PE_start, PE_stride,
-                                         PE_size, pSync);
+            shmem_internal_fcollect_bruck(ctx, target, source, len, PE_start, PE_stride,
+                                          PE_size, pSync);
         }
         break;
+    case BRUCK:
+        shmem_internal_fcollect_bruck(ctx, target, source, len, PE_start, PE_stride,
+                                      PE_size, pSync);
+        break;
     default:
         RAISE_ERROR_MSG("Illegal fcollect type (%d)\n",
                         shmem_internal_fcollect_type);
@@ -303,10 +466,91 @@ shmem_internal_fcollect(void *target, const void *source, size_t len,
 }
 
 
-void shmem_internal_alltoall(void *dest, const void *source, size_t len,
-                             int PE_start, int PE_stride, int PE_size, long *pSync);
+void shmem_internal_alltoall_linear(shmem_ctx_t ctx, void *dest, const void *source, size_t len,
+                                    int PE_start, int PE_stride, int PE_size, long *pSync);
+void shmem_internal_alltoall_throttle(shmem_ctx_t ctx, void *dest, const void *source, size_t len,
+                                      int PE_start, int PE_stride, int PE_size, long *pSync);
+void shmem_internal_alltoall_pairwise(shmem_ctx_t ctx, void *dest, const void *source, size_t len,
+                                      int PE_start, int PE_stride, int PE_size, long *pSync);
+void shmem_internal_alltoall_bruck(shmem_ctx_t ctx, void *dest, const void *source, size_t len,
+                                   int PE_start, int PE_stride, int PE_size, long *pSync);
+
+static inline
+void
+shmem_internal_alltoall(shmem_ctx_t ctx, void *dest, const void *source, size_t len,
+                        int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    switch (shmem_internal_alltoall_type) {
+    case AUTO:
+        if (PE_size < shmem_internal_params.COLL_CROSSOVER) {
+            shmem_internal_alltoall_linear(ctx, dest, source, len, PE_start, PE_stride,
+                                           PE_size, pSync);
+        } else if (len <= shmem_internal_params.ALLTOALL_BRUCK_CROSSOVER) {
+            shmem_internal_alltoall_bruck(ctx, dest, source, len, PE_start, PE_stride,
+                                          PE_size, pSync);
+        } else if (len < shmem_internal_params.COLL_SIZE_CROSSOVER) {
+            shmem_internal_alltoall_throttle(ctx, dest, source, len, PE_start, PE_stride,
+                                             PE_size, pSync);
+        } else {
+            shmem_internal_alltoall_pairwise(ctx, dest, source, len, PE_start, PE_stride,
+                                             PE_size, pSync);
+        }
+        break;
+    case LINEAR:
+        shmem_internal_alltoall_linear(ctx, dest, source, len, PE_start, PE_stride,
+                                       PE_size, pSync);
+        break;
+    case PAIRWISE:
+        shmem_internal_alltoall_pairwise(ctx, dest, source, len, PE_start, PE_stride,
+                                         PE_size, pSync);
+        break;
+    case BRUCK:
+        shmem_internal_alltoall_bruck(ctx, dest, source, len, PE_start, PE_stride,
+                                      PE_size, pSync);
+        break;
+    case THROTTLE:
+        shmem_internal_alltoall_throttle(ctx, dest, source, len, PE_start, PE_stride,
+                                         PE_size, pSync);
+        break;
+    default:
+        RAISE_ERROR_MSG("Illegal alltoall type (%d)\n",
+                        shmem_internal_alltoall_type);
+    }
+}
 
-void shmem_internal_alltoalls(void *dest, const void *source, ptrdiff_t dst,
+void shmem_internal_alltoalls(shmem_ctx_t ctx, void *dest, const void *source, ptrdiff_t dst,
                               ptrdiff_t sst, size_t elem_size, size_t nelems,
                               int PE_start, int PE_stride, int PE_size, long *pSync);
+
+/* Non-blocking collectives.  The pSync must not be used by any other
+ * collective until every PE has completed the request. */
+typedef struct shmem_internal_coll_req_t shmem_internal_coll_req_t;
+
+shmem_internal_coll_req_t *shmem_internal_sync_nb(shmem_ctx_t ctx, int PE_start, int PE_stride,
+                                                  int PE_size, long *pSync);
+shmem_internal_coll_req_t *shmem_internal_bcast_nb(shmem_ctx_t ctx, void *target,
+                                                   const void *source, size_t len,
+                                                   int PE_root, int PE_start, int PE_stride,
+                                                   int PE_size, long *pSync);
+shmem_internal_coll_req_t *shmem_internal_op_to_all_nb(shmem_ctx_t ctx, void *target,
+                                                       const void *source, size_t count,
+                                                       size_t type_size, int PE_start,
+                                                       int PE_stride, int PE_size, long *pSync,
+                                                       shm_internal_op_t op,
+                                                       shm_internal_datatype_t datatype);
+shmem_internal_coll_req_t *shmem_internal_fcollect_nb(shmem_ctx_t ctx, void *target,
+                                                      const void *source, size_t len,
+                                                      int PE_start, int PE_stride, int PE_size,
+                                                      long *pSync);
+shmem_internal_coll_req_t *shmem_internal_alltoall_nb(shmem_ctx_t ctx, void *dest,
+                                                      const void *source, size_t len,
+                                                      int PE_start, int PE_stride, int PE_size,
+                                                      long *pSync);
+int shmem_internal_coll_req_test(shmem_internal_coll_req_t *req);
+void shmem_internal_coll_req_wait(shmem_internal_coll_req_t *req);
+
+typedef void (*shmem_internal_coll_notify_fn_t)(shmem_ctx_t ctx, void *arg, long value);
+void shmem_internal_coll_req_notify(shmem_ctx_t ctx, shmem_internal_coll_notify_fn_t fn,
+                                    void *arg, long value);
+
 #endif
@@ -29,6 +29,7 @@
 
 #include "transport.h"
 #include "shr_transport.h"
+#include "shmem_aggregate.h"
 
 static inline
 void
@@ -38,6 +39,10 @@ shmem_internal_put_nb(shmem_ctx_t ctx, void *target, const void *source, size_t
     if (len == 0)
         return;
 
+    if (shmem_internal_agg_enabled(ctx) &&
+        0 == shmem_internal_agg_put(ctx, target, source, len, pe))
+        return;
+
     if (shmem_shr_transport_use_write(ctx, target, source, len, pe)) {
         shmem_shr_transport_put(ctx, target, source, len, pe);
     } else {
@@ -61,6 +66,10 @@ shmem_internal_put_scalar(shmem_ctx_t ctx, void *target, const void *source, siz
 {
     shmem_internal_assert(len > 0);
 
+    if (shmem_internal_agg_enabled(ctx) &&
+        0 == shmem_internal_agg_put(ctx, target, source, len, pe))
+        return;
+
     if (shmem_shr_transport_use_write(ctx, target, source, len, pe)) {
         shmem_shr_transport_put_scalar(ctx, target, source, len, pe);
     } else {
@@ -102,6 +111,10 @@ shmem_internal_put_nbi(shmem_ctx_t ctx, void *target, const void *source, size_t
 {
     if (len == 0) return;
 
+    if (shmem_internal_agg_enabled(ctx) &&
+        0 == shmem_internal_agg_put(ctx, target, source, len, pe))
+        return;
+
     if (shmem_shr_transport_use_write(ctx, target, source, len, pe)) {
         shmem_shr_transport_put(ctx, target, source, len, pe);
     } else {
@@ -110,6 +123,29 @@ shmem_internal_put_nbi(shmem_ctx_t ctx, void *target, const void *source, size_t
 }
 
 
+/* Strides are in units of elements.  On-node transfers are handed to the
+ * shared memory transport as a whole so that it can batch them. */
+static inline
+void
+shmem_internal_iput(shmem_ctx_t ctx, void *target, const void *source,
+                    ptrdiff_t tst, ptrdiff_t sst, size_t elem_size,
+                    size_t nelems, int pe)
+{
+    if (nelems == 0) return;
+
+    if (shmem_shr_transport_use_write(ctx, target, source, elem_size, pe)) {
+        shmem_shr_transport_iput(ctx, target, source, tst, sst, elem_size,
+                                 nelems, pe);
+    } else {
+        for ( ; nelems > 0; --nelems) {
+            shmem_internal_put_scalar(ctx, target, source, elem_size, pe);
+            target = (uint8_t *) target + tst * elem_size;
+            source = (const uint8_t *) source + sst * elem_size;
+        }
+    }
+}
+
+
 static inline
 void
 shmem_internal_put_ct_nb(shmemx_ct_t ct, void *target, const void *source, size_t len, int pe,
@@ -135,6 +171,29 @@ shmem_internal_get(shmem_ctx_t ctx, void *target, const void *source, size_t len
 }
 
 
+/* Completion of the off-node path requires shmem_internal_get_wait */
+static inline
+void
+shmem_internal_iget(shmem_ctx_t ctx, void *target, const void *source,
+                    ptrdiff_t tst, ptrdiff_t sst, size_t elem_size,
+                    size_t nelems, int pe)
+{
+    if (nelems == 0) return;
+
+    if (shmem_shr_transport_use_read(ctx, target, source, elem_size, pe)) {
+        shmem_shr_transport_iget(ctx, target, source, tst, sst, elem_size,
+                                 nelems, pe);
+    } else {
+        for ( ; nelems > 0; --nelems) {
+            shmem_transport_get((shmem_transport_ctx_t *)ctx, target, source,
+                                elem_size, pe);
+            target = (uint8_t *) target + tst * elem_size;
+            source = (const uint8_t *) source + sst * elem_size;
+        }
+    }
+}
+
+
 static inline
 void
 shmem_internal_get_ct(shmemx_ct_t ct, void *target, const void *source, size_t len, int pe)
@@ -241,6 +300,10 @@ shmem_internal_atomic(shmem_ctx_t ctx, void *target, const void *source, size_t
 {
     shmem_internal_assert(len > 0);
 
+    if (shmem_internal_agg_enabled(ctx) &&
+        0 == shmem_internal_agg_atomic(ctx, target, source, len, pe, op, datatype))
+        return;
+
     if (shmem_shr_transport_use_atomic(ctx, target, len, pe, datatype)) {
         shmem_shr_transport_atomic(ctx, target, source, len, pe, op, datatype);
     } else {
@@ -273,6 +336,10 @@ shmem_internal_atomic_set(shmem_ctx_t ctx, void *target, const void *source, siz
 {
     shmem_internal_assert(len > 0);
 
+    if (shmem_internal_agg_enabled(ctx) &&
+        0 == shmem_internal_agg_atomic_set(ctx, target, source, len, pe, datatype))
+        return;
+
     if (shmem_shr_transport_use_atomic(ctx, target, len, pe, datatype)) {
         shmem_shr_transport_atomic_set(ctx, target, source, len, pe, datatype);
     } else {
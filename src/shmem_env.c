@@ -222,6 +222,8 @@ printf("\nOn-node transport: %s\n",
        "Linux CMA"
 #elif defined(USE_XPMEM)
        "XPMEM"
+#elif defined(USE_SHM)
+       "POSIX shared memory"
 #elif defined(USE_MEMCPY)
        "memcpy"
 #else
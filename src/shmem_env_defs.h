@@ -30,12 +30,28 @@ SHMEM_INTERNAL_ENV_DEF(DEBUG, bool, false, SHMEM_INTERNAL_ENV_CAT_OPENSHMEM,
                        "Enable debugging messages")
 SHMEM_INTERNAL_ENV_DEF(SYMMETRIC_SIZE, size, 512*1024*1024, SHMEM_INTERNAL_ENV_CAT_OPENSHMEM,
                        "Symmetric heap size")
+SHMEM_INTERNAL_ENV_DEF(SYMMETRIC_HEAP_ATOMICS_SIZE, size, 2*1024*1024, SHMEM_INTERNAL_ENV_CAT_OTHER,
+                       "Size of the sub-heap for SHMEM_MALLOC_ATOMICS_REMOTE/SIGNAL_REMOTE allocations")
+SHMEM_INTERNAL_ENV_DEF(SYMMETRIC_REALLOC_IN_PLACE, bool, true, SHMEM_INTERNAL_ENV_CAT_OTHER,
+                       "Let shmem_realloc resize blocks in place with a single reduction")
+SHMEM_INTERNAL_ENV_DEF(SYMMETRIC_HEAP_MAX_SIZE, size, 0, SHMEM_INTERNAL_ENV_CAT_OTHER,
+                       "Size of the address range reserved for symmetric heap growth (0 disables)")
 
 #ifdef __linux__
 SHMEM_INTERNAL_ENV_DEF(SYMMETRIC_HEAP_USE_HUGE_PAGES, bool, false, SHMEM_INTERNAL_ENV_CAT_OTHER,
                        "Use Linux huge pages for symmetric heap")
 SHMEM_INTERNAL_ENV_DEF(SYMMETRIC_HEAP_PAGE_SIZE, size, 2*1024*1024, SHMEM_INTERNAL_ENV_CAT_OTHER,
                        "Page size to use for huge pages")
+SHMEM_INTERNAL_ENV_DEF(SYMMETRIC_HEAP_USE_THP, bool, false, SHMEM_INTERNAL_ENV_CAT_OTHER,
+                       "Use transparent huge pages for symmetric heap")
+#endif
+SHMEM_INTERNAL_ENV_DEF(SYMMETRIC_HEAP_PREFAULT_THREADS, long, 0, SHMEM_INTERNAL_ENV_CAT_OTHER,
+                       "Number of threads used to pre-fault the symmetric heap (0 disables)")
+#ifdef ENABLE_THREADS
+SHMEM_INTERNAL_ENV_DEF(MALLOC_CACHE_MAX_SIZE, size, 4096, SHMEM_INTERNAL_ENV_CAT_OTHER,
+                       "Largest non-collective allocation served from per-thread caches (0 disables)")
+SHMEM_INTERNAL_ENV_DEF(MALLOC_CACHE_DEPTH, long, 64, SHMEM_INTERNAL_ENV_CAT_OTHER,
+                       "Number of freed blocks of each size class kept in a thread's cache")
 #endif
 #if defined(ENABLE_REMOTE_VIRTUAL_ADDRESSING) && defined(__linux__) && !defined(DISABLE_ASLR_CHECK_AC)
 SHMEM_INTERNAL_ENV_DEF(DISABLE_ASLR_CHECK, bool, false, SHMEM_INTERNAL_ENV_CAT_OTHER,
@@ -48,6 +64,16 @@ SHMEM_INTERNAL_ENV_DEF(BOUNCE_SIZE, size, DEFAULT_BOUNCE_SIZE, SHMEM_INTERNAL_EN
                        "Maximum message size to bounce buffer")
 SHMEM_INTERNAL_ENV_DEF(MAX_BOUNCE_BUFFERS, long, 128, SHMEM_INTERNAL_ENV_CAT_OTHER,
                        "Maximum number of bounce buffers per context")
+SHMEM_INTERNAL_ENV_DEF(AGGREGATE_SIZE, size, 0, SHMEM_INTERNAL_ENV_CAT_OTHER,
+                       "Ring mailbox for operations aggregated by SHMEMX_CTX_AGGREGATE contexts (0 disables)")
+SHMEM_INTERNAL_ENV_DEF(AGGREGATE_BATCH, size, 8192, SHMEM_INTERNAL_ENV_CAT_OTHER,
+                       "Per-destination buffer of an aggregating context (bytes)")
+SHMEM_INTERNAL_ENV_DEF(AGGREGATE_THRESHOLD, size, 256, SHMEM_INTERNAL_ENV_CAT_OTHER,
+                       "Largest put buffered by an aggregating context (bytes)")
+SHMEM_INTERNAL_ENV_DEF(AGGREGATE_FLUSH_USEC, long, 1000, SHMEM_INTERNAL_ENV_CAT_OTHER,
+                       "Age at which an aggregating context ships its buffers (usec, 0 disables)")
+SHMEM_INTERNAL_ENV_DEF(PMI_NODE_MAPPING, string, "auto", SHMEM_INTERNAL_ENV_CAT_OTHER,
+                       "Node locality discovery for PMI runtimes.  Options are auto, process_mapping, hostname")
 SHMEM_INTERNAL_ENV_DEF(TRAP_ON_ABORT, bool, false, SHMEM_INTERNAL_ENV_CAT_OTHER,
                        "Generate trap if the program aborts or calls shmem_global_exit")
 
@@ -58,22 +84,42 @@ SHMEM_INTERNAL_ENV_DEF(COLL_SIZE_CROSSOVER, size, 16384, SHMEM_INTERNAL_ENV_CAT_
 SHMEM_INTERNAL_ENV_DEF(COLL_RADIX, long, 4, SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
                        "Radix for tree-based collectives")
 SHMEM_INTERNAL_ENV_DEF(BARRIER_ALGORITHM, string, "auto", SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
-                       "Algorithm for barrier.  Options are auto, linear, tree, dissem")
+                       "Algorithm for barrier.  Options are auto, linear, tree, dissem, hier")
 SHMEM_INTERNAL_ENV_DEF(BCAST_ALGORITHM, string, "auto", SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
-                       "Algorithm for broadcast.  Options are auto, linear, tree")
+                       "Algorithm for broadcast.  Options are auto, linear, tree, pipeline, scatter")
+SHMEM_INTERNAL_ENV_DEF(BCAST_SEGMENT_SIZE, size, 65536, SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
+                       "Pipeline segment size for the pipelined tree broadcast (bytes)")
 SHMEM_INTERNAL_ENV_DEF(REDUCE_ALGORITHM, string, "auto", SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
-                       "Algorithm for reductions.  Options are auto, linear, tree, recdbl")
+                       "Algorithm for reductions.  Options are auto, linear, tree, recdbl, ring, rabenseifner")
+SHMEM_INTERNAL_ENV_DEF(REDUCE_RING_CROSSOVER, size, 4*1024*1024, SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
+                       "Crossover between Rabenseifner and ring reductions (msg. size)")
 SHMEM_INTERNAL_ENV_DEF(COLLECT_ALGORITHM, string, "auto", SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
-                       "Algorithm for collect.  Options are auto, linear")
+                       "Algorithm for collect.  Options are auto, linear, ring, recdbl")
 SHMEM_INTERNAL_ENV_DEF(FCOLLECT_ALGORITHM, string, "auto", SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
-                       "Algorithm for fcollect.  Options are auto, linear, ring, recdbl")
+                       "Algorithm for fcollect.  Options are auto, linear, ring, recdbl, bruck")
+SHMEM_INTERNAL_ENV_DEF(SCAN_ALGORITHM, string, "auto", SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
+                       "Algorithm for scan.  Options are auto, recdbl, ring")
+SHMEM_INTERNAL_ENV_DEF(SCAN_SEGMENT_SIZE, size, 8192, SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
+                       "Pipeline segment size for the ring scan (bytes)")
+SHMEM_INTERNAL_ENV_DEF(ALLTOALL_ALGORITHM, string, "auto", SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
+                       "Algorithm for alltoall.  Options are auto, linear, pairwise, bruck, throttle")
+SHMEM_INTERNAL_ENV_DEF(ALLTOALL_THROTTLE, long, 32, SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
+                       "Maximum number of outstanding puts in the throttled alltoall")
+SHMEM_INTERNAL_ENV_DEF(ALLTOALL_BRUCK_CROSSOVER, size, 256, SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
+                       "Largest block size for which auto selects the Bruck alltoall (bytes)")
+SHMEM_INTERNAL_ENV_DEF(ALLTOALL_SCRATCH, size, 65536, SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
+                       "Symmetric scratch space reserved for the Bruck alltoall and packed alltoalls (bytes)")
 SHMEM_INTERNAL_ENV_DEF(BARRIERS_FLUSH, bool, false, SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
                         "Flush stdout and stderr on barrier")
 
 SHMEM_INTERNAL_ENV_DEF(TEAMS_MAX, long, DEFAULT_TEAMS_MAX, SHMEM_INTERNAL_ENV_CAT_OTHER,
                        "Maximum number of teams per PE")
+SHMEM_INTERNAL_ENV_DEF(TEAM_PSYNC_DEPTH, long, 8, SHMEM_INTERNAL_ENV_CAT_OTHER,
+                       "Number of pSyncs per team for back-to-back collectives")
 SHMEM_INTERNAL_ENV_DEF(TEAM_SHARED_ONLY_SELF, bool, false, SHMEM_INTERNAL_ENV_CAT_OTHER,
                        "Include only the self PE in SHMEM_TEAM_SHARED")
+SHMEM_INTERNAL_ENV_DEF(TEAM_COLLECTIVE_CTX, bool, false, SHMEM_INTERNAL_ENV_CAT_OTHER,
+                       "Run team collectives on a per-team context")
 
 #ifdef USE_CMA
 SHMEM_INTERNAL_ENV_DEF(CMA_PUT_MAX, size, 8*1024, SHMEM_INTERNAL_ENV_CAT_INTRANODE,
@@ -82,6 +128,11 @@ SHMEM_INTERNAL_ENV_DEF(CMA_GET_MAX, size, 16*1024, SHMEM_INTERNAL_ENV_CAT_INTRAN
                        "Size below which to use CMA for gets")
 #endif /* USE_CMA */
 
+#ifdef USE_XPMEM
+SHMEM_INTERNAL_ENV_DEF(XPMEM_ATTACH_CACHE_SIZE, long, 0, SHMEM_INTERNAL_ENV_CAT_INTRANODE,
+                       "Max. number of peer segments kept attached (0 for no limit)")
+#endif /* USE_XPMEM */
+
 #ifdef USE_OFI
 SHMEM_INTERNAL_ENV_DEF(OFI_ATOMIC_CHECKS_WARN, bool, false, SHMEM_INTERNAL_ENV_CAT_TRANSPORT,
                        "Display warnings about unsupported atomic operations")
@@ -107,6 +158,8 @@ SHMEM_INTERNAL_ENV_DEF(OFI_STX_ALLOCATOR, string, "round-robin", SHMEM_INTERNAL_
                        "Algorithm for allocating STX resources to contexts")
 SHMEM_INTERNAL_ENV_DEF(OFI_STX_DISABLE_PRIVATE, bool, false, SHMEM_INTERNAL_ENV_CAT_TRANSPORT,
                        "Disallow private contexts from having exclusive STX access")
+SHMEM_INTERNAL_ENV_DEF(OFI_AV_LAZY, bool, false, SHMEM_INTERNAL_ENV_CAT_TRANSPORT,
+                       "Insert peer addresses into the address vector on first use")
 SHMEM_INTERNAL_ENV_DEF(OFI_DISABLE_MULTIRAIL, bool, false, SHMEM_INTERNAL_ENV_CAT_TRANSPORT,
                        "Disable usage of multirail functionality")
 #endif
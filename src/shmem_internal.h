@@ -39,6 +39,8 @@ extern int shmem_internal_thread_level;
 
 extern void *shmem_internal_heap_base;
 extern long shmem_internal_heap_length;
+extern void *shmem_internal_atomics_heap_base;
+extern long shmem_internal_atomics_heap_length;
 extern void *shmem_internal_data_base;
 extern long shmem_internal_data_length;
 
@@ -473,6 +475,7 @@ void shmem_internal_global_exit(int status) SHMEM_ATTRIBUTE_NORETURN;
 
 int shmem_internal_symmetric_init(void);
 int shmem_internal_symmetric_fini(void);
+void shmem_internal_symmetric_print_info(void);
 int shmem_internal_collectives_init(void);
 
 /* internal allocation, without a barrier */
@@ -480,12 +483,26 @@ void *shmem_internal_shmalloc(size_t size);
 void* shmem_internal_get_next(intptr_t incr);
 
 void dlfree(void*);
+void shmem_internal_atomics_heap_free(void *ptr);
+
+/* Is ptr in the sub-heap used for SHMEM_MALLOC_ATOMICS_REMOTE and
+ * SHMEM_MALLOC_SIGNAL_REMOTE allocations? */
+static inline int shmem_internal_in_atomics_heap(const void *ptr)
+{
+    return (const char *) ptr >= (const char *) shmem_internal_atomics_heap_base &&
+           (const char *) ptr < (const char *) shmem_internal_atomics_heap_base +
+                                shmem_internal_atomics_heap_length;
+}
 
 static inline void shmem_internal_free(void *ptr)
 {
     /* It's fine to call dlfree with NULL, but better to avoid unnecessarily
      * taking the mutex in the threaded case. */
     if (ptr != NULL) {
+        if (shmem_internal_in_atomics_heap(ptr)) {
+            shmem_internal_atomics_heap_free(ptr);
+            return;
+        }
         SHMEM_MUTEX_LOCK(shmem_internal_mutex_alloc);
         dlfree(ptr);
         SHMEM_MUTEX_UNLOCK(shmem_internal_mutex_alloc);
@@ -614,12 +631,78 @@ void shmem_internal_bit_to_string(char *str, size_t str_size,
     }
 }
 
+/* Active sets are normally the arithmetic progression
+ * (PE_start, PE_stride, PE_size).  Teams with arbitrary membership are passed
+ * to the collectives as (first PE, SHMEM_INTERNAL_STRIDE_MAPPED(idx), size),
+ * where idx selects the team's translation table.  Strides of strided active
+ * sets are bounded by the number of PEs, so they never fall in that range. */
+typedef struct {
+    int  size;
+    int  my_rank;            /* -1 if this PE is not a member */
+    int *pes;                /* rank -> PE */
+    int *pe_ranks;           /* (PE, rank) pairs sorted by PE */
+    void *hier_sync;         /* Node-aware barrier layout, built on first use */
+} shmem_internal_pe_map_t;
+
+extern shmem_internal_pe_map_t **shmem_internal_pe_maps;
+
+#define SHMEM_INTERNAL_STRIDE_MAPPED(idx)    (INT_MIN + (idx))
+#define SHMEM_INTERNAL_STRIDE_IS_MAPPED(s)   ((s) < INT_MIN / 2)
+#define SHMEM_INTERNAL_STRIDE_MAP(s)         (shmem_internal_pe_maps[(s) - INT_MIN])
+
+/* Rank of global_pe in a translation table, or -1 */
+static inline
+int shmem_internal_pe_map_rank(const shmem_internal_pe_map_t *map, int global_pe)
+{
+    int lo = 0, hi = map->size - 1;
+
+    if (global_pe == shmem_internal_my_pe)
+        return map->my_rank;
+
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        int pe = map->pe_ranks[2 * mid];
+
+        if (pe == global_pe)
+            return map->pe_ranks[2 * mid + 1];
+        else if (pe < global_pe)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+
+    return -1;
+}
+
+/* Global PE of the given rank in an active set */
+static inline
+int shmem_internal_as_pe(int PE_start, int PE_stride, int rank)
+{
+    if (SHMEM_INTERNAL_STRIDE_IS_MAPPED(PE_stride))
+        return SHMEM_INTERNAL_STRIDE_MAP(PE_stride)->pes[rank];
+    else
+        return PE_start + rank * PE_stride;
+}
+
+/* Rank of a global PE known to be a member of an active set */
+static inline
+int shmem_internal_as_rank(int PE_start, int PE_stride, int global_pe)
+{
+    if (SHMEM_INTERNAL_STRIDE_IS_MAPPED(PE_stride))
+        return shmem_internal_pe_map_rank(SHMEM_INTERNAL_STRIDE_MAP(PE_stride), global_pe);
+    else
+        return (global_pe - PE_start) / PE_stride;
+}
+
 /* Return -1 if `global_pe` is not in the given active set.
  * If `global_pe` is in the active set, return the PE index within this set. */
 static inline
 int shmem_internal_pe_in_active_set(int global_pe, int PE_start, int PE_stride, int PE_size)
 {
     shmem_internal_assert(PE_stride != 0);
+    if (SHMEM_INTERNAL_STRIDE_IS_MAPPED(PE_stride))
+        return shmem_internal_pe_map_rank(SHMEM_INTERNAL_STRIDE_MAP(PE_stride), global_pe);
+
     int n = (global_pe - PE_start) / PE_stride;
     if ((global_pe < PE_start && PE_stride > 0) || (global_pe > PE_start && PE_stride < 0) ||
         (global_pe - PE_start) % PE_stride || n >= PE_size)
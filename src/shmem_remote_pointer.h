@@ -19,6 +19,22 @@
 #include "shmem_comm.h"
 
 
+/* Whether shmem_internal_ptr returns a pointer for the given PE, without
+ * mapping any of its memory */
+static inline int
+shmem_internal_ptr_reachable(int pe)
+{
+    if (pe == shmem_internal_my_pe)
+        return 1;
+
+#if USE_XPMEM || USE_SHM
+    return -1 != shmem_internal_get_shr_rank(pe);
+#else
+    return 0;
+#endif
+}
+
+
 static inline void *
 shmem_internal_ptr(const void *target, int pe)
 {
@@ -34,6 +50,8 @@ shmem_internal_ptr(const void *target, int pe)
     if (-1 != (node_rank = shmem_internal_get_shr_rank(pe))) {
 #if USE_XPMEM
         return shmem_transport_xpmem_ptr(target, pe, node_rank);
+#elif USE_SHM
+        return shmem_transport_shm_ptr(target, pe, node_rank);
 #else
         return NULL;
 #endif
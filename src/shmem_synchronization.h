@@ -28,6 +28,9 @@ shmem_internal_quiet(shmem_ctx_t ctx)
     if (ctx == SHMEM_CTX_INVALID)
         return;
 
+    if (shmem_internal_agg_enabled(ctx))
+        shmem_internal_agg_quiet(ctx);
+
     ret = shmem_transport_quiet((shmem_transport_ctx_t *)ctx);
     if (0 != ret) { RAISE_ERROR(ret); }
 
@@ -49,6 +52,9 @@ shmem_internal_fence(shmem_ctx_t ctx)
     if (ctx == SHMEM_CTX_INVALID)
         return;
 
+    if (shmem_internal_agg_enabled(ctx))
+        shmem_internal_agg_flush(ctx);
+
     ret = shmem_transport_fence((shmem_transport_ctx_t *)ctx);
     if (0 != ret) { RAISE_ERROR(ret); }
 
@@ -99,10 +105,23 @@ shmem_internal_fence(shmem_ctx_t ctx)
 
 #define SHMEM_TEST(type, a, b, ret) COMP(type, SYNC_LOAD(a), b, ret)
 
+/* Waiting PEs also apply the aggregated operations shipped to them and
+ * progress their outstanding non-blocking collectives, either of which
+ * peers may be waiting on */
+void shmem_internal_coll_reqs_progress(void);
+
+static inline void
+shmem_internal_progress(void)
+{
+    shmem_transport_probe();
+    shmem_internal_agg_progress();
+    shmem_internal_coll_reqs_progress();
+}
+
 #define SHMEM_WAIT_POLL(var, value)                      \
     do {                                                 \
         while (SYNC_LOAD(var) == value) {                \
-            shmem_transport_probe();                     \
+            shmem_internal_progress();                   \
             SPINLOCK_BODY(); }                           \
     } while(0)
 
@@ -112,7 +131,7 @@ shmem_internal_fence(shmem_ctx_t ctx)
                                                          \
         COMP(cond, SYNC_LOAD(var), value, cmpret);       \
         while (!cmpret) {                                \
-            shmem_transport_probe();                     \
+            shmem_internal_progress();                   \
             SPINLOCK_BODY();                             \
             COMP(cond, SYNC_LOAD(var), value, cmpret);   \
         }                                                \
@@ -124,7 +143,7 @@ shmem_internal_fence(shmem_ctx_t ctx)
                                                                         \
         COMP_SIGNAL(cond, SYNC_LOAD(var), value, cmpret, sat_value);    \
         while (!cmpret) {                                               \
-            shmem_transport_probe();                                    \
+            shmem_internal_progress();                                  \
             SPINLOCK_BODY();                                            \
             COMP_SIGNAL(cond, SYNC_LOAD(var), value, cmpret, sat_value);\
         }                                                               \
@@ -135,6 +154,7 @@ shmem_internal_fence(shmem_ctx_t ctx)
         uint64_t target_cntr;                                           \
                                                                         \
         while (SYNC_LOAD(var) == value) {                               \
+            shmem_internal_progress();                                  \
             target_cntr = shmem_transport_received_cntr_get();          \
             COMPILER_FENCE();                                           \
             if (SYNC_LOAD(var) != value) break;                         \
@@ -149,6 +169,7 @@ shmem_internal_fence(shmem_ctx_t ctx)
                                                                         \
         COMP(cond, SYNC_LOAD(var), value, cmpret);                      \
         while (!cmpret) {                                               \
+            shmem_internal_progress();                                  \
             target_cntr = shmem_transport_received_cntr_get();          \
             COMPILER_FENCE();                                           \
             COMP(cond, SYNC_LOAD(var), value, cmpret);                  \
@@ -165,6 +186,7 @@ shmem_internal_fence(shmem_ctx_t ctx)
                                                                         \
         COMP_SIGNAL(cond, SYNC_LOAD(var), value, cmpret, sat_value);    \
         while (!cmpret) {                                               \
+            shmem_internal_progress();                                  \
             target_cntr = shmem_transport_received_cntr_get();          \
             COMPILER_FENCE();                                           \
             COMP_SIGNAL(cond, SYNC_LOAD(var), value, cmpret, sat_value);\
@@ -16,7 +16,7 @@
 #include "shmem_collectives.h"
 #include "shmem_remote_pointer.h"
 
-#include <math.h>
+#include <stdlib.h>
 
 #define SHMEM_TEAM_WORLD_INDEX   0
 #define SHMEM_TEAM_SHARED_INDEX  1
@@ -24,7 +24,9 @@
 #define SHMEM_TEAMS_MIN          3
 
 #define N_PSYNC_BYTES             8
-#define PSYNC_CHUNK_SIZE          (N_PSYNCS_PER_TEAM * SHMEM_SYNC_SIZE)
+#define PSYNC_CHUNK_SIZE          (psync_depth * SHMEM_SYNC_SIZE)
+/* split_color exchanges (color, key, pSync availability) per PE */
+#define COLOR_KEY_INTS            (2 + N_PSYNC_BYTES / sizeof(int))
 
 
 shmem_internal_team_t shmem_internal_team_world;
@@ -41,38 +43,149 @@ long *shmem_internal_psync_pool;
 long *shmem_internal_psync_barrier_pool;
 static unsigned char *psync_pool_avail;
 static unsigned char *psync_pool_avail_reduced;
+static unsigned char *psync_pool_avail_contrib;
+
+/* Each team has a ring of psync_depth pSyncs for back-to-back collectives.
+ * Collective number n on a team uses pSync n % psync_depth, which is safe
+ * once every PE has finished collective n - psync_depth.  To track this,
+ * the ring is split in two halves.  When a PE starts the first collective
+ * in a half, it increments a counter at the team's first PE as soon as it
+ * has finished all previous collectives (an epoch).  The PE whose
+ * announcement completes an epoch increments a release counter on every
+ * member.  Before reusing a half, a PE waits locally for the release of the
+ * epoch that retired it, which normally arrived long ago.
+ *
+ * A PE announces epoch e + 3 only after waiting for the release of e + 1,
+ * so announcements of epoch e go to counter e % EPOCH_COUNTERS and the
+ * counter holds none of a later epoch until all of e have arrived. */
+#define EPOCH_COUNTERS 3
+#define EPOCH_SLOTS    (EPOCH_COUNTERS + 1)
+
+static long psync_depth;
+static long *psync_epoch_pool;
 
-static int *team_ret_val;
-static int *team_ret_val_reduced;
+/* Translation tables of teams that are not an arithmetic progression of
+ * PEs, indexed by the team's pSync slot */
+shmem_internal_pe_map_t **shmem_internal_pe_maps;
 
-/* Checks whether a PE has a consistent stride given (start, stride, size).
- * This function is useful within a loop across PE IDs, and sets 'start',
- * 'stride' and 'size' accordingly upon exiting the loop. It also assumes
- * 'start' and 'stride' are initialized to a negative number and 'size' to 0.
- * If an inconsistent stride is found, returns -1. */
-static inline
-int check_for_linear_stride(int pe, int *start, int *stride, int *size)
+/* Symmetric scratch space for the exchange in split_color: this PE's entry
+ * followed by one entry per parent team member */
+static int *team_color_key;
+
+static int compare_int_pairs(const void *a, const void *b)
 {
-    if (*start < 0) {
-        *start = pe;
-        (*size)++;
-    } else if (*stride < 0) {
-        *stride = pe - *start;
-        (*size)++;
-    } else if ((pe - *start) % *stride != 0) {
-        RAISE_WARN_MSG("Detected non-uniform stride inserting PE %d into <%d, %d, %d>\n",
-                       pe, *start, *stride, *size);
-        return -1;
+    const int *x = (const int *) a;
+    const int *y = (const int *) b;
+
+    if (x[0] != y[0]) return (x[0] < y[0]) ? -1 : 1;
+    if (x[1] != y[1]) return (x[1] < y[1]) ? -1 : 1;
+    return 0;
+}
+
+/* Builds the translation table for the PE list pes (rank -> PE), taking
+ * ownership of the list */
+static shmem_internal_pe_map_t *team_map_create(int *pes, int size)
+{
+    shmem_internal_pe_map_t *map = malloc(sizeof(shmem_internal_pe_map_t));
+    if (NULL == map)
+        RAISE_ERROR_STR("Out of memory allocating team translation table");
+
+    map->size      = size;
+    map->my_rank   = -1;
+    map->pes       = pes;
+    map->pe_ranks  = malloc(2 * size * sizeof(int));
+    map->hier_sync = NULL;
+    if (NULL == map->pe_ranks)
+        RAISE_ERROR_STR("Out of memory allocating team translation table");
+
+    for (int i = 0; i < size; i++) {
+        map->pe_ranks[2 * i]     = pes[i];
+        map->pe_ranks[2 * i + 1] = i;
+        if (pes[i] == shmem_internal_my_pe)
+            map->my_rank = i;
+    }
+
+    qsort(map->pe_ranks, size, 2 * sizeof(int), compare_int_pairs);
+
+    return map;
+}
+
+static void team_map_free(shmem_internal_pe_map_t *map)
+{
+    shmem_internal_hier_sync_free(map->hier_sync);
+    free(map->pe_ranks);
+    free(map->pes);
+    free(map);
+}
+
+/* Sets the members of a team from its PE list (rank -> PE), taking ownership
+ * of the list.  Lists forming an increasing arithmetic progression are stored
+ * as (start, stride, size); all others get a translation table, registered
+ * under the team's pSync slot. */
+static void team_set_pes(shmem_internal_team_t *team, int *pes, int size)
+{
+    int stride = (size > 1) ? pes[1] - pes[0] : 1;
+    int linear = (stride > 0);
+
+    for (int i = 2; i < size && linear; i++)
+        linear = (pes[i] - pes[i-1] == stride);
+
+    team->start = pes[0];
+    team->size  = size;
+
+    if (linear) {
+        team->stride = stride;
+        free(pes);
     } else {
-        (*size)++;
+        shmem_internal_assert(shmem_internal_pe_maps[team->psync_idx] == NULL);
+        shmem_internal_pe_maps[team->psync_idx] = team_map_create(pes, size);
+        team->stride = SHMEM_INTERNAL_STRIDE_MAPPED(team->psync_idx);
     }
-    return 0;
+
+    team->my_pe = shmem_internal_pe_in_active_set(shmem_internal_my_pe, team->start,
+                                                  team->stride, team->size);
 }
 
 /* Team Management Routines */
 
+/* Creates the context used for collectives over the team.  Called once when
+ * the team is created, so that collectives never race to create it.  Falls
+ * back to the default context when disabled or when the transport is out of
+ * contexts. */
+static void team_coll_ctx_create(shmem_internal_team_t *team)
+{
+    shmem_ctx_t ctx = SHMEM_CTX_DEFAULT;
+
+    if (shmem_internal_params.TEAM_COLLECTIVE_CTX) {
+        SHMEM_MUTEX_LOCK(shmem_internal_mutex_alloc);
+        if (0 != shmem_internal_team_create_ctx(team, SHMEM_CTX_SERIALIZED, &ctx)) {
+            DEBUG_MSG("Could not create a collectives context for team %d\n",
+                      team->psync_idx);
+            ctx = SHMEM_CTX_DEFAULT;
+        }
+        SHMEM_MUTEX_UNLOCK(shmem_internal_mutex_alloc);
+    }
+
+    team->coll_ctx = ctx;
+}
+
 int shmem_internal_team_init(void)
 {
+    if (shmem_internal_params.TEAMS_MAX > N_PSYNC_BYTES * CHAR_BIT) {
+        RETURN_ERROR_MSG("Requested %ld teams, but only %d are supported\n",
+                         shmem_internal_params.TEAMS_MAX, N_PSYNC_BYTES * CHAR_BIT);
+        return -1;
+    }
+
+    if (shmem_internal_params.TEAMS_MAX < SHMEM_TEAMS_MIN)
+        shmem_internal_params.TEAMS_MAX = SHMEM_TEAMS_MIN;
+
+    shmem_internal_pe_maps = calloc(shmem_internal_params.TEAMS_MAX,
+                                    sizeof(shmem_internal_pe_map_t *));
+    if (NULL == shmem_internal_pe_maps) {
+        RETURN_ERROR_STR("Out of memory allocating team translation tables");
+        return -1;
+    }
 
     /* Initialize SHMEM_TEAM_WORLD */
     shmem_internal_team_world.psync_idx      = SHMEM_TEAM_WORLD_INDEX;
@@ -82,9 +195,10 @@ int shmem_internal_team_init(void)
     shmem_internal_team_world.my_pe          = shmem_internal_my_pe;
     shmem_internal_team_world.config_mask    = 0;
     shmem_internal_team_world.contexts_len   = 0;
+    shmem_internal_team_world.coll_ctx       = NULL;
     memset(&shmem_internal_team_world.config, 0, sizeof(shmem_team_config_t));
-    for (size_t i = 0; i < N_PSYNCS_PER_TEAM; i++)
-        shmem_internal_team_world.psync_avail[i] = 1;
+    shmem_internal_team_world.psync_seq      = 0;
+    shmem_internal_team_world.psync_synced   = 0;
     SHMEM_TEAM_WORLD = (shmem_team_t) &shmem_internal_team_world;
 
     /* Initialize SHMEM_TEAM_SHARED */
@@ -92,9 +206,10 @@ int shmem_internal_team_init(void)
     shmem_internal_team_shared.my_pe         = 0;
     shmem_internal_team_shared.config_mask   = 0;
     shmem_internal_team_shared.contexts_len  = 0;
+    shmem_internal_team_shared.coll_ctx      = NULL;
     memset(&shmem_internal_team_shared.config, 0, sizeof(shmem_team_config_t));
-    for (size_t i = 0; i < N_PSYNCS_PER_TEAM; i++)
-        shmem_internal_team_shared.psync_avail[i] = 1;
+    shmem_internal_team_shared.psync_seq     = 0;
+    shmem_internal_team_shared.psync_synced  = 0;
     SHMEM_TEAM_SHARED = (shmem_team_t) &shmem_internal_team_shared;
 
     /* Initialize SHMEM_TEAM_NODE */
@@ -102,38 +217,34 @@ int shmem_internal_team_init(void)
     shmem_internal_team_node.my_pe           = 0;
     shmem_internal_team_node.config_mask     = 0;
     shmem_internal_team_node.contexts_len    = 0;
+    shmem_internal_team_node.coll_ctx        = NULL;
     memset(&shmem_internal_team_node.config, 0, sizeof(shmem_team_config_t));
-    for (size_t i = 0; i < N_PSYNCS_PER_TEAM; i++)
-        shmem_internal_team_node.psync_avail[i] = 1;
+    shmem_internal_team_node.psync_seq       = 0;
+    shmem_internal_team_node.psync_synced    = 0;
     SHMEMX_TEAM_NODE = (shmem_team_t) &shmem_internal_team_node;
 
     if (shmem_internal_params.TEAM_SHARED_ONLY_SELF) {
         shmem_internal_team_shared.start         = shmem_internal_my_pe;
         shmem_internal_team_shared.stride        = 1;
         shmem_internal_team_shared.size          = 1;
-    } else { /* Search for shared-memory peer PEs while checking for a consistent stride */
-        int start = -1, stride = -1, size = 0;
+    } else { /* Search for shared-memory peer PEs */
+        int *pes = malloc(shmem_runtime_get_node_size() * sizeof(int));
+        int size = 0;
+
+        if (NULL == pes) {
+            RETURN_ERROR_STR("Out of memory allocating SHMEM_TEAM_SHARED");
+            goto cleanup;
+        }
 
         for (int pe = 0; pe < shmem_internal_num_pes; pe++) {
-            void *ret_ptr = shmem_internal_ptr(shmem_internal_heap_base, pe);
-            if (ret_ptr == NULL) continue;
-
-            int ret = check_for_linear_stride(pe, &start, &stride, &size);
-            if (ret < 0) {
-                start = shmem_internal_my_pe;
-                stride = 1;
-                size = 1;
-                break;
-            }
+            if (!shmem_internal_ptr_reachable(pe)) continue;
+
+            shmem_internal_assertp(size < shmem_runtime_get_node_size());
+            pes[size++] = pe;
         }
-        shmem_internal_assertp(size > 0 && size <= shmem_runtime_get_node_size());
-
-        shmem_internal_team_shared.start = start;
-        shmem_internal_team_shared.stride = (stride == -1) ? 1 : stride;
-        shmem_internal_team_shared.size = size;
-        shmem_internal_team_shared.my_pe =
-              shmem_internal_team_translate_pe(&shmem_internal_team_world, shmem_internal_my_pe,
-                                               &shmem_internal_team_shared);
+        shmem_internal_assertp(size > 0);
+
+        team_set_pes(&shmem_internal_team_shared, pes, size);
         shmem_internal_assertp(shmem_internal_team_shared.my_pe >= 0);
 
         DEBUG_MSG("SHMEM_TEAM_SHARED: start=%d, stride=%d, size=%d\n",
@@ -141,42 +252,29 @@ int shmem_internal_team_init(void)
                   shmem_internal_team_shared.size);
     }
 
-    /* Search for on-node peer PEs while checking for a consistent stride */
-    int start = -1, stride = -1, size = 0;
+    /* Search for on-node peer PEs */
+    int *node_pes = malloc(shmem_runtime_get_node_size() * sizeof(int));
+    int node_size = 0;
+
+    if (NULL == node_pes) {
+        RETURN_ERROR_STR("Out of memory allocating SHMEMX_TEAM_NODE");
+        goto cleanup;
+    }
+
     for (int pe = 0; pe < shmem_internal_num_pes; pe++) {
-        int ret = shmem_runtime_get_node_rank(pe);
-        if (ret < 0) continue;
-
-        ret = check_for_linear_stride(pe, &start, &stride, &size);
-        if (ret < 0) {
-            start = shmem_internal_my_pe;
-            stride = 1;
-            size = 1;
-            break;
-        }
+        if (shmem_runtime_get_node_rank(pe) < 0) continue;
+
+        shmem_internal_assertp(node_size < shmem_runtime_get_node_size());
+        node_pes[node_size++] = pe;
     }
-    shmem_internal_assert(size > 0 && size == shmem_runtime_get_node_size());
+    shmem_internal_assert(node_size == shmem_runtime_get_node_size());
 
-    shmem_internal_team_node.start = start;
-    shmem_internal_team_node.stride = (stride == -1) ? 1 : stride;
-    shmem_internal_team_node.size = size;
-    shmem_internal_team_node.my_pe =
-          shmem_internal_team_translate_pe(&shmem_internal_team_world, shmem_internal_my_pe,
-                                           &shmem_internal_team_node);
+    team_set_pes(&shmem_internal_team_node, node_pes, node_size);
 
     DEBUG_MSG("SHMEMX_TEAM_NODE: start=%d, stride=%d, size=%d\n",
               shmem_internal_team_node.start, shmem_internal_team_node.stride,
               shmem_internal_team_node.size);
 
-    if (shmem_internal_params.TEAMS_MAX > N_PSYNC_BYTES * CHAR_BIT) {
-        RETURN_ERROR_MSG("Requested %ld teams, but only %d are supported\n",
-                         shmem_internal_params.TEAMS_MAX, N_PSYNC_BYTES * CHAR_BIT);
-        goto cleanup;
-    }
-
-    if (shmem_internal_params.TEAMS_MAX < SHMEM_TEAMS_MIN)
-        shmem_internal_params.TEAMS_MAX = SHMEM_TEAMS_MIN;
-
     shmem_internal_team_pool = malloc(shmem_internal_params.TEAMS_MAX *
                                       sizeof(shmem_internal_team_t*));
 
@@ -187,15 +285,22 @@ int shmem_internal_team_init(void)
     shmem_internal_team_pool[SHMEM_TEAM_SHARED_INDEX] = &shmem_internal_team_shared;
     shmem_internal_team_pool[SHMEM_TEAM_NODE_INDEX] = &shmem_internal_team_node;
 
+    /* The ring depth must be even so that it splits into two halves */
+    psync_depth = shmem_internal_params.TEAM_PSYNC_DEPTH;
+    if (psync_depth < 2) psync_depth = 2;
+    psync_depth += psync_depth % 2;
+
     /* Allocate pSync pool, each with the maximum possible size requirement */
-    /* Create two pSyncs per team for back-to-back collectives and one for barriers.
+    /* Create psync_depth pSyncs per team for back-to-back collectives, one for
+     * barriers, and the epoch and release counters.
      * Array organization:
      *
-     * [ (world) (shared) (node) (team 1) (team 2) ...  (world) (shared) (node) (team 1) (team 2) ... ]
-     *  <----------- groups 1 & 2------------------->|<------------- group 3 ------------------------->
-     *  <--- (bcast, collect, reduce, etc.) -------->|<------ (barriers and syncs) ------------------->
+     * [ (world x depth) (shared x depth) ... (world) (shared) ... (world) (shared) ... ]
+     *  <------------- ring groups ---------->|<-- barriers -->|<---- epoch counters --->
+     *  <--- (bcast, collect, reduce, etc.) ->|<- and syncs -->|<-- (EPOCH_SLOTS each) -->
      * */
-    long psync_len = shmem_internal_params.TEAMS_MAX * (PSYNC_CHUNK_SIZE + SHMEM_SYNC_SIZE);
+    long psync_len = shmem_internal_params.TEAMS_MAX * (PSYNC_CHUNK_SIZE + SHMEM_SYNC_SIZE +
+                                                        EPOCH_SLOTS);
     shmem_internal_psync_pool = shmem_internal_shmalloc(sizeof(long) * psync_len);
     if (NULL == shmem_internal_psync_pool) goto cleanup;
 
@@ -206,13 +311,16 @@ int shmem_internal_team_init(void)
     /* Convenience pointer to the group-3 pSync array (for barriers and syncs): */
     shmem_internal_psync_barrier_pool = &shmem_internal_psync_pool[PSYNC_CHUNK_SIZE *
                                                          shmem_internal_params.TEAMS_MAX];
+    psync_epoch_pool = &shmem_internal_psync_barrier_pool[SHMEM_SYNC_SIZE *
+                                                          shmem_internal_params.TEAMS_MAX];
 
-    psync_pool_avail = shmem_internal_shmalloc(2 * N_PSYNC_BYTES);
+    psync_pool_avail = shmem_internal_shmalloc(3 * N_PSYNC_BYTES);
     if (NULL == psync_pool_avail) goto cleanup;
     psync_pool_avail_reduced = &psync_pool_avail[N_PSYNC_BYTES];
+    psync_pool_avail_contrib = &psync_pool_avail[2 * N_PSYNC_BYTES];
 
     /* Initialize the psync bits to 1, making all slots available: */
-    memset(psync_pool_avail, 0, 2 * N_PSYNC_BYTES);
+    memset(psync_pool_avail, 0, 3 * N_PSYNC_BYTES);
     for (size_t i = 0; i < (size_t) shmem_internal_params.TEAMS_MAX; i++) {
         shmem_internal_bit_set(psync_pool_avail, N_PSYNC_BYTES, i);
     }
@@ -222,10 +330,13 @@ int shmem_internal_team_init(void)
     shmem_internal_bit_clear(psync_pool_avail, N_PSYNC_BYTES, SHMEM_TEAM_SHARED_INDEX);
     shmem_internal_bit_clear(psync_pool_avail, N_PSYNC_BYTES, SHMEM_TEAM_NODE_INDEX);
 
-    /* Initialize an integer used to agree on an equal return value across PEs in team creation: */
-    team_ret_val = shmem_internal_shmalloc(sizeof(int) * 2);
-    if (NULL == team_ret_val) goto cleanup;
-    team_ret_val_reduced = &team_ret_val[1];
+    team_color_key = shmem_internal_shmalloc(sizeof(int) * COLOR_KEY_INTS *
+                                             (shmem_internal_num_pes + 1));
+    if (NULL == team_color_key) goto cleanup;
+
+    team_coll_ctx_create(&shmem_internal_team_world);
+    team_coll_ctx_create(&shmem_internal_team_shared);
+    team_coll_ctx_create(&shmem_internal_team_node);
 
     return 0;
 
@@ -242,10 +353,12 @@ cleanup:
         shmem_internal_free(psync_pool_avail);
         psync_pool_avail = NULL;
     }
-    if (team_ret_val) {
-        shmem_internal_free(team_ret_val);
-        team_ret_val = NULL;
+    for (long i = 0; i < shmem_internal_params.TEAMS_MAX; i++) {
+        if (shmem_internal_pe_maps[i] != NULL)
+            team_map_free(shmem_internal_pe_maps[i]);
     }
+    free(shmem_internal_pe_maps);
+    shmem_internal_pe_maps = NULL;
 
     return -1;
 }
@@ -261,7 +374,8 @@ void shmem_internal_team_fini(void)
     free(shmem_internal_team_pool);
     shmem_internal_free(shmem_internal_psync_pool);
     shmem_internal_free(psync_pool_avail);
-    shmem_internal_free(team_ret_val);
+    shmem_internal_free(team_color_key);
+    free(shmem_internal_pe_maps);
 
     return;
 }
@@ -274,12 +388,12 @@ int shmem_internal_team_translate_pe(shmem_internal_team_t *src_team, int src_pe
     if (src_team == SHMEM_TEAM_INVALID || dest_team == SHMEM_TEAM_INVALID)
         return -1;
 
-    if (src_pe > src_team->size)
+    if (src_pe < 0 || src_pe >= src_team->size)
         return -1;
 
-    src_pe_world = src_team->start + src_pe * src_team->stride;
+    src_pe_world = shmem_internal_team_pe(src_team, src_pe);
 
-    shmem_internal_assert(src_pe_world >= src_team->start && src_pe_world < shmem_internal_num_pes);
+    shmem_internal_assert(src_pe_world >= 0 && src_pe_world < shmem_internal_num_pes);
 
     dest_pe = shmem_internal_pe_in_active_set(src_pe_world, dest_team->start, dest_team->stride,
                                               dest_team->size);
@@ -287,10 +401,132 @@ int shmem_internal_team_translate_pe(shmem_internal_team_t *src_team, int src_pe
     return dest_pe;
 }
 
+/* Resets the epoch and release counters of the pSync slots that are free on
+ * this PE.  The counters of a team live at its members, which hold the
+ * slot.  Resetting before this PE joins in choosing the slot for a new team
+ * guarantees that no member of that team announces or releases an epoch
+ * before the reset. */
+static void team_reset_free_epochs(void)
+{
+    for (long i = 0; i < shmem_internal_params.TEAMS_MAX; i++) {
+        if (shmem_internal_bit_fetch(psync_pool_avail, N_PSYNC_BYTES, i)) {
+            for (int j = 0; j < EPOCH_SLOTS; j++)
+                psync_epoch_pool[i * EPOCH_SLOTS + j] = 0;
+        }
+    }
+}
+
+/* Computes, in a single reduction over the parent team, the pSync slots free
+ * on every parent PE that joins a new team.  PEs that do not join contribute
+ * an all-ones mask.  Every PE of the parent team receives the same mask in
+ * avail, so all of them take the same decisions from it without further
+ * agreement. */
+static void team_reduce_psync_avail(shmem_internal_team_t *parent_team, int joining,
+                                    unsigned char *avail)
+{
+    char bit_str[SHMEM_INTERNAL_DIAG_STRLEN];
+    long *psync;
+
+    team_reset_free_epochs();
+
+    if (joining)
+        memcpy(psync_pool_avail_contrib, psync_pool_avail, N_PSYNC_BYTES);
+    else
+        memset(psync_pool_avail_contrib, 0xff, N_PSYNC_BYTES);
+
+    shmem_internal_bit_to_string(bit_str, SHMEM_INTERNAL_DIAG_STRLEN,
+                                 psync_pool_avail_contrib, N_PSYNC_BYTES);
+    DEBUG_MSG("My pSyncs  [ %s ]\n", bit_str);
+
+    psync = shmem_internal_team_choose_psync(parent_team, REDUCE);
+
+    shmem_internal_op_to_all(shmem_internal_team_ctx(parent_team),
+                             psync_pool_avail_reduced,
+                             psync_pool_avail_contrib, N_PSYNC_BYTES, 1,
+                             parent_team->start, parent_team->stride, parent_team->size, NULL,
+                             psync, SHM_INTERNAL_BAND, SHM_INTERNAL_UCHAR);
+
+    shmem_internal_team_release_psyncs(parent_team, REDUCE);
+
+    memcpy(avail, psync_pool_avail_reduced, N_PSYNC_BYTES);
+
+    shmem_internal_bit_to_string(bit_str, SHMEM_INTERNAL_DIAG_STRLEN,
+                                 avail, N_PSYNC_BYTES);
+    DEBUG_MSG("All pSyncs [ %s ]\n", bit_str);
+}
+
+/* Takes the least significant available slot from a mask of free pSync
+ * slots.  Returns -1 if none is left. */
+static int team_take_psync(unsigned char *avail)
+{
+    int idx = shmem_internal_bit_1st_nonzero(avail, N_PSYNC_BYTES);
+
+    if (idx == -1 || idx >= shmem_internal_params.TEAMS_MAX) {
+        RAISE_WARN_MSG("No more teams available (max = %ld), try increasing SHMEM_TEAMS_MAX\n",
+                        shmem_internal_params.TEAMS_MAX);
+        return -1;
+    }
+
+    shmem_internal_bit_clear(avail, N_PSYNC_BYTES, idx);
+
+    return idx;
+}
+
+static shmem_internal_team_t *team_alloc(const shmem_team_config_t *config, long config_mask,
+                                         int psync_idx)
+{
+    shmem_internal_team_t *myteam = calloc(1, sizeof(shmem_internal_team_t));
+
+    if (NULL == myteam)
+        RAISE_ERROR_STR("Out of memory allocating team");
+
+    if (config) {
+        myteam->config      = *config;
+        myteam->config_mask = config_mask;
+    }
+    myteam->contexts_len = 0;
+    myteam->coll_ctx     = NULL;
+    myteam->psync_seq    = 0;
+    myteam->psync_synced = 0;
+
+    /* Set the selected psync bit to 0, reserving that slot */
+    myteam->psync_idx = psync_idx;
+    shmem_internal_bit_clear(psync_pool_avail, N_PSYNC_BYTES, psync_idx);
+    shmem_internal_team_pool[psync_idx] = myteam;
+
+    return myteam;
+}
+
+/* Sets the members of a team to the parent team ranks
+ * (rank_start, rank_stride, size) */
+static void team_set_parent_ranks(shmem_internal_team_t *team, shmem_internal_team_t *parent_team,
+                                  int rank_start, int rank_stride, int size)
+{
+    if (SHMEM_INTERNAL_STRIDE_IS_MAPPED(parent_team->stride)) {
+        int *pes = malloc(size * sizeof(int));
+
+        if (NULL == pes)
+            RAISE_ERROR_STR("Out of memory allocating team translation table");
+
+        for (int i = 0; i < size; i++)
+            pes[i] = shmem_internal_team_pe(parent_team, rank_start + i * rank_stride);
+
+        team_set_pes(team, pes, size);
+    } else {
+        team->start  = shmem_internal_team_pe(parent_team, rank_start);
+        team->stride = parent_team->stride * rank_stride;
+        team->size   = size;
+        team->my_pe  = shmem_internal_pe_in_active_set(shmem_internal_my_pe, team->start,
+                                                       team->stride, team->size);
+    }
+}
+
 int shmem_internal_team_split_strided(shmem_internal_team_t *parent_team, int PE_start, int PE_stride,
                                       int PE_size, const shmem_team_config_t *config, long config_mask,
                                       shmem_internal_team_t **new_team)
 {
+    unsigned char avail[N_PSYNC_BYTES];
+    int my_pe, psync_idx;
 
     *new_team = SHMEM_TEAM_INVALID;
 
@@ -298,9 +534,6 @@ int shmem_internal_team_split_strided(shmem_internal_team_t *parent_team, int PE
         return 1;
     }
 
-    int global_PE_start = shmem_internal_team_pe(parent_team, PE_start);
-    int global_PE_end   = global_PE_start + PE_stride * (PE_size -1);
-
     if (PE_start < 0 || PE_start >= parent_team->size ||
         PE_size <= 0 || PE_size > parent_team->size   ||
         PE_stride == 0) {
@@ -310,102 +543,165 @@ int shmem_internal_team_split_strided(shmem_internal_team_t *parent_team, int PE
         return -1;
     }
 
-    if (global_PE_start >= shmem_internal_num_pes ||
-        global_PE_end >= shmem_internal_num_pes) {
-        RAISE_WARN_MSG("Starting PE (%d) or ending PE (%d) is invalid\n",
-                       global_PE_start, global_PE_end);
-        return -1;
-    }
-
-    int my_pe = shmem_internal_pe_in_active_set(shmem_internal_my_pe,
-                                                global_PE_start, PE_stride, PE_size);
+    /* PE_start and PE_stride are in parent team ranks.  The members of a
+     * parent with a translation table are not evenly spaced in the world
+     * team, so the child gets its own table. */
+    const int mapped_parent = SHMEM_INTERNAL_STRIDE_IS_MAPPED(parent_team->stride);
+    int global_PE_start = shmem_internal_team_pe(parent_team, PE_start);
 
-    long *psync = shmem_internal_team_choose_psync(parent_team, REDUCE);
-    shmem_internal_team_t *myteam = NULL;
-    *team_ret_val = 0;
-    *team_ret_val_reduced = 0;
+    if (mapped_parent) {
+        int PE_end = PE_start + PE_stride * (PE_size - 1);
 
-    if (my_pe != -1) {
-        char bit_str[SHMEM_INTERNAL_DIAG_STRLEN];
+        if (PE_end < 0 || PE_end >= parent_team->size) {
+            RAISE_WARN_MSG("Ending PE (%d) is invalid in a parent team of %d PEs\n",
+                           PE_end, parent_team->size);
+            return -1;
+        }
 
-        myteam = calloc(1, sizeof(shmem_internal_team_t));
+        my_pe = shmem_internal_pe_in_active_set(parent_team->my_pe, PE_start, PE_stride, PE_size);
+    } else {
+        int global_PE_end = global_PE_start + parent_team->stride * PE_stride * (PE_size -1);
 
-        myteam->my_pe       = my_pe;
-        myteam->start       = global_PE_start;
-        myteam->stride      = PE_stride;
-        myteam->size        = PE_size;
-        if (config) {
-            myteam->config      = *config;
-            myteam->config_mask = config_mask;
+        if (global_PE_start >= shmem_internal_num_pes ||
+            global_PE_end < 0 || global_PE_end >= shmem_internal_num_pes) {
+            RAISE_WARN_MSG("Starting PE (%d) or ending PE (%d) is invalid\n",
+                           global_PE_start, global_PE_end);
+            return -1;
         }
-        myteam->contexts_len = 0;
-        myteam->psync_idx = -1;
 
-        shmem_internal_op_to_all(psync_pool_avail_reduced,
-                                 psync_pool_avail, N_PSYNC_BYTES, 1,
-                                 myteam->start, PE_stride, PE_size, NULL,
-                                 psync, SHM_INTERNAL_BAND, SHM_INTERNAL_UCHAR);
+        my_pe = shmem_internal_pe_in_active_set(shmem_internal_my_pe, global_PE_start,
+                                                parent_team->stride * PE_stride, PE_size);
+    }
+
+    team_reduce_psync_avail(parent_team, my_pe >= 0, avail);
 
-        /* We cannot release the psync here, because this reduction may not
-         * have been performed on the entire parent team. */
+    psync_idx = team_take_psync(avail);
 
-        shmem_internal_bit_to_string(bit_str, SHMEM_INTERNAL_DIAG_STRLEN,
-                                     psync_pool_avail_reduced, N_PSYNC_BYTES);
-        DEBUG_MSG("My pSyncs  [ %s ]\n", bit_str);
+    /* If no team was available, print some team triplet info and return nonzero. */
+    if (psync_idx == -1) {
+        if (my_pe >= 0)
+            RAISE_WARN_MSG("Team split strided failed: child <%d, %d, %d>, parent <%d, %d, %d>\n",
+                           global_PE_start, PE_stride, PE_size,
+                           parent_team->start, parent_team->stride, parent_team->size);
+        return 1;
+    }
 
-        /* Select the least signficant nonzero bit, which corresponds to an available pSync. */
-        myteam->psync_idx = shmem_internal_bit_1st_nonzero(psync_pool_avail_reduced, N_PSYNC_BYTES);
+    DEBUG_MSG("Allocated pSync %d\n", psync_idx);
 
-        shmem_internal_bit_to_string(bit_str, SHMEM_INTERNAL_DIAG_STRLEN,
-                                     psync_pool_avail_reduced, N_PSYNC_BYTES);
-        DEBUG_MSG("All pSyncs [ %s ], allocated %d\n", bit_str,
-                  myteam->psync_idx);
+    if (my_pe >= 0) {
+        shmem_internal_team_t *myteam = team_alloc(config, config_mask, psync_idx);
 
-        if (myteam->psync_idx == -1 || myteam->psync_idx >= shmem_internal_params.TEAMS_MAX) {
-            RAISE_WARN_MSG("No more teams available (max = %ld), try increasing SHMEM_TEAMS_MAX\n",
-                            shmem_internal_params.TEAMS_MAX);
-            /* No psync was available, but must call barrier across parent team before returning. */
-            myteam->psync_idx = -1;
-            *team_ret_val = 1;
-        } else {
-            /* Set the selected psync bit to 0, reserving that slot */
-            shmem_internal_bit_clear(psync_pool_avail, N_PSYNC_BYTES, myteam->psync_idx);
+        team_set_parent_ranks(myteam, parent_team, PE_start, PE_stride, PE_size);
+        team_coll_ctx_create(myteam);
 
-            for (size_t i = 0; i < N_PSYNCS_PER_TEAM; i++)
-                myteam->psync_avail[i] = 1;
+        *new_team = myteam;
+    }
 
-            *new_team = myteam;
+    return 0;
+}
 
-            shmem_internal_team_pool[myteam->psync_idx] = *new_team;
-        }
+int shmem_internal_team_split_color(shmem_internal_team_t *parent_team, int color, int key,
+                                    const shmem_team_config_t *config, long config_mask,
+                                    shmem_internal_team_t **new_team)
+{
+    *new_team = SHMEM_TEAM_INVALID;
+
+    if (parent_team == SHMEM_TEAM_INVALID) {
+        return 1;
     }
 
-    shmem_internal_team_release_psyncs(parent_team, REDUCE);
+    const int parent_size = parent_team->size;
+    unsigned char avail[N_PSYNC_BYTES];
+    int *color_keys;
+    int psync_idx;
+    long *psync;
+
+    team_reset_free_epochs();
+
+    /* Every member of the parent team learns the color, key, and free pSync
+     * slots of the others.  The new teams are disjoint, so they all share
+     * the first slot free on every PE that joins one, which each PE then
+     * finds without another collective. */
+    team_color_key[0] = color;
+    team_color_key[1] = key;
+    if (color >= 0)
+        memcpy(&team_color_key[2], psync_pool_avail, N_PSYNC_BYTES);
+    else
+        memset(&team_color_key[2], 0xff, N_PSYNC_BYTES);
+
+    psync = shmem_internal_team_choose_psync(parent_team, COLLECT);
+    shmem_internal_fcollect(shmem_internal_team_ctx(parent_team),
+                            &team_color_key[COLOR_KEY_INTS], team_color_key,
+                            COLOR_KEY_INTS * sizeof(int), parent_team->start,
+                            parent_team->stride, parent_size, psync);
+    shmem_internal_team_release_psyncs(parent_team, COLLECT);
+
+    /* The exchange area is shared by all splits, and the next one may write
+     * to it as soon as its members are done here.  Copy the entries out and
+     * let nobody proceed before every member has done so. */
+    color_keys = malloc(COLOR_KEY_INTS * parent_size * sizeof(int));
+    if (NULL == color_keys)
+        RAISE_ERROR_STR("Out of memory allocating team split buffer");
+    memcpy(color_keys, &team_color_key[COLOR_KEY_INTS],
+           COLOR_KEY_INTS * parent_size * sizeof(int));
 
-    /* This barrier on the parent team eliminates problematic race conditions
-     * during psync allocation between back-to-back team creations. */
     psync = shmem_internal_team_choose_psync(parent_team, SYNC);
+    shmem_internal_sync(shmem_internal_team_ctx(parent_team), parent_team->start,
+                        parent_team->stride, parent_size, psync);
+    shmem_internal_team_release_psyncs(parent_team, SYNC);
 
-    shmem_internal_barrier(parent_team->start, parent_team->stride, parent_team->size, psync);
+    memset(avail, 0xff, N_PSYNC_BYTES);
+    for (int i = 0; i < parent_size; i++) {
+        const unsigned char *mask = (const unsigned char *) &color_keys[COLOR_KEY_INTS * i + 2];
 
-    shmem_internal_team_release_psyncs(parent_team, SYNC);
+        for (int j = 0; j < N_PSYNC_BYTES; j++)
+            avail[j] &= mask[j];
+    }
 
-    /* This OR reduction assures all PEs return the same value.  */
-    psync = shmem_internal_team_choose_psync(parent_team, REDUCE);
+    psync_idx = team_take_psync(avail);
 
-    shmem_internal_op_to_all(team_ret_val_reduced, team_ret_val, 1, sizeof(int),
-                             parent_team->start, parent_team->stride, parent_team->size, NULL,
-                             psync, SHM_INTERNAL_MAX, SHM_INTERNAL_INT);
+    if (psync_idx == -1) {
+        if (color >= 0)
+            RAISE_WARN_MSG("Team split color failed: color %d, parent <%d, %d, %d>\n",
+                           color, parent_team->start, parent_team->stride, parent_team->size);
+        free(color_keys);
+        return 1;
+    }
 
-    shmem_internal_team_release_psyncs(parent_team, REDUCE);
+    if (color >= 0) {
+        int *members = malloc(2 * parent_size * sizeof(int));
+        int *pes = malloc(parent_size * sizeof(int));
+        int size = 0;
 
-    /* If no team was available, print some team triplet info and return nonzero. */
-    if (my_pe >= 0 && myteam != NULL && myteam->psync_idx == -1) {
-        RAISE_WARN_MSG("Team split strided failed: child <%d, %d, %d>, parent <%d, %d, %d>\n",
-                        global_PE_start, PE_stride, PE_size,
-                        parent_team->start, parent_team->stride, parent_team->size);
+        if (NULL == members || NULL == pes)
+            RAISE_ERROR_STR("Out of memory allocating team translation table");
+
+        /* Order the members by key, breaking ties by parent team rank */
+        for (int i = 0; i < parent_size; i++) {
+            if (color_keys[COLOR_KEY_INTS * i] != color) continue;
+            members[2 * size]     = color_keys[COLOR_KEY_INTS * i + 1];
+            members[2 * size + 1] = i;
+            size++;
+        }
+        qsort(members, size, 2 * sizeof(int), compare_int_pairs);
+
+        for (int i = 0; i < size; i++)
+            pes[i] = shmem_internal_team_pe(parent_team, members[2 * i + 1]);
+        free(members);
+
+        shmem_internal_team_t *myteam = team_alloc(config, config_mask, psync_idx);
+
+        team_set_pes(myteam, pes, size);
+        team_coll_ctx_create(myteam);
+        DEBUG_MSG("Color %d: %d PEs, start=%d, stride=%d\n", color,
+                  myteam->size, myteam->start, myteam->stride);
+
+        *new_team = myteam;
     }
-    return *team_ret_val_reduced;
+
+    free(color_keys);
+
+    return 0;
 }
 
 int shmem_internal_team_split_2d(shmem_internal_team_t *parent_team, int xrange,
@@ -413,6 +709,8 @@ int shmem_internal_team_split_2d(shmem_internal_team_t *parent_team, int xrange,
                                  shmem_internal_team_t **xaxis_team, const shmem_team_config_t *yaxis_config,
                                  long yaxis_mask, shmem_internal_team_t **yaxis_team)
 {
+    unsigned char avail[N_PSYNC_BYTES];
+
     *xaxis_team = SHMEM_TEAM_INVALID;
     *yaxis_team = SHMEM_TEAM_INVALID;
 
@@ -420,68 +718,49 @@ int shmem_internal_team_split_2d(shmem_internal_team_t *parent_team, int xrange,
         return 1;
     }
 
+    if (xrange <= 0) {
+        RAISE_WARN_MSG("Invalid xrange (%d) in team split 2d\n", xrange);
+        return -1;
+    }
+
     if (xrange > parent_team->size) {
         xrange = parent_team->size;
     }
 
-    const int parent_start = parent_team->start;
-    const int parent_stride = parent_team->stride;
     const int parent_size = parent_team->size;
-    const int num_xteams = ceil( parent_size / (float)xrange );
-    const int num_yteams = xrange;
+    const int my_x = parent_team->my_pe / xrange;
+    const int my_y = parent_team->my_pe % xrange;
+    const int xsize = (parent_size - my_x * xrange < xrange) ? parent_size - my_x * xrange : xrange;
+    const int ysize = (parent_size - my_y + xrange - 1) / xrange;
 
-    int start = 0;
-    int ret = 0;
-
-    for (int i = 0; i < num_xteams; i++) {
-        shmem_internal_team_t *my_xteam;
-        int xsize = (i == num_xteams - 1 && parent_size % xrange) ? parent_size % xrange : xrange;
-
-        ret = shmem_internal_team_split_strided(parent_team, start, parent_stride,
-                                                xsize, xaxis_config, xaxis_mask, &my_xteam);
-        if (ret) {
-            RAISE_ERROR_MSG("Creation of x-axis team %d of %d failed\n", i+1, num_xteams);
-        }
-        start += xrange;
+    /* Each PE joins exactly one x-axis team and one y-axis team.  The teams
+     * along each axis are disjoint, so they share one pSync slot, and both
+     * slots come out of a single reduction over the parent team. */
+    team_reduce_psync_avail(parent_team, 1, avail);
 
-        if (my_xteam != SHMEM_TEAM_INVALID) {
-            shmem_internal_assert(*xaxis_team == SHMEM_TEAM_INVALID);
-            *xaxis_team = my_xteam;
-        }
-    }
-
-    start = 0;
-
-    for (int i = 0; i < num_yteams; i++) {
-        shmem_internal_team_t *my_yteam;
-        int remainder = parent_size % xrange;
-        int yrange = parent_size / xrange;
-        int ysize = (remainder && i < remainder) ? yrange + 1 : yrange;
-
-        ret = shmem_internal_team_split_strided(parent_team, start, xrange*parent_stride,
-                                        ysize, yaxis_config, yaxis_mask, &my_yteam);
-        if (ret) {
-            RAISE_ERROR_MSG("Creation of y-axis team %d of %d failed\n", i+1, num_yteams);
-        }
-        start += 1;
+    const int xidx = team_take_psync(avail);
+    const int yidx = (xidx == -1) ? -1 : team_take_psync(avail);
 
-        if (my_yteam != SHMEM_TEAM_INVALID) {
-            shmem_internal_assert(*yaxis_team == SHMEM_TEAM_INVALID);
-            *yaxis_team = my_yteam;
-        }
+    if (xidx == -1 || yidx == -1) {
+        RAISE_WARN_MSG("Team split 2d failed: xrange %d, parent <%d, %d, %d>\n", xrange,
+                       parent_team->start, parent_team->stride, parent_team->size);
+        return 1;
     }
 
-    long *psync = shmem_internal_team_choose_psync(parent_team, SYNC);
+    *xaxis_team = team_alloc(xaxis_config, xaxis_mask, xidx);
+    team_set_parent_ranks(*xaxis_team, parent_team, my_x * xrange, 1, xsize);
+    team_coll_ctx_create(*xaxis_team);
 
-    shmem_internal_barrier(parent_start, parent_stride, parent_size, psync);
-
-    shmem_internal_team_release_psyncs(parent_team, SYNC);
+    *yaxis_team = team_alloc(yaxis_config, yaxis_mask, yidx);
+    team_set_parent_ranks(*yaxis_team, parent_team, my_y, xrange, ysize);
+    team_coll_ctx_create(*yaxis_team);
 
     return 0;
 }
 
 int shmem_internal_team_destroy(shmem_internal_team_t *team)
 {
+    shmem_internal_coll_req_drain();
 
     if (team == SHMEM_TEAM_INVALID) {
         return -1;
@@ -491,11 +770,20 @@ int shmem_internal_team_destroy(shmem_internal_team_t *team)
         shmem_internal_bit_set(psync_pool_avail, N_PSYNC_BYTES, team->psync_idx);
     }
 
+    /* Destroy the collectives context first; transports that track it in
+     * the contexts array clear its slot when it is destroyed */
+    if (team->coll_ctx != NULL && team->coll_ctx != SHMEM_CTX_DEFAULT) {
+        shmem_transport_quiet((shmem_transport_ctx_t *) team->coll_ctx);
+        shmem_transport_ctx_destroy((shmem_transport_ctx_t *) team->coll_ctx);
+    }
+    team->coll_ctx = NULL;
+
     /* Destroy all undestroyed shareable contexts on this team */
     for (size_t i = 0; i < team->contexts_len; i++) {
         if (team->contexts[i] != NULL) {
             if (team->contexts[i]->options & SHMEM_CTX_PRIVATE)
                 RAISE_WARN_MSG("Destroying team with unfreed private context (%zu)\n", i);
+            shmem_internal_agg_ctx_destroy((shmem_ctx_t) team->contexts[i]);
             shmem_transport_quiet(team->contexts[i]);
             shmem_transport_ctx_destroy(team->contexts[i]);
         }
@@ -503,6 +791,11 @@ int shmem_internal_team_destroy(shmem_internal_team_t *team)
     shmem_internal_team_pool[team->psync_idx] = NULL;
     free(team->contexts);
 
+    if (SHMEM_INTERNAL_STRIDE_IS_MAPPED(team->stride)) {
+        team_map_free(shmem_internal_pe_maps[team->psync_idx]);
+        shmem_internal_pe_maps[team->psync_idx] = NULL;
+    }
+
     if (team != &shmem_internal_team_world && team != &shmem_internal_team_shared &&
         team != &shmem_internal_team_node) {
         free(team);
@@ -511,47 +804,113 @@ int shmem_internal_team_destroy(shmem_internal_team_t *team)
     return 0;
 }
 
+int shmem_internal_team_create_ctx(shmem_internal_team_t *team, long options, shmem_ctx_t *ctx)
+{
+    int ret = shmem_transport_ctx_create(team, options, (shmem_transport_ctx_t **) ctx);
+
+    if (0 == ret && (options & SHMEMX_CTX_AGGREGATE)) {
+        ret = shmem_internal_agg_ctx_create(*ctx);
+        if (0 != ret)
+            shmem_transport_ctx_destroy((shmem_transport_ctx_t *) *ctx);
+    }
+
+    if (0 != ret)
+        *ctx = SHMEM_CTX_INVALID;
+
+    return ret;
+}
+
+/* Announces that this PE has finished the collectives of the given epoch.
+ * The member whose announcement completes the epoch releases it on every
+ * member. */
+static void team_announce_epoch(shmem_ctx_t ctx, void *arg, long epoch)
+{
+    shmem_internal_team_t *team = (shmem_internal_team_t *) arg;
+    long *counters = &psync_epoch_pool[team->psync_idx * EPOCH_SLOTS];
+    /* Epochs up to this one that share its counter, the first epoch is 1 */
+    long nepochs = (epoch + EPOCH_COUNTERS - 1) / EPOCH_COUNTERS;
+    long one = 1, count;
+
+    shmem_internal_fetch_atomic(ctx, &counters[epoch % EPOCH_COUNTERS], &one, &count,
+                                sizeof(long), team->start, SHM_INTERNAL_SUM,
+                                SHM_INTERNAL_LONG);
+    shmem_internal_get_wait(ctx);
+
+    if (count + 1 == nepochs * team->size) {
+        for (int i = 0; i < team->size; i++)
+            shmem_internal_atomic(ctx, &counters[EPOCH_COUNTERS], &one, sizeof(long),
+                                  shmem_internal_team_pe(team, i), SHM_INTERNAL_SUM,
+                                  SHM_INTERNAL_LONG);
+    }
+}
+
+/* Wait until the given epoch has been released on this PE.  Epochs are
+ * released out of order, but releasing any epoch means every member has
+ * announced all the earlier ones, so a count of at least epoch releases
+ * suffices. */
+static void team_wait_epoch(shmem_internal_team_t *team, long epoch)
+{
+    long *released = &psync_epoch_pool[team->psync_idx * EPOCH_SLOTS + EPOCH_COUNTERS];
+
+    SHMEM_WAIT_UNTIL(released, SHMEM_CMP_GE, epoch);
+}
+
+/* Returns the next pSync in the team's ring */
+static long *team_ring_psync(shmem_internal_team_t *team)
+{
+    long half = psync_depth / 2;
+    long seq = team->psync_seq++;
+
+    if (seq > 0 && seq % half == 0 && team->size > 1) {
+        long epoch = seq / half;
+
+        /* Announce that all collectives before seq are done.  When
+         * non-blocking ones are outstanding, the announcement is queued
+         * behind them rather than waiting here.  All collectives on this
+         * team run on the team's context. */
+        shmem_internal_coll_req_notify(shmem_internal_team_ctx(team),
+                                       team_announce_epoch, team, epoch);
+
+        /* The half we are entering was last used by the collectives of
+         * epoch - 2, which everyone has finished once they have announced
+         * epoch - 1.  Outstanding requests are progressed while waiting. */
+        if (epoch >= 2 && (epoch - 1) * half > team->psync_synced)
+            team_wait_epoch(team, epoch - 1);
+    }
+
+    return &shmem_internal_psync_pool[(team->psync_idx * psync_depth +
+                                       seq % psync_depth) * SHMEM_SYNC_SIZE];
+}
+
 /* Returns a psync from the given team that can be safely used for the
- * specified collective operation. */
+ * specified collective operation.  Blocking collectives first complete the
+ * outstanding non-blocking collectives of this PE. */
 long * shmem_internal_team_choose_psync(shmem_internal_team_t *team, shmem_internal_team_op_t op)
 {
+    shmem_internal_coll_req_drain();
 
     switch (op) {
         case SYNC:
             return &shmem_internal_psync_barrier_pool[team->psync_idx * SHMEM_SYNC_SIZE];
 
         default:
-            for (int i = 0; i < N_PSYNCS_PER_TEAM; i++) {
-                if (team->psync_avail[i]) {
-                    team->psync_avail[i] = 0;
-                    return &shmem_internal_psync_pool[(team->psync_idx + i) * PSYNC_CHUNK_SIZE];
-                }
-            }
-
-            /* No psync is available, so we must quiesce communication across all psyncs on this team. */
-            /* Currently, all collectives on all teams are done on the default context. */
-            shmem_internal_quiet(SHMEM_CTX_DEFAULT);
-
-            size_t psync = team->psync_idx * SHMEM_SYNC_SIZE;
-            shmem_internal_sync(team->start, team->stride, team->size,
-                                &shmem_internal_psync_barrier_pool[psync]);
-
-            for (int i = 0; i < N_PSYNCS_PER_TEAM; i++) {
-                team->psync_avail[i] = 1;
-            }
-            team->psync_avail[0] = 0;
-
-            return &shmem_internal_psync_pool[psync];
+            return team_ring_psync(team);
     }
 }
 
+/* Returns a psync from the given team for a non-blocking collective.  The
+ * pSync is not reused before every PE has completed the collective. */
+long * shmem_internal_team_choose_psync_nb(shmem_internal_team_t *team)
+{
+    return team_ring_psync(team);
+}
+
 void shmem_internal_team_release_psyncs(shmem_internal_team_t *team, shmem_internal_team_op_t op)
 {
     switch (op) {
         case SYNC:
-            for (size_t i = 0; i < N_PSYNCS_PER_TEAM; i++) {
-                team->psync_avail[i] = 1;
-            }
+            /* A barrier completes every earlier collective on all PEs */
+            team->psync_synced = team->psync_seq;
             break;
         default:
             break;
@@ -15,17 +15,17 @@
 #include "transport.h"
 #include "uthash.h"
 
-#define N_PSYNCS_PER_TEAM   2
-
 struct shmem_internal_team_t {
     int                            my_pe;
     int                            start, stride, size;
     int                            psync_idx;
-    int                            psync_avail[N_PSYNCS_PER_TEAM];
+    long                           psync_seq;    /* collectives started */
+    long                           psync_synced; /* collectives known complete on all PEs */
     shmem_team_config_t            config;
     long                           config_mask;
     size_t                         contexts_len;
     struct shmem_transport_ctx_t **contexts;
+    shmem_ctx_t                    coll_ctx;     /* context for collectives, set at creation */
 };
 typedef struct shmem_internal_team_t shmem_internal_team_t;
 
@@ -60,6 +60,10 @@ int shmem_internal_team_split_strided(shmem_internal_team_t *parent_team, int PE
                                       int PE_size, const shmem_team_config_t *config, long config_mask,
                                       shmem_internal_team_t **new_team);
 
+int shmem_internal_team_split_color(shmem_internal_team_t *parent_team, int color, int key,
+                                    const shmem_team_config_t *config, long config_mask,
+                                    shmem_internal_team_t **new_team);
+
 int shmem_internal_team_split_2d(shmem_internal_team_t *parent_team, int xrange,
                                  const shmem_team_config_t *xaxis_config, long xaxis_mask, shmem_internal_team_t **xaxis_team,
                                  const shmem_team_config_t *yaxis_config, long yaxis_mask, shmem_internal_team_t **yaxis_team);
@@ -72,12 +76,24 @@ int shmem_internal_ctx_get_team(shmem_ctx_t ctx, shmem_internal_team_t **team);
 
 long * shmem_internal_team_choose_psync(shmem_internal_team_t *team, shmem_internal_team_op_t op);
 
+long * shmem_internal_team_choose_psync_nb(shmem_internal_team_t *team);
+
 void shmem_internal_team_release_psyncs(shmem_internal_team_t *team, shmem_internal_team_op_t op);
 
 static inline
 int shmem_internal_team_pe(shmem_internal_team_t *team, int pe)
 {
-    return team->start + team->stride * pe;
+    return shmem_internal_as_pe(team->start, team->stride, pe);
+}
+
+/* Returns the context on which collectives over the given team are run */
+static inline
+shmem_ctx_t shmem_internal_team_ctx(shmem_internal_team_t *team)
+{
+    if (NULL == team->coll_ctx)
+        return SHMEM_CTX_DEFAULT;
+
+    return team->coll_ctx;
 }
 
 #endif
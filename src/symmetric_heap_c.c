@@ -33,6 +33,7 @@
 #include "shmem_internal.h"
 #include "shmem_comm.h"
 #include "shmem_collectives.h"
+#include "shmem_team.h"
 #include "shmemx.h"
 
 #ifdef ENABLE_PROFILING
@@ -71,15 +72,66 @@
 #pragma weak shmemx_heap_create = pshmemx_heap_create
 #define shmemx_heap_create pshmemx_heap_create
 
+#pragma weak shmemx_team_realloc = pshmemx_team_realloc
+#define shmemx_team_realloc pshmemx_team_realloc
+
 #endif /* ENABLE_PROFILING */
 
 static char *shmem_internal_heap_curr = NULL;
 
+/* When SHMEM_SYMMETRIC_HEAP_MAX_SIZE is set, the heap is a reserved
+ * (PROT_NONE) virtual address range of that size, and only the first
+ * shmem_internal_heap_committed bytes are accessible.  Pages are committed
+ * as dlmalloc's morecore moves the break.  Allocations are made in the same
+ * order on every PE, so the heap grows symmetrically.  Growth relies on the
+ * transports covering the whole reserved range without pinning it, which is
+ * the case for CMA, XPMEM, and OFI with scalable memory registration. */
+#if (defined(USE_OFI) && !(defined(ENABLE_MR_SCALABLE) && defined(ENABLE_REMOTE_VIRTUAL_ADDRESSING))) || \
+    defined(USE_PORTALS4) || defined(USE_UCX)
+#define SYMMETRIC_HEAP_GROWTH_SUPPORTED 0
+#else
+#define SYMMETRIC_HEAP_GROWTH_SUPPORTED 1
+#endif
+
+#define HEAP_COMMIT_CHUNK (2*1024*1024)
+
+/* Allocations hinted with SHMEM_MALLOC_ATOMICS_REMOTE or
+ * SHMEM_MALLOC_SIGNAL_REMOTE are padded to whole cache lines, and come from
+ * a dedicated mspace at the start of the heap when one is configured.  The
+ * sub-heap is carved out in shmem_internal_symmetric_init(), before dlmalloc
+ * first calls morecore, so it has the same address on every PE. */
+#define ATOMICS_HEAP_ALIGN 64
+
+/* Size to request so that an aligned block plus the next chunk's header
+ * ends on a cache line boundary, leaving no other object in its lines */
+#define ATOMICS_HEAP_REQ_SIZE(size) \
+    (CEILING((size) + 2 * sizeof(size_t), ATOMICS_HEAP_ALIGN) - 2 * sizeof(size_t))
+
+static size_t shmem_internal_heap_committed = 0;
+static size_t shmem_internal_heap_commit_chunk = 0;
+
 void* dlmalloc(size_t);
 void* dlcalloc(size_t, size_t);
 void  dlfree(void*);
 void* dlrealloc(void*, size_t);
 void* dlmemalign(size_t, size_t);
+void* dlrealloc_in_place(void*, size_t);
+size_t dlmalloc_usable_size(void*);
+void dlmalloc_set_flag4(void*);
+void dlmalloc_clear_flag4(void*);
+int dlmalloc_flag4(void*);
+
+typedef void* mspace;
+mspace create_mspace_with_base(void*, size_t, int);
+size_t mspace_set_footprint_limit(mspace, size_t);
+void* mspace_memalign(mspace, size_t, size_t);
+void* mspace_realloc(mspace, void*, size_t);
+void  mspace_free(mspace, void*);
+
+static mspace shmem_internal_atomics_mspace = NULL;
+
+/* Symmetric flag reduced by the in-place realloc path */
+static int *realloc_in_place_flags = NULL;
 
 
 /*
@@ -128,6 +180,13 @@ static int find_hugepage_dir(size_t page_size, char **directory)
 }
 #endif /* __linux__ */
 
+#ifndef FLOOR
+#define FLOOR(a,b)      ((uint64_t)(a) - ( ((uint64_t)(a)) % (uint64_t)(b)))
+#endif
+#ifndef CEILING
+#define CEILING(a,b)    ((uint64_t)(a) <= 0LL ? 0 : (FLOOR((a)-1,b) + (b)))
+#endif
+
 /* shmalloc and friends are defined to not be thread safe, so this is
    fine.  If they change that definition, this is no longer fine and
    needs to be made thread safe. */
@@ -143,80 +202,322 @@ shmem_internal_get_next(intptr_t incr)
     } else if (shmem_internal_heap_curr - (char*) shmem_internal_heap_base >
                shmem_internal_heap_length) {
         RAISE_WARN_MSG("Out of symmetric memory, heap size %ld, overrun %"PRIdPTR"\n"
-                       RAISE_PE_PREFIX "Try increasing SHMEM_SYMMETRIC_SIZE\n",
+                       RAISE_PE_PREFIX "Try increasing SHMEM_SYMMETRIC_SIZE or SHMEM_SYMMETRIC_HEAP_MAX_SIZE\n",
                        shmem_internal_heap_length, incr, shmem_internal_my_pe);
         shmem_internal_heap_curr = orig;
         orig = (void*) -1;
+    } else if (shmem_internal_heap_committed > 0 &&
+               (size_t) (shmem_internal_heap_curr - (char*) shmem_internal_heap_base) >
+               shmem_internal_heap_committed) {
+        /* Commit more of the reserved range */
+        size_t used = shmem_internal_heap_curr - (char*) shmem_internal_heap_base;
+        size_t commit = CEILING(used, shmem_internal_heap_commit_chunk);
+
+        if (commit > (size_t) shmem_internal_heap_length)
+            commit = shmem_internal_heap_length;
+
+        if (0 != mprotect((char*) shmem_internal_heap_base + shmem_internal_heap_committed,
+                          commit - shmem_internal_heap_committed,
+                          PROT_READ | PROT_WRITE)) {
+            RAISE_WARN_MSG("Unable to grow symmetric heap to %zu bytes: %s\n",
+                           commit, strerror(errno));
+            shmem_internal_heap_curr = orig;
+            orig = (void*) -1;
+        } else {
+            shmem_internal_heap_committed = commit;
+        }
     }
 
     return orig;
 }
 
-#ifndef FLOOR
-#define FLOOR(a,b)      ((uint64_t)(a) - ( ((uint64_t)(a)) % (uint64_t)(b)))
-#endif
-#ifndef CEILING
-#define CEILING(a,b)    ((uint64_t)(a) <= 0LL ? 0 : (FLOOR((a)-1,b) + (b)))
-#endif
+
+/* Page size and kind of memory actually backing the symmetric heap, for
+ * SHMEM_INFO */
+static size_t shmem_internal_heap_page_size = 0;
+static const char *shmem_internal_heap_page_kind = "base pages";
+
+/* Length of the heap mapping, which may be rounded up to the page size */
+static size_t shmem_internal_heap_mapped_length = 0;
+
+#ifdef __linux__
+/* Size of a transparent huge page, or 0 if THP is not available */
+static size_t thp_page_size(void)
+{
+    unsigned long size = 0;
+    FILE *fp = fopen("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r");
+
+    if (fp) {
+        if (fscanf(fp, "%lu", &size) != 1) size = 0;
+        fclose(fp);
+    }
+
+    return (size_t) size;
+}
+
+
+/* Bytes of the mapping containing addr that are currently backed by
+ * transparent huge pages, from /proc/self/smaps */
+static size_t thp_mapped_bytes(void *addr)
+{
+    char line[256];
+    unsigned long start, end, kb;
+    size_t total = 0;
+    int in_mapping = 0;
+    FILE *fp = fopen("/proc/self/smaps", "r");
+
+    if (!fp) return 0;
+
+    while (fgets(line, sizeof(line), fp)) {
+        if (2 == sscanf(line, "%lx-%lx ", &start, &end)) {
+            if (in_mapping) break;
+            in_mapping = (uintptr_t) addr >= start && (uintptr_t) addr < end;
+        } else if (in_mapping &&
+                   (1 == sscanf(line, "AnonHugePages: %lu kB", &kb) ||
+                    1 == sscanf(line, "ShmemPmdMapped: %lu kB", &kb))) {
+            total += (size_t) kb * 1024;
+        }
+    }
+
+    fclose(fp);
+    return total;
+}
+#endif /* __linux__ */
+
+
+/* Touch every page of the heap so that it is faulted in at startup rather
+ * than on first use.  With Linux's first-touch policy, pages are placed on
+ * the NUMA node of the touching thread; the threads inherit this PE's CPU
+ * binding, so the heap lands on the PE's local memory. */
+struct prefault_args_t {
+    char  *base;
+    size_t len;
+    size_t page_size;
+};
+
+static void *prefault_range(void *arg)
+{
+    struct prefault_args_t *args = (struct prefault_args_t *) arg;
+    volatile char *p;
+
+    for (p = args->base; p < args->base + args->len; p += args->page_size)
+        *p = 0;
+
+    return NULL;
+}
+
+static void prefault_heap(void *base, size_t bytes, size_t page_size)
+{
+    long nthreads = shmem_internal_params.SYMMETRIC_HEAP_PREFAULT_THREADS;
+    size_t npages = bytes / page_size;
+    struct prefault_args_t whole = { base, bytes, page_size };
+
+    if (nthreads <= 0) return;
+
+#ifdef ENABLE_THREADS
+    if (nthreads > 1 && npages > 1) {
+        pthread_t *threads = malloc(sizeof(pthread_t) * nthreads);
+        struct prefault_args_t *args = malloc(sizeof(struct prefault_args_t) * nthreads);
+        size_t per_thread;
+        long i, started = 0;
+
+        if ((size_t) nthreads > npages) nthreads = npages;
+        per_thread = (npages + nthreads - 1) / nthreads * page_size;
+
+        if (threads && args) {
+            for (i = 0; i < nthreads; i++) {
+                size_t offset = i * per_thread;
+
+                if (offset >= bytes) break;
+                args[i].base      = (char *) base + offset;
+                args[i].len       = (bytes - offset < per_thread) ? bytes - offset : per_thread;
+                args[i].page_size = page_size;
+                if (pthread_create(&threads[i], NULL, prefault_range, &args[i]) != 0) {
+                    /* Touch whatever is left from this thread */
+                    args[i].len = bytes - offset;
+                    prefault_range(&args[i]);
+                    break;
+                }
+                started++;
+            }
+            for (i = 0; i < started; i++)
+                pthread_join(threads[i], NULL);
+
+            free(threads);
+            free(args);
+            return;
+        }
+
+        free(threads);
+        free(args);
+    }
+#else
+    (void) npages;
+#endif /* ENABLE_THREADS */
+
+    prefault_range(&whole);
+}
 
 
 /* alloc VM space starting @ '_end' + 1GB */
 #define ONEGIG (1024UL*1024UL*1024UL)
-static void *mmap_alloc(size_t bytes)
+static void *mmap_alloc(size_t bytes, size_t reserve)
 {
     char *file_name = NULL;
-    int fd = 0;
+    int fd = -1;
     char *directory = NULL;
     void *requested_base =
         (void*) (((unsigned long) shmem_internal_data_base +
                   shmem_internal_data_length + 2 * ONEGIG) & ~(ONEGIG - 1));
-    void *ret;
+    void *ret = MAP_FAILED;
+    size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
 
 #ifdef __linux__
+    size_t thp_size = 0;
+
     /* huge page support only on Linux for now, default is to use 2MB large pages */
     if (shmem_internal_params.SYMMETRIC_HEAP_USE_HUGE_PAGES) {
         const char basename[] = "hugepagefile.SOS";
+        size_t huge_size = shmem_internal_params.SYMMETRIC_HEAP_PAGE_SIZE;
+        size_t huge_bytes = CEILING(bytes, huge_size);
 
         /* check what /proc/mounts has for explicit huge page support */
-        if (find_hugepage_dir(shmem_internal_params.SYMMETRIC_HEAP_PAGE_SIZE,
-                             &directory) == 0)
+        if (find_hugepage_dir(huge_size, &directory) == 0)
         {
             int size = snprintf(NULL, 0, "%s/%s.%d", directory, basename, getpid());
 
             if (size < 0) {
-                RAISE_WARN_STR("snprintf returned error, cannot use huge pages");
+                RAISE_WARN_STR("snprintf returned error, cannot use hugetlbfs");
             } else {
                 file_name = malloc(size + 1);
                 if (file_name) {
                     sprintf(file_name, "%s/%s.%d", directory, basename, getpid());
                     fd = open(file_name, O_CREAT | O_RDWR, 0755);
                     if (fd < 0) {
-                        RAISE_WARN_STR("file open failed, cannot use huge pages");
-                        fd = 0;
+                        RAISE_WARN_STR("file open failed, cannot use hugetlbfs");
+                    } else if (ftruncate(fd, huge_bytes) != 0) {
+                        RAISE_WARN_MSG("ftruncate of %s failed, cannot use hugetlbfs: %s\n",
+                                       file_name, strerror(errno));
                     } else {
-                        /* have to round up by the pagesize being used */
-                        bytes = CEILING(bytes, shmem_internal_params.SYMMETRIC_HEAP_PAGE_SIZE);
+                        /* The mapping must be shared for the file's huge pages
+                         * to back it; the file is unlinked below, so no other
+                         * process can attach to it. */
+                        ret = mmap(requested_base, huge_bytes, PROT_READ | PROT_WRITE,
+                                   MAP_SHARED, fd, 0);
+                        if (ret != MAP_FAILED) {
+                            bytes = huge_bytes;
+                            page_size = huge_size;
+                            shmem_internal_heap_page_kind = "hugetlbfs";
+                        }
                     }
                 }
             }
         }
+
+#ifdef MAP_HUGETLB
+        /* No usable hugetlbfs mount, ask for anonymous huge pages directly */
+        if (ret == MAP_FAILED) {
+            int flags = MAP_ANON | MAP_PRIVATE | MAP_HUGETLB;
+#ifdef MAP_HUGE_SHIFT
+            flags |= (__builtin_ctzl(huge_size) << MAP_HUGE_SHIFT);
+#endif
+            ret = mmap(requested_base, huge_bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+            if (ret != MAP_FAILED) {
+                bytes = huge_bytes;
+                page_size = huge_size;
+                shmem_internal_heap_page_kind = "MAP_HUGETLB";
+            }
+        }
+#endif
+
+        if (ret == MAP_FAILED) {
+            RAISE_WARN_MSG("Unable to back sym. heap with %zuB huge pages, using base pages\n"
+                           RAISE_PE_PREFIX
+                           "Check the hugetlbfs mounts and /proc/sys/vm/nr_hugepages\n",
+                           huge_size, shmem_internal_my_pe);
+        }
     }
 #endif /* __linux__ */
 
-    ret = mmap(requested_base,
-               bytes,
-               PROT_READ | PROT_WRITE,
-               MAP_ANON | MAP_PRIVATE,
-               fd,
-               0);
+    if (ret == MAP_FAILED && reserve > bytes) {
+        /* Reserve the full range and commit the initial heap.  The rest is
+         * committed on demand by shmem_internal_get_next(). */
+#ifdef USE_SHM
+        ret = shmem_transport_shm_heap_map(requested_base, reserve, PROT_NONE,
+                                           MAP_NORESERVE);
+#else
+        ret = mmap(requested_base,
+                   reserve,
+                   PROT_NONE,
+                   MAP_ANON | MAP_PRIVATE | MAP_NORESERVE,
+                   -1,
+                   0);
+#endif
+        if (ret != MAP_FAILED) {
+            shmem_internal_heap_commit_chunk = (page_size > HEAP_COMMIT_CHUNK) ?
+                                               page_size : HEAP_COMMIT_CHUNK;
+            bytes = CEILING(bytes, shmem_internal_heap_commit_chunk);
+            if (bytes > reserve) bytes = reserve;
+
+            if (0 != mprotect(ret, bytes, PROT_READ | PROT_WRITE)) {
+                munmap(ret, reserve);
+                ret = MAP_FAILED;
+            } else {
+                shmem_internal_heap_committed = bytes;
+                shmem_internal_heap_length = reserve;
+            }
+        }
+    } else if (ret == MAP_FAILED) {
+#ifdef USE_SHM
+        ret = shmem_transport_shm_heap_map(requested_base, bytes,
+                                           PROT_READ | PROT_WRITE, 0);
+#else
+        ret = mmap(requested_base,
+                   bytes,
+                   PROT_READ | PROT_WRITE,
+                   MAP_ANON | MAP_PRIVATE,
+                   -1,
+                   0);
+#endif
+    }
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    /* The advice is only a hint, so the page size is not reported until the
+     * kernel has actually backed part of the heap with huge pages */
+    if (ret != MAP_FAILED && shmem_internal_params.SYMMETRIC_HEAP_USE_THP) {
+        size_t advise_len = shmem_internal_heap_committed ? reserve : bytes;
+
+        thp_size = thp_page_size();
+        if (0 == thp_size || 0 != madvise(ret, advise_len, MADV_HUGEPAGE)) {
+            thp_size = 0;
+            RAISE_WARN_STR("Transparent huge pages are not available for the sym. heap");
+        }
+    }
+#endif
+
     if (ret == MAP_FAILED) {
         RAISE_WARN_MSG("Unable to allocate sym. heap, size %zuB: %s\n"
                        RAISE_PE_PREFIX
                        "Try reducing SHMEM_SYMMETRIC_SIZE or number of PEs per node\n",
                        bytes, strerror(errno), shmem_internal_my_pe);
         ret = NULL;
+    } else {
+        shmem_internal_heap_page_size = page_size;
+        shmem_internal_heap_mapped_length = shmem_internal_heap_committed ? reserve : bytes;
+        prefault_heap(ret, bytes, page_size);
+
+#ifdef __linux__
+        if (thp_size > 0) {
+            if (thp_mapped_bytes(ret) > 0) {
+                shmem_internal_heap_page_size = thp_size;
+                shmem_internal_heap_page_kind = "transparent huge pages";
+            } else if (shmem_internal_params.SYMMETRIC_HEAP_PREFAULT_THREADS > 0) {
+                RAISE_WARN_STR("The sym. heap was not backed by transparent huge pages");
+            }
+        }
+#endif
     }
-    if (fd) {
+    if (fd >= 0) {
         if (file_name)
             unlink(file_name);
         close(fd);
@@ -231,38 +532,292 @@ static void *mmap_alloc(size_t bytes)
 }
 
 
+#ifdef ENABLE_THREADS
+/* Per-thread caches of small freed blocks, in power-of-two size classes
+ * starting at 16 bytes.  Only non-collective allocations
+ * (SHMEMX_MALLOC_NO_BARRIER) are served from the caches, and only blocks
+ * that came from a cache, which are tagged with dlmalloc's spare chunk bit,
+ * are put back in one.  Blocks from collective allocations always return
+ * to dlmalloc, so the collective allocation path sees the same dlmalloc
+ * state on every PE and memory they free is available to it again.  A
+ * block freed by a thread is reused by the same thread's next allocation
+ * of that class, which keeps non-collective allocations symmetric whenever
+ * each thread performs the same sequence of allocations on every PE. */
+#define MALLOC_CACHE_NCLASSES 16
+
+typedef struct malloc_cache_block_t {
+    struct malloc_cache_block_t *next;
+} malloc_cache_block_t;
+
+typedef struct {
+    malloc_cache_block_t *head[MALLOC_CACHE_NCLASSES];
+    long count[MALLOC_CACHE_NCLASSES];
+} malloc_cache_t;
+
+static __thread malloc_cache_t *malloc_cache = NULL;
+static pthread_key_t malloc_cache_key;
+static int malloc_cache_key_valid = 0;
+
+static inline int malloc_cache_enabled(void)
+{
+    return shmem_internal_thread_level == SHMEM_THREAD_MULTIPLE &&
+           malloc_cache_key_valid &&
+           shmem_internal_params.MALLOC_CACHE_MAX_SIZE > 0 &&
+           shmem_internal_params.MALLOC_CACHE_DEPTH > 0;
+}
+
+static void malloc_cache_flush(malloc_cache_t *cache)
+{
+    int i;
+
+    SHMEM_MUTEX_LOCK(shmem_internal_mutex_alloc);
+    for (i = 0; i < MALLOC_CACHE_NCLASSES; i++) {
+        while (cache->head[i] != NULL) {
+            malloc_cache_block_t *blk = cache->head[i];
+            cache->head[i] = blk->next;
+            dlmalloc_clear_flag4(blk);
+            dlfree(blk);
+        }
+        cache->count[i] = 0;
+    }
+    SHMEM_MUTEX_UNLOCK(shmem_internal_mutex_alloc);
+}
+
+static void malloc_cache_destroy(void *arg)
+{
+    malloc_cache_t *cache = (malloc_cache_t *) arg;
+
+    malloc_cache_flush(cache);
+    free(cache);
+}
+
+static malloc_cache_t *malloc_cache_get_local(void)
+{
+    if (NULL == malloc_cache) {
+        malloc_cache = calloc(1, sizeof(malloc_cache_t));
+        if (NULL == malloc_cache)
+            return NULL;
+        pthread_setspecific(malloc_cache_key, malloc_cache);
+    }
+
+    return malloc_cache;
+}
+
+/* Smallest class that holds size bytes, or -1 if size is not cached */
+static inline int malloc_cache_class_alloc(size_t size)
+{
+    int cls;
+
+    if (size > (size_t) shmem_internal_params.MALLOC_CACHE_MAX_SIZE)
+        return -1;
+
+    cls = (size <= 16) ? 0 : (int) (sizeof(unsigned long) * CHAR_BIT) -
+                             __builtin_clzl((unsigned long) (size - 1)) - 4;
+
+    return (cls < MALLOC_CACHE_NCLASSES) ? cls : -1;
+}
+
+/* Largest class that fits in a block with usable bytes, or -1 */
+static inline int malloc_cache_class_free(size_t usable)
+{
+    int cls;
+
+    if (usable < 16)
+        return -1;
+
+    cls = (int) (sizeof(unsigned long) * CHAR_BIT) -
+          __builtin_clzl((unsigned long) usable) - 5;
+
+    if (cls >= MALLOC_CACHE_NCLASSES ||
+        ((size_t) 16 << cls) > (size_t) shmem_internal_params.MALLOC_CACHE_MAX_SIZE)
+        return -1;
+
+    return cls;
+}
+
+static void *malloc_cache_alloc(size_t size)
+{
+    int cls = malloc_cache_class_alloc(size);
+    malloc_cache_t *cache;
+    void *ret;
+
+    if (cls < 0 || NULL == (cache = malloc_cache_get_local())) {
+        SHMEM_MUTEX_LOCK(shmem_internal_mutex_alloc);
+        ret = dlmalloc(size);
+        SHMEM_MUTEX_UNLOCK(shmem_internal_mutex_alloc);
+        return ret;
+    }
+
+    if (cache->head[cls] != NULL) {
+        malloc_cache_block_t *blk = cache->head[cls];
+        cache->head[cls] = blk->next;
+        cache->count[cls]--;
+        return blk;
+    }
+
+    SHMEM_MUTEX_LOCK(shmem_internal_mutex_alloc);
+    ret = dlmalloc((size_t) 16 << cls);
+    if (NULL != ret) dlmalloc_set_flag4(ret);
+    SHMEM_MUTEX_UNLOCK(shmem_internal_mutex_alloc);
+
+    /* Give the cached blocks back to the heap and try again */
+    if (NULL == ret) {
+        malloc_cache_flush(cache);
+        SHMEM_MUTEX_LOCK(shmem_internal_mutex_alloc);
+        ret = dlmalloc((size_t) 16 << cls);
+        if (NULL != ret) dlmalloc_set_flag4(ret);
+        SHMEM_MUTEX_UNLOCK(shmem_internal_mutex_alloc);
+    }
+
+    return ret;
+}
+
+/* Returns 1 if ptr came from a cache and was either placed in the calling
+ * thread's cache or given back to dlmalloc */
+static int malloc_cache_free(void *ptr)
+{
+    malloc_cache_t *cache;
+    malloc_cache_block_t *blk;
+    int cls;
+
+    /* Only the owner of an allocated block changes its size and tag bits,
+     * so they can be read without the allocator mutex */
+    if (!dlmalloc_flag4(ptr))
+        return 0;
+
+    cls = malloc_cache_class_free(dlmalloc_usable_size(ptr));
+    if (cls < 0 || NULL == (cache = malloc_cache_get_local()) ||
+        cache->count[cls] >= shmem_internal_params.MALLOC_CACHE_DEPTH) {
+        SHMEM_MUTEX_LOCK(shmem_internal_mutex_alloc);
+        dlmalloc_clear_flag4(ptr);
+        dlfree(ptr);
+        SHMEM_MUTEX_UNLOCK(shmem_internal_mutex_alloc);
+        return 1;
+    }
+
+    blk = (malloc_cache_block_t *) ptr;
+    blk->next = cache->head[cls];
+    cache->head[cls] = blk;
+    cache->count[cls]++;
+
+    return 1;
+}
+#endif /* ENABLE_THREADS */
+
+
+void
+shmem_internal_symmetric_print_info(void)
+{
+    if (shmem_internal_params.SYMMETRIC_HEAP_USE_MALLOC)
+        printf("Symmetric heap: malloc, %ld bytes\n", shmem_internal_heap_length);
+    else if (shmem_internal_heap_committed > 0)
+        printf("Symmetric heap: %zu bytes committed, growable to %ld bytes, %zu byte pages (%s)\n",
+               shmem_internal_heap_committed, shmem_internal_heap_length,
+               shmem_internal_heap_page_size, shmem_internal_heap_page_kind);
+    else
+        printf("Symmetric heap: %ld bytes, %zu byte pages (%s)\n",
+               shmem_internal_heap_length, shmem_internal_heap_page_size,
+               shmem_internal_heap_page_kind);
+}
+
+
 int
 shmem_internal_symmetric_init(void)
 {
+    size_t atomics_len = CEILING(shmem_internal_params.SYMMETRIC_HEAP_ATOMICS_SIZE,
+                                 HEAP_COMMIT_CHUNK);
+
     /* add library overhead such that the max can be shmalloc()'ed */
     shmem_internal_heap_length = shmem_internal_params.SYMMETRIC_SIZE +
-                                 SHMEM_INTERNAL_HEAP_OVERHEAD;
+                                 SHMEM_INTERNAL_HEAP_OVERHEAD + atomics_len;
 
     if (!shmem_internal_params.SYMMETRIC_HEAP_USE_MALLOC) {
+        size_t reserve = 0;
+
+        if (shmem_internal_params.SYMMETRIC_HEAP_MAX_SIZE > (size_t) shmem_internal_heap_length) {
+            if (!SYMMETRIC_HEAP_GROWTH_SUPPORTED)
+                RAISE_WARN_STR("The transport pins the sym. heap, ignoring SHMEM_SYMMETRIC_HEAP_MAX_SIZE");
+#ifdef __linux__
+            else if (shmem_internal_params.SYMMETRIC_HEAP_USE_HUGE_PAGES)
+                RAISE_WARN_STR("SHMEM_SYMMETRIC_HEAP_MAX_SIZE is not supported with huge pages, ignoring");
+#endif
+            else
+                reserve = shmem_internal_params.SYMMETRIC_HEAP_MAX_SIZE;
+        }
+
         shmem_internal_heap_base =
             shmem_internal_heap_curr =
-            mmap_alloc(shmem_internal_heap_length);
+            mmap_alloc(shmem_internal_heap_length, reserve);
     } else {
         shmem_internal_heap_base =
             shmem_internal_heap_curr =
             malloc(shmem_internal_heap_length);
     }
 
-    return (NULL == shmem_internal_heap_base) ? -1 : 0;
+    if (NULL == shmem_internal_heap_base)
+        return -1;
+
+#ifdef USE_SHM
+    /* Share the data segment before any transport registers it */
+    if (0 != shmem_transport_shm_data_share())
+        return -1;
+#endif
+
+    if (atomics_len > 0) {
+        void *base = shmem_internal_get_next(atomics_len);
+
+        if (base != (void *) -1)
+            shmem_internal_atomics_mspace = create_mspace_with_base(base, atomics_len, 0);
+
+        if (NULL == shmem_internal_atomics_mspace) {
+            RAISE_WARN_STR("Unable to create the sub-heap for remotely updated objects");
+        } else {
+            /* Never extend the sub-heap through morecore */
+            mspace_set_footprint_limit(shmem_internal_atomics_mspace, atomics_len);
+            shmem_internal_atomics_heap_base = base;
+            shmem_internal_atomics_heap_length = atomics_len;
+        }
+    }
+
+    realloc_in_place_flags = dlmalloc(sizeof(int) * 2);
+    if (NULL == realloc_in_place_flags)
+        return -1;
+
+#ifdef ENABLE_THREADS
+    if (0 == pthread_key_create(&malloc_cache_key, malloc_cache_destroy))
+        malloc_cache_key_valid = 1;
+#endif
+
+    return 0;
 }
 
 
 int
 shmem_internal_symmetric_fini(void)
 {
+#ifdef ENABLE_THREADS
+    /* The heap is going away, so the cached blocks are simply dropped */
+    if (malloc_cache_key_valid) {
+        pthread_key_delete(malloc_cache_key);
+        malloc_cache_key_valid = 0;
+    }
+    free(malloc_cache);
+    malloc_cache = NULL;
+#endif
+
     if (NULL != shmem_internal_heap_base) {
         if (!shmem_internal_params.SYMMETRIC_HEAP_USE_MALLOC) {
-            munmap( (void*)shmem_internal_heap_base, (size_t)shmem_internal_heap_length );
+            munmap( (void*)shmem_internal_heap_base, shmem_internal_heap_mapped_length );
         } else {
             free(shmem_internal_heap_base);
         }
         shmem_internal_heap_length = 0;
+        shmem_internal_heap_committed = 0;
         shmem_internal_heap_base = shmem_internal_heap_curr = NULL;
+        shmem_internal_atomics_mspace = NULL;
+        realloc_in_place_flags = NULL;
+        shmem_internal_atomics_heap_base = NULL;
+        shmem_internal_atomics_heap_length = 0;
     }
 
     return 0;
@@ -282,6 +837,43 @@ shmem_internal_shmalloc(size_t size)
 }
 
 
+static void *atomics_heap_alloc(size_t size)
+{
+    static int warned = 0;
+    size_t padded = ATOMICS_HEAP_REQ_SIZE(size);
+    void *ret = NULL;
+
+    SHMEM_MUTEX_LOCK(shmem_internal_mutex_alloc);
+    if (NULL != shmem_internal_atomics_mspace)
+        ret = mspace_memalign(shmem_internal_atomics_mspace, ATOMICS_HEAP_ALIGN, padded);
+    /* Fall back to the main heap when the sub-heap is full or absent.  AMOs
+     * are routed by address, so objects placed there are treated like any
+     * other and may be updated through shared memory. */
+    if (NULL == ret) {
+        ret = dlmemalign(ATOMICS_HEAP_ALIGN, padded);
+        if (NULL != ret && !warned) {
+            warned = 1;
+            RAISE_WARN_MSG("The sub-heap for remotely updated objects is %s, placing %zu "
+                           "bytes in the main heap (see SHMEM_SYMMETRIC_HEAP_ATOMICS_SIZE)\n",
+                           NULL == shmem_internal_atomics_mspace ? "disabled" : "full",
+                           size);
+        }
+    }
+    SHMEM_MUTEX_UNLOCK(shmem_internal_mutex_alloc);
+
+    return ret;
+}
+
+
+void
+shmem_internal_atomics_heap_free(void *ptr)
+{
+    SHMEM_MUTEX_LOCK(shmem_internal_mutex_alloc);
+    mspace_free(shmem_internal_atomics_mspace, ptr);
+    SHMEM_MUTEX_UNLOCK(shmem_internal_mutex_alloc);
+}
+
+
 void SHMEM_FUNCTION_ATTRIBUTES *
 shmem_malloc(size_t size)
 {
@@ -328,15 +920,146 @@ shmem_free(void *ptr)
 
     shmem_internal_barrier_all();
 
+#ifdef ENABLE_THREADS
+    if (ptr != NULL && malloc_cache_enabled() &&
+        !shmem_internal_in_atomics_heap(ptr) && malloc_cache_free(ptr))
+        return;
+#endif
+
     shmem_internal_free(ptr);
 }
 
 
-void SHMEM_FUNCTION_ATTRIBUTES *
-shmem_realloc(void *ptr, size_t size)
+static void *
+realloc_moving(void *ptr, size_t size)
 {
     void *ret;
 
+    SHMEM_MUTEX_LOCK(shmem_internal_mutex_alloc);
+    if (ptr != NULL && shmem_internal_in_atomics_heap(ptr)) {
+        if (size == 0) {
+            mspace_free(shmem_internal_atomics_mspace, ptr);
+            ret = NULL;
+        } else {
+            ret = mspace_realloc(shmem_internal_atomics_mspace, ptr,
+                                 ATOMICS_HEAP_REQ_SIZE(size));
+        }
+    } else if (size == 0 && ptr != NULL) {
+        dlfree(ptr);
+        ret = NULL;
+    } else {
+        ret = dlrealloc(ptr, size);
+    }
+    SHMEM_MUTEX_UNLOCK(shmem_internal_mutex_alloc);
+
+    return ret;
+}
+
+
+/* Barrier over team on the team's collective context.  Operations on the
+ * default context, through which the user accesses the block, are completed
+ * first, as shmem_internal_barrier only quiets the context it runs on. */
+static void
+team_barrier(shmem_internal_team_t *team)
+{
+    if (team == &shmem_internal_team_world) {
+        shmem_internal_barrier_all();
+    } else {
+        long *psync;
+
+        shmem_internal_quiet(SHMEM_CTX_DEFAULT);
+        psync = shmem_internal_team_choose_psync(team, SYNC);
+        shmem_internal_barrier(shmem_internal_team_ctx(team), team->start,
+                               team->stride, team->size, psync);
+        shmem_internal_team_release_psyncs(team, SYNC);
+    }
+}
+
+
+/* Realloc across the PEs in team.  The PEs first try to resize the block
+ * without moving it and agree on the outcome with a single reduction, which
+ * also orders the call after every PE has entered realloc.  The block only
+ * grows before that point, so remote accesses to the old extent stay valid;
+ * a shrink is applied afterwards.  When every PE succeeds, no barrier is
+ * needed.  Otherwise, in-place growth is undone and the block is moved,
+ * followed by a barrier as in the general path. */
+static void *
+realloc_team(shmem_internal_team_t *team, void *ptr, size_t size)
+{
+    size_t old_size;
+    int in_place = 1;
+    long *psync;
+
+    if (ptr == NULL || size == 0 || shmem_internal_in_atomics_heap(ptr) ||
+        !shmem_internal_params.SYMMETRIC_REALLOC_IN_PLACE) {
+        void *ret;
+
+        team_barrier(team);
+        ret = realloc_moving(ptr, size);
+        team_barrier(team);
+
+        return ret;
+    }
+
+    /* Complete this PE's accesses to the old block, the reduction below runs
+     * on the team's context */
+    shmem_internal_quiet(SHMEM_CTX_DEFAULT);
+
+    SHMEM_MUTEX_LOCK(shmem_internal_mutex_alloc);
+    old_size = dlmalloc_usable_size(ptr);
+    if (size > old_size) {
+        in_place = (NULL != dlrealloc_in_place(ptr, size));
+
+        /* dlrealloc_in_place() does not call morecore, so a block at the end
+         * of the heap cannot grow past the current top chunk.  Allocating
+         * and freeing a block of the new size extends the top chunk when
+         * that is where the allocation comes from. */
+        if (!in_place) {
+            void *tmp = dlmalloc(size);
+            if (tmp != NULL) {
+                dlfree(tmp);
+                in_place = (NULL != dlrealloc_in_place(ptr, size));
+            }
+        }
+    }
+    SHMEM_MUTEX_UNLOCK(shmem_internal_mutex_alloc);
+
+    realloc_in_place_flags[0] = in_place;
+
+    psync = shmem_internal_team_choose_psync(team, REDUCE);
+    shmem_internal_op_to_all(shmem_internal_team_ctx(team),
+                             &realloc_in_place_flags[1], &realloc_in_place_flags[0],
+                             1, sizeof(int), team->start, team->stride, team->size,
+                             NULL, psync, SHM_INTERNAL_MIN, SHM_INTERNAL_INT);
+    shmem_internal_team_release_psyncs(team, REDUCE);
+
+    if (realloc_in_place_flags[1]) {
+        if (size < old_size) {
+            SHMEM_MUTEX_LOCK(shmem_internal_mutex_alloc);
+            dlrealloc_in_place(ptr, size);
+            SHMEM_MUTEX_UNLOCK(shmem_internal_mutex_alloc);
+        }
+        return ptr;
+    }
+
+    /* Some PE must move the block, so all of them do, from the same heap
+     * state */
+    if (in_place && size > old_size) {
+        SHMEM_MUTEX_LOCK(shmem_internal_mutex_alloc);
+        dlrealloc_in_place(ptr, old_size);
+        SHMEM_MUTEX_UNLOCK(shmem_internal_mutex_alloc);
+    }
+
+    ptr = realloc_moving(ptr, size);
+    team_barrier(team);
+
+    return ptr;
+}
+
+
+void SHMEM_FUNCTION_ATTRIBUTES *
+shmem_realloc(void *ptr, size_t size)
+{
     SHMEM_ERR_CHECK_INITIALIZED();
 
     if (size == 0 && ptr == NULL) return ptr;
@@ -344,20 +1067,22 @@ shmem_realloc(void *ptr, size_t size)
       SHMEM_ERR_CHECK_SYMMETRIC_HEAP(ptr);
     }
 
-    shmem_internal_barrier_all();
+    return realloc_team(&shmem_internal_team_world, ptr, size);
+}
 
-    SHMEM_MUTEX_LOCK(shmem_internal_mutex_alloc);
-    if (size == 0 && ptr != NULL) {
-        dlfree(ptr);
-        ret = NULL;
-    } else {
-        ret = dlrealloc(ptr, size);
-    }
-    SHMEM_MUTEX_UNLOCK(shmem_internal_mutex_alloc);
 
-    shmem_internal_barrier_all();
+void SHMEM_FUNCTION_ATTRIBUTES *
+shmemx_team_realloc(shmem_team_t team, void *ptr, size_t size)
+{
+    SHMEM_ERR_CHECK_INITIALIZED();
+    SHMEM_ERR_CHECK_TEAM_VALID(team);
 
-    return ret;
+    if (size == 0 && ptr == NULL) return ptr;
+    if (ptr != NULL) {
+      SHMEM_ERR_CHECK_SYMMETRIC_HEAP(ptr);
+    }
+
+    return realloc_team((shmem_internal_team_t *) team, ptr, size);
 }
 
 
@@ -426,9 +1151,19 @@ shmem_malloc_with_hints(size_t size, long hints)
         RAISE_WARN_MSG("Ignoring invalid hint for shmem_malloc_with_hints(%ld)\n", hints);
     }
 
-    SHMEM_MUTEX_LOCK(shmem_internal_mutex_alloc);
-    ret = dlmalloc(size);
-    SHMEM_MUTEX_UNLOCK(shmem_internal_mutex_alloc);
+    if (hints & (SHMEM_MALLOC_ATOMICS_REMOTE | SHMEM_MALLOC_SIGNAL_REMOTE)) {
+        ret = atomics_heap_alloc(size);
+    }
+#ifdef ENABLE_THREADS
+    else if ((hints & SHMEMX_MALLOC_NO_BARRIER) && malloc_cache_enabled()) {
+        return malloc_cache_alloc(size);
+    }
+#endif
+    else {
+        SHMEM_MUTEX_LOCK(shmem_internal_mutex_alloc);
+        ret = dlmalloc(size);
+        SHMEM_MUTEX_UNLOCK(shmem_internal_mutex_alloc);
+    }
 
     if (!(hints & SHMEMX_MALLOC_NO_BARRIER))
         shmem_internal_barrier_all();
@@ -26,6 +26,7 @@
 #endif
 
 #include <unistd.h>
+#include <limits.h>
 #include <sys/types.h>
 #include <string.h>
 #include <errno.h>
@@ -144,4 +145,148 @@ shmem_transport_cma_get(void *target, const void *source, size_t len, int pe,
         }
 }
 
+/*
+ * Batched transfers: segments for one peer are gathered into iovec arrays
+ * and submitted with one process_vm_writev/readv call per
+ * SHMEM_TRANSPORT_CMA_IOV_MAX segments.  Segments that are contiguous on
+ * both sides are merged.
+ */
+#if defined(IOV_MAX) && IOV_MAX < 256
+#define SHMEM_TRANSPORT_CMA_IOV_MAX IOV_MAX
+#else
+#define SHMEM_TRANSPORT_CMA_IOV_MAX 256
+#endif
+
+typedef struct {
+    pid_t        pid;
+    int          is_get;
+    int          count;
+    size_t       len;
+    struct iovec local[SHMEM_TRANSPORT_CMA_IOV_MAX];
+    struct iovec remote[SHMEM_TRANSPORT_CMA_IOV_MAX];
+} shmem_transport_cma_batch_t;
+
+static inline void
+shmem_transport_cma_batch_init(shmem_transport_cma_batch_t *batch,
+                               int noderank, int is_get)
+{
+        batch->pid = shmem_transport_cma_peers[noderank];
+        batch->is_get = is_get;
+        batch->count = 0;
+        batch->len = 0;
+}
+
+
+static inline void
+shmem_transport_cma_batch_flush(shmem_transport_cma_batch_t *batch)
+{
+        ssize_t bytes;
+        int i;
+
+        if (batch->count == 0)
+            return;
+
+        if ( batch->pid == shmem_transport_cma_my_pid ) {
+            for (i = 0; i < batch->count; i++) {
+                if (batch->is_get)
+                    memcpy(batch->local[i].iov_base, batch->remote[i].iov_base,
+                           batch->local[i].iov_len);
+                else
+                    memcpy(batch->remote[i].iov_base, batch->local[i].iov_base,
+                           batch->local[i].iov_len);
+            }
+        } else if (batch->is_get) {
+            bytes = process_vm_readv(batch->pid, batch->local, batch->count,
+                                     batch->remote, batch->count, 0);
+            if ( bytes < 0 || (size_t) bytes != batch->len) {
+                char errmsg[256];
+                RAISE_ERROR_MSG("process_vm_readv() failed (%s)\n",
+                                shmem_util_strerror(errno, errmsg, 256));
+            }
+        } else {
+            bytes = process_vm_writev(batch->pid, batch->local, batch->count,
+                                      batch->remote, batch->count, 0);
+            if ( bytes < 0 || (size_t) bytes != batch->len) {
+                char errmsg[256];
+                RAISE_ERROR_MSG("process_vm_writev() failed (%s)\n",
+                                shmem_util_strerror(errno, errmsg, 256));
+            }
+        }
+
+        batch->count = 0;
+        batch->len = 0;
+}
+
+
+static inline void
+shmem_transport_cma_batch_add(shmem_transport_cma_batch_t *batch,
+                              void *local, void *remote, size_t len)
+{
+        CHK_ACCESS(remote, "cma_batch remote");
+
+        if (batch->count > 0) {
+            struct iovec *l = &batch->local[batch->count - 1];
+            struct iovec *r = &batch->remote[batch->count - 1];
+
+            if ((char *) l->iov_base + l->iov_len == (char *) local &&
+                (char *) r->iov_base + r->iov_len == (char *) remote) {
+                l->iov_len += len;
+                r->iov_len += len;
+                batch->len += len;
+                return;
+            }
+
+            if (batch->count == SHMEM_TRANSPORT_CMA_IOV_MAX)
+                shmem_transport_cma_batch_flush(batch);
+        }
+
+        batch->local[batch->count].iov_base = local;
+        batch->local[batch->count].iov_len = len;
+        batch->remote[batch->count].iov_base = remote;
+        batch->remote[batch->count].iov_len = len;
+        batch->count++;
+        batch->len += len;
+}
+
+
+/* Strides are in units of elements, as in the iput/iget API */
+static inline void
+shmem_transport_cma_iput(void *target, const void *source, ptrdiff_t tst,
+                         ptrdiff_t sst, size_t elem_size, size_t nelems,
+                         int pe, int noderank)
+{
+        shmem_transport_cma_batch_t batch;
+
+        shmem_transport_cma_batch_init(&batch, noderank, 0);
+
+        for ( ; nelems > 0; --nelems) {
+            shmem_transport_cma_batch_add(&batch, (void *) source, target,
+                                          elem_size);
+            target = (uint8_t *) target + tst * elem_size;
+            source = (const uint8_t *) source + sst * elem_size;
+        }
+
+        shmem_transport_cma_batch_flush(&batch);
+}
+
+
+static inline void
+shmem_transport_cma_iget(void *target, const void *source, ptrdiff_t tst,
+                         ptrdiff_t sst, size_t elem_size, size_t nelems,
+                         int pe, int noderank)
+{
+        shmem_transport_cma_batch_t batch;
+
+        shmem_transport_cma_batch_init(&batch, noderank, 1);
+
+        for ( ; nelems > 0; --nelems) {
+            shmem_transport_cma_batch_add(&batch, target, (void *) source,
+                                          elem_size);
+            target = (uint8_t *) target + tst * elem_size;
+            source = (const uint8_t *) source + sst * elem_size;
+        }
+
+        shmem_transport_cma_batch_flush(&batch);
+}
+
 #endif /* SHMEM_TRANSPORT_CMA_H */
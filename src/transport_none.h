@@ -38,6 +38,7 @@ typedef int shmem_transport_ct_t;
 struct shmem_transport_ctx_t {
     long options;
     struct shmem_internal_team_t *team;
+    struct shmem_internal_agg_t *agg;
 };
 typedef struct shmem_transport_ctx_t shmem_transport_ctx_t;
 
@@ -77,6 +78,7 @@ shmem_transport_ctx_create(struct shmem_internal_team_t *team, long options, shm
         return 1;
 
     (*ctx)->team = team;
+    (*ctx)->agg = NULL;
     (*ctx)->options = 0;
 
     return 0;
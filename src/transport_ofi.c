@@ -107,8 +107,10 @@ size_t                          shmem_transport_ofi_addrlen;
 int                             shmem_transport_ofi_mr_rma_event;
 #endif
 fi_addr_t                       *addr_table;
+int                             shmem_transport_ofi_av_lazy = 0;
 #ifdef ENABLE_THREADS
 shmem_internal_mutex_t          shmem_transport_ofi_lock;
+shmem_internal_mutex_t          shmem_transport_ofi_av_lock;
 pthread_mutex_t                 shmem_transport_ofi_progress_lock = PTHREAD_MUTEX_INITIALIZER;
 #endif /* ENABLE_THREADS */
 
@@ -1246,12 +1248,50 @@ int publish_av_info(struct fabric_info *info)
     return ret;
 }
 
+fi_addr_t shmem_transport_ofi_av_connect(int pe)
+{
+    int ret;
+    fi_addr_t addr;
+    char epname[128];
+
+    SHMEM_MUTEX_LOCK(shmem_transport_ofi_av_lock);
+
+    /* Another thread may have inserted the address while we waited */
+    addr = __atomic_load_n(&addr_table[pe], __ATOMIC_ACQUIRE);
+    if (addr != FI_ADDR_NOTAVAIL) {
+        SHMEM_MUTEX_UNLOCK(shmem_transport_ofi_av_lock);
+        return addr;
+    }
+
+    ret = shmem_runtime_get(pe, "fi_epname", epname, shmem_transport_ofi_addrlen);
+    if (ret != 0) {
+        RAISE_ERROR_MSG("Runtime get of 'fi_epname' failed for PE %d (%d)\n", pe, ret);
+    }
+
+    ret = fi_av_insert(shmem_transport_ofi_avfd, epname, 1, &addr, 0, NULL);
+    if (ret != 1) {
+        RAISE_ERROR_MSG("AV insert failed for PE %d (%d)\n", pe, ret);
+    }
+
+    /* Pairs with the acquire load in shmem_transport_ofi_get_dest(), which
+     * readers perform without taking the lock */
+    __atomic_store_n(&addr_table[pe], addr, __ATOMIC_RELEASE);
+
+    SHMEM_MUTEX_UNLOCK(shmem_transport_ofi_av_lock);
+
+    return addr;
+}
+
 static inline
 int populate_av(void)
 {
     int    i, ret, err = 0;
     char   *alladdrs = NULL;
 
+    /* Addresses are inserted by shmem_transport_ofi_av_connect on first use */
+    if (shmem_transport_ofi_av_lazy)
+        return 0;
+
     alladdrs = malloc(shmem_internal_num_pes * shmem_transport_ofi_addrlen);
     if (alladdrs == NULL) {
         RAISE_WARN_STR("Out of memory allocating 'alladdrs'");
@@ -1322,8 +1362,25 @@ int allocate_fabric_resources(struct fabric_info *info)
     /* open Address Vector and bind the AV to the domain */
     av_attr.type = FI_AV_TABLE;
     addr_table   = NULL;
+
+    /* Table indices follow insertion order, which is no longer the PE number
+     * when peers are inserted lazily */
+    if (shmem_transport_ofi_av_lazy)
+        addr_table = (fi_addr_t*) malloc(info->npes * sizeof(fi_addr_t));
 #endif
 
+    if (shmem_transport_ofi_av_lazy) {
+        int i;
+
+        if (addr_table == NULL) {
+            RAISE_WARN_STR("Out of memory allocating 'addr_table'");
+            return 1;
+        }
+
+        for (i = 0; i < info->npes; i++)
+            addr_table[i] = FI_ADDR_NOTAVAIL;
+    }
+
     ret = fi_av_open(shmem_transport_ofi_domainfd,
                      &av_attr,
                      &shmem_transport_ofi_avfd,
@@ -1784,8 +1841,10 @@ int shmem_transport_init(void)
     int ret = 0;
 
     SHMEM_MUTEX_INIT(shmem_transport_ofi_lock);
+    SHMEM_MUTEX_INIT(shmem_transport_ofi_av_lock);
 
     shmem_transport_ofi_info.npes = shmem_runtime_get_size();
+    shmem_transport_ofi_av_lazy = shmem_internal_params.OFI_AV_LAZY;
 
     if (shmem_internal_params.OFI_PROVIDER_provided)
         shmem_transport_ofi_info.prov_name = shmem_internal_params.OFI_PROVIDER;
@@ -2210,13 +2269,12 @@ int shmem_transport_fini(void)
     ret = fi_close(&shmem_transport_ofi_fabfd->fid);
     OFI_CHECK_ERROR_MSG(ret, "Fabric close failed (%s)\n", fi_strerror(errno));
 
-#ifdef USE_AV_MAP
     free(addr_table);
-#endif
 
     fi_freeinfo(shmem_transport_ofi_info.fabrics);
 
     SHMEM_MUTEX_DESTROY(shmem_transport_ofi_lock);
+    SHMEM_MUTEX_DESTROY(shmem_transport_ofi_av_lock);
 
     return 0;
 }
@@ -222,13 +222,35 @@ typedef enum fi_op       shm_internal_op_t;
 
 
 extern fi_addr_t *addr_table;
+extern int shmem_transport_ofi_av_lazy;
 
-#ifdef USE_AV_MAP
-#define GET_DEST(dest) ((fi_addr_t)(addr_table[(dest)]))
-#else
-#define GET_DEST(dest) ((fi_addr_t)(dest))
+fi_addr_t shmem_transport_ofi_av_connect(int pe);
+
+/* In lazy AV mode, addr_table entries start out as FI_ADDR_NOTAVAIL and the
+ * peer's address is fetched from the runtime and inserted on first use.
+ * shmem_transport_ofi_av_connect() publishes an entry with a release store
+ * only after fi_av_insert() has returned, so the acquire load below either
+ * sees FI_ADDR_NOTAVAIL or a fully inserted address; a miss is rechecked
+ * under shmem_transport_ofi_av_lock. */
+static inline
+fi_addr_t shmem_transport_ofi_get_dest(int dest)
+{
+    fi_addr_t addr;
+
+#ifndef USE_AV_MAP
+    if (!shmem_transport_ofi_av_lazy)
+        return (fi_addr_t) dest;
 #endif
 
+    addr = __atomic_load_n(&addr_table[dest], __ATOMIC_ACQUIRE);
+    if (unlikely(addr == FI_ADDR_NOTAVAIL))
+        addr = shmem_transport_ofi_av_connect(dest);
+
+    return addr;
+}
+
+#define GET_DEST(dest) shmem_transport_ofi_get_dest(dest)
+
 
 struct shmem_transport_ofi_frag_t {
     shmem_free_list_item_t item;
@@ -282,6 +304,7 @@ struct shmem_transport_ctx_t {
     int                             stx_idx;
     struct shmem_internal_tid       tid;
     struct shmem_internal_team_t   *team;
+    struct shmem_internal_agg_t    *agg;
 };
 
 typedef struct shmem_transport_ctx_t shmem_transport_ctx_t;
@@ -320,6 +320,7 @@ shmem_transport_ctx_create(struct shmem_internal_team_t *team, long options, shm
     }
 
     (*ctx)->team = team;
+    (*ctx)->agg = NULL;
 
     SHMEM_MUTEX_UNLOCK(shmem_internal_mutex_ptl4_ctx);
 
@@ -143,6 +143,7 @@ struct shmem_transport_ctx_t {
     shmem_internal_cntr_t pending_put_cntr;
     shmem_internal_cntr_t pending_get_cntr;
     struct shmem_internal_team_t   *team;
+    struct shmem_internal_agg_t    *agg;
 };
 
 typedef struct shmem_transport_ctx_t shmem_transport_ctx_t;
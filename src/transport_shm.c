@@ -0,0 +1,351 @@
+/* -*- C -*-
+ *
+ * This file is part of the Sandia OpenSHMEM software package. For license
+ * information, see the LICENSE file in the top level directory of the
+ * distribution.
+ *
+ */
+
+#include "config.h"
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* for mremap */
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#ifdef ENABLE_THREADS
+#include <pthread.h>
+#endif
+
+#define SHMEM_INTERNAL_INCLUDE
+#include "shmem.h"
+#include "shmem_internal.h"
+#include "shmem_comm.h"
+#include "runtime.h"
+
+#define SHM_NAME_LEN 64
+
+struct share_info_t {
+    char data_name[SHM_NAME_LEN];
+    size_t data_len;
+    size_t data_off;
+    char heap_name[SHM_NAME_LEN];
+    size_t heap_len;
+    size_t heap_off;
+};
+
+struct shmem_transport_shm_peer_info_t *shmem_transport_shm_peers = NULL;
+static struct share_info_t my_info;
+static int my_names_unlinked = 0;
+
+#define FIND_BASE(ptr, page_size) ((char*) (((uintptr_t) ptr / page_size) * page_size))
+#define FIND_LEN(ptr, len, page_size) ((((char*) ptr - FIND_BASE(ptr, page_size) + len - 1) / \
+                                        page_size + 1) * page_size)
+
+/* The MAP_SHARED mappings of the symmetric areas would be shared with the
+ * children of fork() instead of copied, so stores by a child would land in
+ * the PE's symmetric memory.  The heap is left out of the children. */
+static void
+shm_heap_no_fork(void *addr, size_t len)
+{
+#ifdef MADV_DONTFORK
+    char errmsg[256];
+
+    if (0 != madvise(addr, len, MADV_DONTFORK)) {
+        RAISE_WARN_MSG("madvise(MADV_DONTFORK) of the sym. heap failed, it will be "
+                       "shared with fork()ed children: %s\n",
+                       shmem_util_strerror(errno, errmsg, 256));
+    }
+#endif
+}
+
+
+#if defined(ENABLE_THREADS) && defined(MREMAP_FIXED)
+static char *data_share_base = NULL;
+static size_t data_share_len = 0;
+
+/* The data segment also holds the GOT, which a child needs to reach exec, so
+ * instead of leaving it out, the child gets a private copy as it would
+ * without the transport.  mremap() moves the copy into place in a single
+ * call, so the segment is never missing while the child runs. */
+static void
+shm_data_fork_child(void)
+{
+    void *copy = mmap(NULL, data_share_len, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (MAP_FAILED == copy) return;
+
+    memcpy(copy, data_share_base, data_share_len);
+    if (MAP_FAILED == mremap(copy, data_share_len, data_share_len,
+                             MREMAP_MAYMOVE | MREMAP_FIXED, data_share_base))
+        munmap(copy, data_share_len);
+}
+#endif
+
+static void
+shm_object_name(char *name, const char *segment)
+{
+    snprintf(name, SHM_NAME_LEN, "/sos-%d-%d-%s", (int) getpid(),
+             shmem_internal_my_pe, segment);
+}
+
+
+/* Create a shared memory object of len bytes and return its descriptor */
+static int
+shm_object_create(const char *name, size_t len)
+{
+    int fd;
+    char errmsg[256];
+
+    /* Remove a stale object left behind by an earlier process with our pid */
+    shm_unlink(name);
+
+    fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        RETURN_ERROR_MSG("shm_open of %s failed: %s\n", name,
+                         shmem_util_strerror(errno, errmsg, 256));
+        return -1;
+    }
+
+    if (0 != ftruncate(fd, len)) {
+        RETURN_ERROR_MSG("ftruncate of %s to %zu bytes failed: %s\n", name, len,
+                         shmem_util_strerror(errno, errmsg, 256));
+        close(fd);
+        shm_unlink(name);
+        return -1;
+    }
+
+    return fd;
+}
+
+
+void *
+shmem_transport_shm_heap_map(void *addr, size_t len, int prot, int flags)
+{
+    void *ret;
+    int fd;
+
+    shm_object_name(my_info.heap_name, "heap");
+    fd = shm_object_create(my_info.heap_name, len);
+    if (fd < 0) return MAP_FAILED;
+
+    ret = mmap(addr, len, prot, MAP_SHARED | flags, fd, 0);
+    close(fd);
+
+    if (MAP_FAILED == ret) {
+        shm_unlink(my_info.heap_name);
+    } else {
+        shm_heap_no_fork(ret, len);
+        my_info.heap_len = len;
+        my_info.heap_off = 0;
+    }
+
+    return ret;
+}
+
+
+int
+shmem_transport_shm_data_share(void)
+{
+    long page_size = sysconf(_SC_PAGESIZE);
+    char name[SHM_NAME_LEN];
+    char *base;
+    size_t len;
+    void *copy, *ret;
+    int fd;
+    char errmsg[256];
+
+    base = FIND_BASE(shmem_internal_data_base, page_size);
+    len = FIND_LEN(shmem_internal_data_base, shmem_internal_data_length, page_size);
+
+    shm_object_name(name, "data");
+    fd = shm_object_create(name, len);
+    if (fd < 0) return 1;
+
+    copy = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (MAP_FAILED == copy) {
+        RETURN_ERROR_MSG("mmap of %s failed: %s\n", name,
+                         shmem_util_strerror(errno, errmsg, 256));
+        close(fd);
+        shm_unlink(name);
+        return 1;
+    }
+
+    /* Stores to the data segment between the copy and the remap would be
+     * lost, so only locals are touched until the remap completes */
+    memcpy(copy, base, len);
+    ret = mmap(base, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    munmap(copy, len);
+    close(fd);
+
+    if (MAP_FAILED == ret) {
+        RETURN_ERROR_MSG("remapping the data segment to %s failed: %s\n", name,
+                         shmem_util_strerror(errno, errmsg, 256));
+        shm_unlink(name);
+        return 1;
+    }
+
+#if defined(ENABLE_THREADS) && defined(MREMAP_FIXED)
+    data_share_base = base;
+    data_share_len  = len;
+    if (0 != pthread_atfork(NULL, NULL, shm_data_fork_child)) {
+        RAISE_WARN_STR("Unable to register a fork handler, the data segment will be "
+                       "shared with fork()ed children");
+    }
+#endif
+
+    strcpy(my_info.data_name, name);
+    my_info.data_len = len;
+    my_info.data_off = (char*) shmem_internal_data_base - base;
+
+    return 0;
+}
+
+
+int
+shmem_transport_shm_init(void)
+{
+    int ret;
+
+    if (0 == my_info.data_len) {
+        RETURN_ERROR_STR("Symmetric data segment is not in shared memory");
+        return 1;
+    }
+
+    if (0 == my_info.heap_len) {
+        RETURN_ERROR_MSG("Symmetric heap is not in shared memory\n"
+                         RAISE_PE_PREFIX
+                         "Unset SHMEM_SYMMETRIC_HEAP_USE_MALLOC and SHMEM_SYMMETRIC_HEAP_USE_HUGE_PAGES\n",
+                         shmem_internal_my_pe);
+        shmem_transport_shm_fini();
+        return 1;
+    }
+
+    ret = shmem_runtime_put("shm-info", &my_info, sizeof(struct share_info_t));
+    if (0 != ret) {
+        RETURN_ERROR_MSG("runtime_put failed: %d\n", ret);
+        shmem_transport_shm_fini();
+        return 1;
+    }
+
+    return 0;
+}
+
+
+static void *
+shm_object_attach(const char *name, size_t len)
+{
+    void *ret;
+    int fd;
+    char errmsg[256];
+
+    fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) {
+        RETURN_ERROR_MSG("could not open %s: %s\n", name,
+                         shmem_util_strerror(errno, errmsg, 256));
+        return NULL;
+    }
+
+    ret = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (MAP_FAILED == ret) {
+        RETURN_ERROR_MSG("could not map %s: %s\n", name,
+                         shmem_util_strerror(errno, errmsg, 256));
+        return NULL;
+    }
+
+    return ret;
+}
+
+
+int
+shmem_transport_shm_startup(void)
+{
+    int ret, i, peer_num, num_on_node;
+    struct share_info_t info;
+    struct shmem_transport_shm_peer_info_t *peer;
+
+    num_on_node = shmem_runtime_get_node_size();
+
+    /* allocate space for local peers */
+    shmem_transport_shm_peers = calloc(num_on_node,
+                                       sizeof(struct shmem_transport_shm_peer_info_t));
+    if (NULL == shmem_transport_shm_peers) return 1;
+
+    /* get local peer info and map into our address space ... */
+    for (i = 0 ; i < shmem_internal_num_pes; ++i) {
+        peer_num = shmem_runtime_get_node_rank(i);
+        if (-1 == peer_num) continue;
+        peer = &shmem_transport_shm_peers[peer_num];
+
+        if (shmem_internal_my_pe == i) {
+            peer->data_ptr = shmem_internal_data_base;
+            peer->heap_ptr = shmem_internal_heap_base;
+        } else {
+            ret = shmem_runtime_get(i, "shm-info", &info, sizeof(struct share_info_t));
+            if (0 != ret) {
+                RETURN_ERROR_MSG("runtime_get failed: %d\n", ret);
+                return 1;
+            }
+
+            peer->data_attach_ptr = shm_object_attach(info.data_name, info.data_len);
+            if (NULL == peer->data_attach_ptr) return 1;
+            peer->data_attach_len = info.data_len;
+            peer->data_ptr = (char*) peer->data_attach_ptr + info.data_off;
+
+            peer->heap_attach_ptr = shm_object_attach(info.heap_name, info.heap_len);
+            if (NULL == peer->heap_attach_ptr) return 1;
+            peer->heap_attach_len = info.heap_len;
+            peer->heap_ptr = (char*) peer->heap_attach_ptr + info.heap_off;
+        }
+    }
+
+    /* Once every peer holds a mapping the names are no longer needed, and
+     * unlinking them now keeps an abnormal exit from leaking the objects */
+    shmem_runtime_barrier();
+    shm_unlink(my_info.data_name);
+    shm_unlink(my_info.heap_name);
+    my_names_unlinked = 1;
+
+    return 0;
+}
+
+
+int
+shmem_transport_shm_fini(void)
+{
+    int i;
+
+    if (NULL != shmem_transport_shm_peers) {
+        for (i = 0 ; i < shmem_runtime_get_node_size(); ++i) {
+            if (NULL != shmem_transport_shm_peers[i].data_attach_ptr) {
+                munmap(shmem_transport_shm_peers[i].data_attach_ptr,
+                       shmem_transport_shm_peers[i].data_attach_len);
+            }
+
+            if (NULL != shmem_transport_shm_peers[i].heap_attach_ptr) {
+                munmap(shmem_transport_shm_peers[i].heap_attach_ptr,
+                       shmem_transport_shm_peers[i].heap_attach_len);
+            }
+        }
+        free(shmem_transport_shm_peers);
+        shmem_transport_shm_peers = NULL;
+    }
+
+    if (!my_names_unlinked) {
+        if (0 != my_info.data_len) shm_unlink(my_info.data_name);
+        if (0 != my_info.heap_len) shm_unlink(my_info.heap_name);
+        my_names_unlinked = 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+/* -*- C -*-
+ *
+ * This file is part of the Sandia OpenSHMEM software package. For license
+ * information, see the LICENSE file in the top level directory of the
+ * distribution.
+ *
+ */
+
+#ifndef TRANSPORT_SHM_H
+#define TRANSPORT_SHM_H
+
+#include <string.h>
+#include <inttypes.h>
+
+/* The POSIX shared memory transport backs the symmetric heap with a shm_open
+ * object and moves the data segment into one at startup.  On-node peers map
+ * both objects, after which puts, gets, and AMOs are loads and stores, as
+ * with XPMEM, but without a kernel module. */
+
+struct shmem_transport_shm_peer_info_t {
+    void *data_attach_ptr;
+    void *heap_attach_ptr;
+    size_t data_attach_len;
+    size_t heap_attach_len;
+    void *data_ptr;
+    void *heap_ptr;
+};
+
+extern struct shmem_transport_shm_peer_info_t *shmem_transport_shm_peers;
+
+#ifdef ENABLE_ERROR_CHECKING
+#define SHM_GET_REMOTE_ACCESS(target, rank, ptr)                        \
+    do {                                                                \
+        if (((void*) target >= shmem_internal_data_base) &&             \
+            ((char*) target < (char*) shmem_internal_data_base + shmem_internal_data_length)) { \
+            ptr = (char*) target - (char*) shmem_internal_data_base +   \
+                (char*) shmem_transport_shm_peers[rank].data_ptr;       \
+        } else if (((void*) target >= shmem_internal_heap_base) &&      \
+                   ((char*) target < (char*) shmem_internal_heap_base + shmem_internal_heap_length)) { \
+            ptr = (char*) target - (char*) shmem_internal_heap_base +   \
+                (char*) shmem_transport_shm_peers[rank].heap_ptr;       \
+        } else {                                                        \
+            ptr = NULL;                                                 \
+        }                                                               \
+    } while (0)
+#else
+#define SHM_GET_REMOTE_ACCESS(target, rank, ptr)                        \
+    do {                                                                \
+        if ((void*) target < shmem_internal_heap_base) {                \
+            ptr = (char*) target - (char*) shmem_internal_data_base +   \
+                (char*) shmem_transport_shm_peers[rank].data_ptr;       \
+        } else {                                                        \
+            ptr = (char*) target - (char*) shmem_internal_heap_base +   \
+                (char*) shmem_transport_shm_peers[rank].heap_ptr;       \
+        }                                                               \
+    } while (0)
+#endif
+
+/* mmap() replacement for the symmetric heap allocator: maps a new shared
+ * memory object of len bytes at addr.  Called before the transport is
+ * initialized. */
+void *shmem_transport_shm_heap_map(void *addr, size_t len, int prot, int flags);
+
+/* Move the symmetric data segment into a shared memory object.  Must run
+ * before any other thread or transport holds on to the data segment. */
+int shmem_transport_shm_data_share(void);
+
+int shmem_transport_shm_init(void);
+
+int shmem_transport_shm_startup(void);
+
+int shmem_transport_shm_fini(void);
+
+
+static inline
+void *
+shmem_transport_shm_ptr(const void *target, int pe, int noderank)
+{
+    char *remote_ptr;
+
+    SHM_GET_REMOTE_ACCESS(target, noderank, remote_ptr);
+    return remote_ptr;
+}
+
+
+static inline
+void
+shmem_transport_shm_put(void *target, const void *source, size_t len,
+                        int pe, int noderank)
+{
+    char *remote_ptr;
+
+    SHM_GET_REMOTE_ACCESS(target, noderank, remote_ptr);
+#ifdef ENABLE_ERROR_CHECKING
+    if (NULL == remote_ptr) {
+        RAISE_ERROR_MSG("target (0x%"PRIXPTR") outside of symmetric areas\n",
+                        (uintptr_t) target);
+    }
+#endif
+
+    memcpy(remote_ptr, source, len);
+}
+
+
+static inline
+void
+shmem_transport_shm_get(void *target, const void *source, size_t len,
+                        int pe, int noderank)
+{
+    char *remote_ptr;
+
+    SHM_GET_REMOTE_ACCESS(source, noderank, remote_ptr);
+#ifdef ENABLE_ERROR_CHECKING
+    if (NULL == remote_ptr) {
+        RAISE_ERROR_MSG("source (0x%"PRIXPTR") outside of symmetric areas\n",
+                        (uintptr_t) source);
+    }
+#endif
+
+    memcpy(target, remote_ptr, len);
+}
+
+#endif
@@ -44,6 +44,7 @@ typedef int shmem_transport_ct_t;
 struct shmem_transport_ctx_t {
     long options;
     struct shmem_internal_team_t *team;
+    struct shmem_internal_agg_t *agg;
 };
 typedef struct shmem_transport_ctx_t shmem_transport_ctx_t;
 
@@ -179,6 +180,7 @@ shmem_transport_ctx_create(struct shmem_internal_team_t *team, long options, shm
         return 1;
 
     (*ctx)->team = team;
+    (*ctx)->agg = NULL;
     (*ctx)->options = 0;
 
     return 0;
@@ -216,7 +218,7 @@ shmem_transport_fence(shmem_transport_ctx_t* ctx)
 {
     ucs_status_t status;
 
-#if defined(USE_CMA) || (defined(USE_XPMEM) && !defined(USE_SHR_ATOMICS))
+#if defined(USE_CMA) || ((defined(USE_XPMEM) || defined(USE_SHM)) && !defined(USE_SHR_ATOMICS))
     /* Put/get use shared memory and atomics use UCX. Flush to resolve a race
      * across transports. */
     status = ucp_worker_flush(shmem_transport_ucp_worker);
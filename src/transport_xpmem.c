@@ -37,7 +37,13 @@ struct share_info_t {
 };
 
 struct shmem_transport_xpmem_peer_info_t *shmem_transport_xpmem_peers = NULL;
+unsigned long shmem_transport_xpmem_clock = 0;
+int shmem_transport_xpmem_evict = 0;
 static struct share_info_t my_info;
+static long num_attached = 0;
+#ifdef ENABLE_THREADS
+static shmem_internal_mutex_t attach_lock;
+#endif
 
 #define FIND_BASE(ptr, page_size) ((char*) (((uintptr_t) ptr / page_size) * page_size))
 #define FIND_LEN(ptr, len, page_size) ((((char*) ptr - FIND_BASE(ptr, page_size) + len - 1) / \
@@ -52,6 +58,13 @@ shmem_transport_xpmem_init(void)
     int ret;
     char errmsg[256];
 
+    SHMEM_MUTEX_INIT(attach_lock);
+
+    /* Another thread may be using any attached segment, so the cache is only
+     * bounded when a single thread at a time calls into the library */
+    shmem_transport_xpmem_evict = shmem_internal_params.XPMEM_ATTACH_CACHE_SIZE > 0 &&
+                                  shmem_internal_thread_level != SHMEM_THREAD_MULTIPLE;
+
     /* setup data region */
     base = FIND_BASE(shmem_internal_data_base, page_size);
     len = FIND_LEN(shmem_internal_data_base, shmem_internal_data_length, page_size);
@@ -86,13 +99,85 @@ shmem_transport_xpmem_init(void)
 }
 
 
+/* Detaches the least recently used segment that may be detached.  Returns
+ * nonzero if there was none. */
+static int
+xpmem_evict_lru(void)
+{
+    struct shmem_transport_xpmem_seg_t *lru = NULL;
+    int i, j;
+
+    /* This PE's own segments are pinned */
+    for (i = 0 ; i < shmem_runtime_get_node_size() ; ++i) {
+        for (j = 0 ; j < XPMEM_SEG_NUM ; ++j) {
+            struct shmem_transport_xpmem_seg_t *seg = &shmem_transport_xpmem_peers[i].seg[j];
+
+            if (NULL == seg->ptr || seg->pinned) continue;
+            if (NULL == lru || seg->last_use < lru->last_use) lru = seg;
+        }
+    }
+
+    if (NULL == lru) return 1;
+
+    lru->ptr = NULL;
+    xpmem_detach(lru->attach_ptr);
+    lru->attach_ptr = NULL;
+    num_attached--;
+
+    return 0;
+}
+
+
+void
+shmem_transport_xpmem_attach(int rank, int seg_idx)
+{
+    struct shmem_transport_xpmem_seg_t *seg = &shmem_transport_xpmem_peers[rank].seg[seg_idx];
+    struct xpmem_addr addr;
+    char errmsg[256];
+
+    SHMEM_MUTEX_LOCK(attach_lock);
+
+    if (NULL != seg->ptr) goto done;
+
+    if (shmem_transport_xpmem_evict) {
+        while (num_attached >= shmem_internal_params.XPMEM_ATTACH_CACHE_SIZE) {
+            if (xpmem_evict_lru()) break;
+        }
+    }
+
+    if (0 == seg->apid) {
+        seg->apid = xpmem_get(seg->segid, XPMEM_RDWR, XPMEM_PERMIT_MODE, (void*)0666);
+        if (seg->apid < 0) {
+            RAISE_ERROR_MSG("could not get %s apid: %s\n",
+                            (XPMEM_SEG_DATA == seg_idx) ? "data" : "heap",
+                            shmem_util_strerror(errno, errmsg, 256));
+        }
+    }
+
+    addr.apid = seg->apid;
+    addr.offset = 0;
+
+    seg->attach_ptr = xpmem_attach(addr, seg->len, NULL);
+    if ((void*) -1 == seg->attach_ptr) {
+        RAISE_ERROR_MSG("could not attach %s segment: %s\n",
+                        (XPMEM_SEG_DATA == seg_idx) ? "data" : "heap",
+                        shmem_util_strerror(errno, errmsg, 256));
+    }
+    num_attached++;
+
+    seg->ptr = (char*) seg->attach_ptr + seg->off;
+
+ done:
+    SHMEM_MUTEX_UNLOCK(attach_lock);
+}
+
+
 int
 shmem_transport_xpmem_startup(void)
 {
     int ret, i, peer_num, num_on_node;
-    char errmsg[256];
     struct share_info_t info;
-    struct xpmem_addr addr;
+    struct shmem_transport_xpmem_peer_info_t *peer;
 
     num_on_node = shmem_runtime_get_node_size();
 
@@ -101,16 +186,17 @@ shmem_transport_xpmem_startup(void)
                                          sizeof(struct shmem_transport_xpmem_peer_info_t));
     if (NULL == shmem_transport_xpmem_peers) return 1;
 
-    /* get local peer info and map into our address space ... */
+    /* get local peer info; segments are attached on first use */
     for (i = 0 ; i < shmem_internal_num_pes; ++i) {
         peer_num = shmem_runtime_get_node_rank(i);
         if (-1 == peer_num) continue;
+        peer = &shmem_transport_xpmem_peers[peer_num];
 
         if (shmem_internal_my_pe == i) {
-            shmem_transport_xpmem_peers[peer_num].data_ptr =
-                shmem_internal_data_base;
-            shmem_transport_xpmem_peers[peer_num].heap_ptr =
-                shmem_internal_heap_base;
+            peer->seg[XPMEM_SEG_DATA].ptr = shmem_internal_data_base;
+            peer->seg[XPMEM_SEG_HEAP].ptr = shmem_internal_heap_base;
+            peer->seg[XPMEM_SEG_DATA].pinned = 1;
+            peer->seg[XPMEM_SEG_HEAP].pinned = 1;
         } else {
             ret = shmem_runtime_get(i, "xpmem-segids", &info, sizeof(struct share_info_t));
             if (0 != ret) {
@@ -118,47 +204,12 @@ shmem_transport_xpmem_startup(void)
                 return 1;
             }
 
-            shmem_transport_xpmem_peers[peer_num].data_apid =
-                xpmem_get(info.data_seg, XPMEM_RDWR, XPMEM_PERMIT_MODE, (void*)0666);
-            if (shmem_transport_xpmem_peers[peer_num].data_apid < 0) {
-                RETURN_ERROR_MSG("could not get data apid: %s\n",
-                                 shmem_util_strerror(errno, errmsg, 256));
-                return 1;
-            }
-
-            addr.apid = shmem_transport_xpmem_peers[peer_num].data_apid;
-            addr.offset = 0;
-
-            shmem_transport_xpmem_peers[peer_num].data_attach_ptr =
-                xpmem_attach(addr, info.data_len, NULL);
-            if ((size_t) shmem_transport_xpmem_peers[peer_num].data_ptr == XPMEM_MAXADDR_SIZE) {
-                RETURN_ERROR_MSG("could not get data segment: %s\n",
-                                 shmem_util_strerror(errno, errmsg, 256));
-                return 1;
-            }
-            shmem_transport_xpmem_peers[peer_num].data_ptr =
-                (char*) shmem_transport_xpmem_peers[peer_num].data_attach_ptr + info.data_off;
-
-            shmem_transport_xpmem_peers[peer_num].heap_apid =
-                xpmem_get(info.heap_seg, XPMEM_RDWR, XPMEM_PERMIT_MODE, (void*)0666);
-            if (shmem_transport_xpmem_peers[peer_num].heap_apid < 0) {
-                RETURN_ERROR_MSG("could not get heap apid: %s\n",
-                                 shmem_util_strerror(errno, errmsg, 256));
-                return 1;
-            }
-
-            addr.apid = shmem_transport_xpmem_peers[peer_num].heap_apid;
-            addr.offset = 0;
-
-            shmem_transport_xpmem_peers[peer_num].heap_attach_ptr =
-                xpmem_attach(addr, info.heap_len, NULL);
-            if ((size_t) shmem_transport_xpmem_peers[peer_num].heap_ptr == XPMEM_MAXADDR_SIZE) {
-                RETURN_ERROR_MSG("could not get data segment: %s\n",
-                                 shmem_util_strerror(errno, errmsg, 256));
-                return 1;
-            }
-            shmem_transport_xpmem_peers[peer_num].heap_ptr =
-                (char*) shmem_transport_xpmem_peers[peer_num].heap_attach_ptr + info.heap_off;
+            peer->seg[XPMEM_SEG_DATA].segid = info.data_seg;
+            peer->seg[XPMEM_SEG_DATA].len   = info.data_len;
+            peer->seg[XPMEM_SEG_DATA].off   = info.data_off;
+            peer->seg[XPMEM_SEG_HEAP].segid = info.heap_seg;
+            peer->seg[XPMEM_SEG_HEAP].len   = info.heap_len;
+            peer->seg[XPMEM_SEG_HEAP].off   = info.heap_off;
         }
     }
 
@@ -169,33 +220,28 @@ shmem_transport_xpmem_startup(void)
 int
 shmem_transport_xpmem_fini(void)
 {
-    int i, peer_num;
+    int i, j;
 
     if (NULL != shmem_transport_xpmem_peers) {
-        for (i = 0 ; i < shmem_internal_num_pes; ++i) {
-            peer_num = shmem_runtime_get_node_rank(i);
-            if (-1 == peer_num) continue;
-            if (shmem_internal_my_pe == i) continue;
+        for (i = 0 ; i < shmem_runtime_get_node_size(); ++i) {
+            for (j = 0 ; j < XPMEM_SEG_NUM ; ++j) {
+                struct shmem_transport_xpmem_seg_t *seg = &shmem_transport_xpmem_peers[i].seg[j];
 
-            if (NULL != shmem_transport_xpmem_peers[peer_num].data_ptr) {
-                xpmem_detach(shmem_transport_xpmem_peers[peer_num].data_attach_ptr);
-            }
+                if (NULL != seg->attach_ptr) {
+                    xpmem_detach(seg->attach_ptr);
+                }
 
-            if (0 != shmem_transport_xpmem_peers[peer_num].data_apid) {
-                xpmem_release(shmem_transport_xpmem_peers[peer_num].data_apid);
-            }
-
-            if (NULL != shmem_transport_xpmem_peers[peer_num].heap_ptr) {
-                xpmem_detach(shmem_transport_xpmem_peers[peer_num].heap_attach_ptr);
-            }
-
-            if (0 != shmem_transport_xpmem_peers[peer_num].heap_apid) {
-                xpmem_release(shmem_transport_xpmem_peers[peer_num].heap_apid);
+                if (0 != seg->apid) {
+                    xpmem_release(seg->apid);
+                }
             }
         }
         free(shmem_transport_xpmem_peers);
+        shmem_transport_xpmem_peers = NULL;
     }
 
+    SHMEM_MUTEX_DESTROY(attach_lock);
+
     if (0 != my_info.data_seg) {
         xpmem_remove(my_info.data_seg);
     }
@@ -205,4 +251,3 @@ shmem_transport_xpmem_fini(void)
 
     return 0;
 }
-
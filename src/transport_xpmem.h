@@ -20,28 +20,66 @@
 #include <inttypes.h>
 #include <xpmem.h>
 
+/* Peer segments are attached on first use, through
+ * shmem_transport_xpmem_attach().  When SHMEM_XPMEM_ATTACH_CACHE_SIZE is
+ * set, attaching beyond that many segments detaches the least recently used
+ * one, unless it was handed out by shmem_ptr. */
+enum shmem_transport_xpmem_seg_idx_t {
+    XPMEM_SEG_DATA = 0,
+    XPMEM_SEG_HEAP,
+    XPMEM_SEG_NUM
+};
+
+struct shmem_transport_xpmem_seg_t {
+    xpmem_segid_t segid;
+    size_t len;
+    size_t off;
+    xpmem_apid_t apid;
+    void *attach_ptr;
+    void *ptr;                  /* NULL while not attached */
+    unsigned long last_use;     /* Only maintained when segments can be evicted */
+    int pinned;
+};
+
 struct shmem_transport_xpmem_peer_info_t {
-    xpmem_apid_t data_apid;
-    xpmem_apid_t heap_apid;
-    void *data_attach_ptr;
-    void *heap_attach_ptr;
-    void *data_ptr;
-    void *heap_ptr;
+    struct shmem_transport_xpmem_seg_t seg[XPMEM_SEG_NUM];
 };
 
 extern struct shmem_transport_xpmem_peer_info_t *shmem_transport_xpmem_peers;
+extern unsigned long shmem_transport_xpmem_clock;
+extern int shmem_transport_xpmem_evict;
+
+void shmem_transport_xpmem_attach(int rank, int seg_idx);
+
+static inline
+char *
+shmem_transport_xpmem_seg_ptr(int rank, int seg_idx)
+{
+    struct shmem_transport_xpmem_seg_t *seg =
+        &shmem_transport_xpmem_peers[rank].seg[seg_idx];
+
+    if (NULL == seg->ptr)
+        shmem_transport_xpmem_attach(rank, seg_idx);
+
+    /* Eviction is disabled with SHMEM_THREAD_MULTIPLE, so the clock is only
+     * updated by one thread at a time */
+    if (shmem_transport_xpmem_evict)
+        seg->last_use = ++shmem_transport_xpmem_clock;
+
+    return (char*) seg->ptr;
+}
 
 #ifdef ENABLE_ERROR_CHECKING
 #define XPMEM_GET_REMOTE_ACCESS(target, rank, ptr)                      \
     do {                                                                \
-        if (((void*) target > shmem_internal_data_base) &&              \
+        if (((void*) target >= shmem_internal_data_base) &&             \
             ((char*) target < (char*) shmem_internal_data_base + shmem_internal_data_length)) { \
             ptr = (char*) target - (char*) shmem_internal_data_base +   \
-                (char*) shmem_transport_xpmem_peers[rank].data_ptr;     \
-        } else if (((void*) target > shmem_internal_heap_base) &&       \
+                shmem_transport_xpmem_seg_ptr(rank, XPMEM_SEG_DATA);    \
+        } else if (((void*) target >= shmem_internal_heap_base) &&      \
                    ((char*) target < (char*) shmem_internal_heap_base + shmem_internal_heap_length)) { \
             ptr = (char*) target - (char*) shmem_internal_heap_base +   \
-                (char*) shmem_transport_xpmem_peers[rank].heap_ptr;     \
+                shmem_transport_xpmem_seg_ptr(rank, XPMEM_SEG_HEAP);    \
         } else {                                                        \
             ptr = NULL;                                                 \
         }                                                               \
@@ -51,10 +89,10 @@ extern struct shmem_transport_xpmem_peer_info_t *shmem_transport_xpmem_peers;
     do {                                                                \
         if ((void*) target < shmem_internal_heap_base) {                \
             ptr = (char*) target - (char*) shmem_internal_data_base +   \
-                (char*) shmem_transport_xpmem_peers[rank].data_ptr;     \
+                shmem_transport_xpmem_seg_ptr(rank, XPMEM_SEG_DATA);    \
         } else {                                                        \
             ptr = (char*) target - (char*) shmem_internal_heap_base +   \
-                (char*) shmem_transport_xpmem_peers[rank].heap_ptr;     \
+                shmem_transport_xpmem_seg_ptr(rank, XPMEM_SEG_HEAP);    \
         }                                                               \
     } while (0)
 #endif
@@ -71,8 +109,16 @@ void *
 shmem_transport_xpmem_ptr(const void *target, int pe, int noderank)
 {
     char *remote_ptr;
+    int seg_idx = ((void*) target < shmem_internal_heap_base) ?
+                  XPMEM_SEG_DATA : XPMEM_SEG_HEAP;
 
     XPMEM_GET_REMOTE_ACCESS(target, noderank, remote_ptr);
+
+    /* The caller may hold on to the pointer, so the segment must stay
+     * attached */
+    if (NULL != remote_ptr)
+        shmem_transport_xpmem_peers[noderank].seg[seg_idx].pinned = 1;
+
     return remote_ptr;
 }
 